@@ -0,0 +1,520 @@
+/*
+ * bench.c
+ *
+ * Copyright(C) 2026   MT
+ *
+ * Measures  how  quickly each of the programs runs on the same  generated
+ * files  every time, and compares the results with those saved from an
+ * earlier run so that any change that makes a program slower is noticed.
+ *
+ * The  files  are made from a fixed sequence of pseudo random numbers, so
+ * they  are the same on every machine, and are only made again if they
+ * are  missing or the wrong size.  Each program is run several times and
+ * the  quickest  run  is  used, reading  the  peak  memory  used  by  the
+ * program from the resource usage returned when it exits.
+ *
+ * Deliberatly avoids using 'getopt' or 'argparse' to maximize portability.
+ *
+ * This  program is free software: you can redistribute it and/or modify it
+ * under  the terms of the GNU General Public License as published  by  the
+ * Free  Software Foundation, either version 3 of the License, or (at  your
+ * option) any later version.
+ *
+ * This  program  is distributed in the hope that it will  be  useful,  but
+ * WITHOUT   ANY   WARRANTY;   without even   the   implied   warranty   of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You  should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * 18 Oct 26   0.1   - Initial version - MT
+ *
+ */
+
+#define  NAME        "gcc-bench"
+#define  VERSION     "0.1"
+#define  BUILD       "0001"
+#define  AUTHOR      "MT"
+#define  COPYRIGHT   (__DATE__ + 7) /* Extract copyright year from date */
+
+#define  BLOCK_SIZE  1048576                  /* Number of bytes written to a file at once */
+#define  SPARSE_GAP  1048576                  /* Distance between the blocks of data in a sparse file */
+#define  SPARSE_DATA 4096                     /* Size of each block of data in a sparse file */
+#define  RECORD_TEXT 44                       /* Characters in each generated record, with 16 data bytes */
+#define  SIZES_MAX   16                       /* Largest number of file sizes */
+#define  ENTRIES_MAX 1024                     /* Largest number of results in a baseline */
+#define  LINE_SIZE   256
+#define  SIZE_MAX_GB 4                        /* Largest file size */
+
+#define  RANDOM      0                        /* Kinds of file */
+#define  ZERO        1
+#define  SPARSE      2
+#define  TEXT        3
+#define  VALID       4
+#define  CORRUPT     5
+
+#define  false       0
+#define  true        !false
+
+#define  _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+typedef struct
+{
+   char *s_name; /* Name shown in the results */
+   char *s_program; /* Program to run */
+   char *a_options[4]; /* Options, ending with NULL */
+   int i_kind; /* Kind of file read */
+   int i_bytes; /* Input bytes for each record, or zero if records are not counted */
+} t_case;
+
+t_case a_cases[] = {
+   {"dump", "gcc-dump", {NULL}, RANDOM, 0},
+   {"dump-chars", "gcc-dump", {"-c", NULL}, TEXT, 0},
+   {"detab", "gcc-detab", {NULL}, TEXT, 0},
+   {"detab-utf8", "gcc-detab", {"-u", NULL}, TEXT, 0},
+   {"entab", "gcc-entab", {NULL}, TEXT, 0},
+   {"entab-c", "gcc-entab", {"-l", "c", NULL}, TEXT, 0},
+   {"unload", "gcc-unload", {NULL}, RANDOM, 16},
+   {"unload-jobs", "gcc-unload", {"-j", "4", NULL}, RANDOM, 16},
+   {"unload-srec", "gcc-unload", {"-s", NULL}, RANDOM, 16},
+   {"unload-c", "gcc-unload", {"-i", NULL}, RANDOM, 12},
+   {"unload-zero", "gcc-unload", {"-f", "0", NULL}, ZERO, 16},
+   {"unload-sparse", "gcc-unload", {"-f", "0", NULL}, SPARSE, 16},
+   {"load", "gcc-load", {NULL}, VALID, RECORD_TEXT},
+   {"load-corrupt", "gcc-load", {NULL}, CORRUPT, RECORD_TEXT},
+   {"rehex", "gcc-rehex", {NULL}, VALID, RECORD_TEXT},
+   {"rehex-corrupt", "gcc-rehex", {NULL}, CORRUPT, RECORD_TEXT},
+   {NULL}
+};
+
+char *a_kinds[] = {"random", "zero", "sparse", "text", "valid", "corrupt"};
+char *a_types[] = {"bin", "bin", "bin", "txt", "hex", "hex"};
+
+typedef struct
+{
+   char s_name[LINE_SIZE];
+   unsigned long long ull_size;
+   double d_speed; /* MB/s */
+} t_entry;
+
+t_entry a_baseline[ENTRIES_MAX];
+int i_baseline;
+unsigned long long ull_state; /* Pseudo random number generator */
+
+void v_error(const char *s_fmt, ...) /* Print formatted error message */
+{
+   va_list t_args;
+   va_start(t_args, s_fmt);
+   fprintf(stderr, "%s: ", NAME);
+   vfprintf(stderr, s_fmt, t_args);
+   va_end(t_args);
+}
+
+void v_version() /* Display version information */
+{
+   fprintf(stderr, "%s: Version %s\n", NAME, VERSION);
+   fprintf(stdout, "Copyright(C) %s %s\n", COPYRIGHT, AUTHOR);
+   fprintf(stdout, "License GPLv3+: GNU GPL version 3 or later <http://gnu.org/licenses/gpl.html>.\n");
+   fprintf(stdout, "This is free software: you are free to change and redistribute it.\n");
+   fprintf(stdout, "There is NO WARRANTY, to the extent permitted by law.\n");
+   exit(0);
+}
+
+void v_about() /* Display help text */
+{
+   fprintf(stdout, "Usage: %s [OPTION]...\n", NAME);
+   fprintf(stdout, "Times each of the programs on generated files and compares the results with a baseline.\n\n");
+   fprintf(stdout, "  -b, --baseline FILE      compare the results with FILE\n");
+   fprintf(stdout, "  -d, --directory DIR      keep the generated files in DIR (default bench/corpus)\n");
+   fprintf(stdout, "  -p, --programs DIR       run the programs in DIR (default .)\n");
+   fprintf(stdout, "  -r, --runs N             use the quickest of N runs (default 3)\n");
+   fprintf(stdout, "  -s, --sizes N[,N]...     sizes of the files, from 1K to 4G (default 1K,1M,64M)\n");
+   fprintf(stdout, "  -t, --tolerance N        report results more than N%% slower (default 10)\n");
+   fprintf(stdout, "  -w, --write FILE         save the results in FILE as a new baseline\n");
+   fprintf(stdout, "  -?, --help               display this help and exit\n");
+   fprintf(stdout, "      --version            output version information and exit\n");
+   exit(0);
+}
+
+unsigned long long ull_random() /* Next pseudo random number (xorshift64*) */
+{
+   ull_state ^= ull_state >> 12;
+   ull_state ^= ull_state << 25;
+   ull_state ^= ull_state >> 27;
+   return ull_state * 0x2545F4914F6CDD1DULL;
+}
+
+unsigned long long ull_size(char *s_size) /* Convert a size such as 64K, 16M or 4G, returns zero if it isn't valid */
+{
+   unsigned long long ull_value;
+   char *s_end;
+
+   errno = 0;
+   ull_value = strtoull(s_size, &s_end, 10);
+   switch (*s_end)
+   {
+   case 'k': case 'K': ull_value <<= 10; s_end++; break;
+   case 'm': case 'M': ull_value <<= 20; s_end++; break;
+   case 'g': case 'G': ull_value <<= 30; s_end++; break;
+   }
+   if (errno || *s_end || ull_value < 1024 || ull_value > ((unsigned long long) SIZE_MAX_GB << 30)) return 0;
+   return ull_value;
+}
+
+char *s_size(char *s_buffer, unsigned long long ull_value) /* Describe a size as briefly as possible */
+{
+   if (ull_value >= (1ULL << 30) && !(ull_value & ((1ULL << 30) - 1)))
+      sprintf(s_buffer, "%lluG", ull_value >> 30);
+   else if (ull_value >= (1ULL << 20) && !(ull_value & ((1ULL << 20) - 1)))
+      sprintf(s_buffer, "%lluM", ull_value >> 20);
+   else if (ull_value >= (1ULL << 10) && !(ull_value & ((1ULL << 10) - 1)))
+      sprintf(s_buffer, "%lluK", ull_value >> 10);
+   else
+      sprintf(s_buffer, "%llu", ull_value);
+   return s_buffer;
+}
+
+int i_text(char *s_output, int i_room) /* Make a line of source code with some leading tabs and spaces, returns its length */
+{
+   static const char *a_words[] = {"int", "i_count", "=", "0;", "if", "(p_data", "!=", "NULL)", "return", "/*", "comment", "*/", "\"a  b\"", "x\ty", "\xc3\xa9t\xc3\xa9"};
+   int i_length = 0, i_words, i_word;
+
+   i_length += ull_random() % 3; /* Indent with tabs, spaces or both */
+   memset(s_output, '\t', i_length);
+   i_word = ull_random() % 9;
+   memset(s_output + i_length, ' ', i_word);
+   i_length += i_word;
+   for (i_words = ull_random() % 8; i_words > 0; i_words--)
+   {
+      i_word = ull_random() % (sizeof(a_words) / sizeof(a_words[0]));
+      if (i_length + strlen(a_words[i_word]) + 8 >= i_room) break;
+      i_length += sprintf(s_output + i_length, "%s%s", a_words[i_word], (ull_random() % 4) ? " " : "     ");
+   }
+   s_output[i_length++] = '\n';
+   return i_length;
+}
+
+int i_record(char *s_output, unsigned long ul_address, int b_corrupt) /* Make an Intel Hex record holding 16 random bytes, returns its length */
+{
+   static const char *s_digits = "0123456789ABCDEF";
+   unsigned char a_bytes[21];
+   int i_count, i_sum = 0;
+
+   a_bytes[0] = 16;
+   a_bytes[1] = (ul_address >> 8) & 0xFF;
+   a_bytes[2] = ul_address & 0xFF;
+   a_bytes[3] = 0;
+   for (i_count = 4; i_count < 20; i_count++) a_bytes[i_count] = ull_random();
+   for (i_count = 0; i_count < 20; i_count++) i_sum += a_bytes[i_count];
+   a_bytes[20] = (~(i_sum & 0xFF) + 1) & 0xFF;
+   s_output[0] = ':';
+   for (i_count = 0; i_count < 21; i_count++)
+   {
+      s_output[1 + 2 * i_count] = s_digits[a_bytes[i_count] >> 4];
+      s_output[2 + 2 * i_count] = s_digits[a_bytes[i_count] & 0x0F];
+   }
+   s_output[43] = '\n';
+   if (b_corrupt && !(ull_random() % 64)) /* Damage about one record in sixty four */
+   {
+      switch (ull_random() % 3)
+      {
+      case 0: s_output[9 + ull_random() % 32] ^= 0x01; break; /* Wrong checksum */
+      case 1: s_output[1 + ull_random() % 42] = 'G'; break; /* Not a digit */
+      case 2: s_output[20] = '\n'; break; /* Short record */
+      }
+   }
+   return RECORD_TEXT;
+}
+
+int i_generate(char *s_path, int i_kind, unsigned long long ull_length) /* Make a file unless it already exists, returns false if there was an error */
+{
+   struct stat t_file_d;
+   unsigned long long ull_done = 0;
+   unsigned long ul_address = 0;
+   size_t i_block, i_count;
+   char *s_block;
+   int h_file;
+
+   if (!stat(s_path, &t_file_d) && (unsigned long long) t_file_d.st_size == ull_length) return true;
+   if ((h_file = open(s_path, O_WRONLY | O_CREAT | O_TRUNC, 0666)) < 0) return false;
+   if ((s_block = malloc(BLOCK_SIZE + LINE_SIZE)) == NULL)
+   {
+      v_error("Cannot allocate memory: %s\n", strerror(errno));
+      exit(-1);
+   }
+   fprintf(stderr, "Generating %s\n", s_path);
+   ull_state = 0x9E3779B97F4A7C15ULL + i_kind; /* The same files every time */
+   while (ull_done < ull_length)
+   {
+      i_block = 0;
+      switch (i_kind)
+      {
+      case RANDOM:
+         for (; i_block + 8 <= BLOCK_SIZE; i_block += 8)
+         {
+            unsigned long long ull_value = ull_random();
+            memcpy(s_block + i_block, &ull_value, 8);
+         }
+         break;
+      case ZERO:
+         memset(s_block, 0, i_block = BLOCK_SIZE);
+         break;
+      case SPARSE: /* A block of data at the start of every gap, leaving holes in between */
+         for (; i_block + 8 <= SPARSE_DATA; i_block += 8)
+         {
+            unsigned long long ull_value = ull_random();
+            memcpy(s_block + i_block, &ull_value, 8);
+         }
+         break;
+      case TEXT:
+         while (i_block < BLOCK_SIZE)
+            i_block += i_text(s_block + i_block, LINE_SIZE);
+         break;
+      case VALID:
+      case CORRUPT:
+         for (; i_block < BLOCK_SIZE; ul_address += 16)
+            i_block += i_record(s_block + i_block, ul_address, i_kind == CORRUPT);
+         break;
+      }
+      if (i_block > ull_length - ull_done) i_block = ull_length - ull_done;
+      if ((i_kind == VALID || i_kind == CORRUPT) && ull_done + i_block == ull_length && i_block >= 12) /* End with an end of file record */
+      {
+         i_count = (i_block - 12) / RECORD_TEXT * RECORD_TEXT; /* Blank out any part of a record before it */
+         if (i_count < i_block - 12)
+         {
+            memset(s_block + i_count, ' ', i_block - 12 - i_count);
+            s_block[i_block - 13] = '\n';
+         }
+         memcpy(s_block + i_block - 12, ":00000001FF\n", 12);
+      }
+      for (i_count = 0; i_count < i_block; )
+      {
+         ssize_t i_written = pwrite(h_file, s_block + i_count, i_block - i_count, ull_done + i_count);
+         if (i_written < 0)
+         {
+            free(s_block);
+            close(h_file);
+            return false;
+         }
+         i_count += i_written;
+      }
+      ull_done += (i_kind == SPARSE) ? SPARSE_GAP : i_block;
+   }
+   if (ftruncate(h_file, ull_length)) /* Sparse files end with a hole */
+   {
+      free(s_block);
+      close(h_file);
+      return false;
+   }
+   free(s_block);
+   return !close(h_file);
+}
+
+double d_now() /* Monotonic time in seconds */
+{
+   struct timespec t_time;
+
+   clock_gettime(CLOCK_MONOTONIC, &t_time);
+   return t_time.tv_sec + t_time.tv_nsec / 1e9;
+}
+
+int i_time(char *s_programs, t_case *p_case, char *s_input, double *d_seconds, long *l_peak) /* Run a program once, returns false if it failed */
+{
+   char s_path[LINE_SIZE];
+   char *a_args[8];
+   struct rusage t_usage;
+   double d_start;
+   pid_t t_child;
+   int i_status, i_count, h_null;
+
+   snprintf(s_path, sizeof(s_path), "%s/%s", s_programs, p_case->s_program);
+   a_args[0] = s_path;
+   for (i_count = 0; p_case->a_options[i_count] != NULL; i_count++) a_args[i_count + 1] = p_case->a_options[i_count];
+   a_args[i_count + 1] = s_input;
+   a_args[i_count + 2] = NULL;
+   d_start = d_now();
+   if ((t_child = fork()) < 0) return false;
+   if (t_child == 0)
+   {
+      if ((h_null = open("/dev/null", O_WRONLY)) >= 0) /* Only the time taken matters */
+      {
+         dup2(h_null, 1);
+         dup2(h_null, 2); /* Corrupt records are meant to produce a lot of errors */
+      }
+      execv(s_path, a_args);
+      _exit(127);
+   }
+   while (wait4(t_child, &i_status, 0, &t_usage) < 0)
+      if (errno != EINTR) return false;
+   *d_seconds = d_now() - d_start;
+   *l_peak = t_usage.ru_maxrss; /* Kilobytes on Linux and the BSDs */
+   return (WIFEXITED(i_status) && WEXITSTATUS(i_status) != 127);
+}
+
+void v_read_baseline(char *s_name) /* Read the results saved from an earlier run */
+{
+   char s_line[LINE_SIZE];
+   FILE *h_file;
+   t_entry *p_entry;
+
+   if ((h_file = fopen(s_name, "r")) == NULL)
+   {
+      v_error("Cannot open %s: %s\n", s_name, strerror(errno));
+      return;
+   }
+   while (fgets(s_line, sizeof(s_line), h_file) != NULL && i_baseline < ENTRIES_MAX)
+   {
+      p_entry = &a_baseline[i_baseline];
+      if (s_line[0] != '#' && sscanf(s_line, "%255s %llu %lf", p_entry->s_name, &p_entry->ull_size, &p_entry->d_speed) == 3)
+         i_baseline++;
+   }
+   fclose(h_file);
+}
+
+t_entry *p_find(char *s_name, unsigned long long ull_size) /* Return the baseline result for a case, or NULL */
+{
+   int i_count;
+
+   for (i_count = 0; i_count < i_baseline; i_count++)
+      if (!strcmp(a_baseline[i_count].s_name, s_name) && a_baseline[i_count].ull_size == ull_size) return &a_baseline[i_count];
+   return NULL;
+}
+
+int main(int argc, char **argv)
+{
+   char *s_directory = "bench/corpus", *s_programs = ".", *s_sizes = "1K,1M,64M", *s_compare = NULL, *s_save = NULL;
+   char s_input[LINE_SIZE], s_name[LINE_SIZE], s_label[LINE_SIZE], s_text[LINE_SIZE], s_change[LINE_SIZE];
+   unsigned long long a_sizes[SIZES_MAX];
+   double d_seconds, d_best, d_speed;
+   long l_peak, l_most;
+   int i_sizes = 0, i_runs = 3, i_tolerance = 10, i_slower = 0, i_failed = 0;
+   int i_count, i_size, i_run, i_length;
+   t_case *p_case;
+   t_entry *p_entry;
+   FILE *h_save = NULL;
+   char *s_size_arg;
+
+   for (i_count = 1; i_count < argc; i_count++)
+   {
+      i_length = strlen(argv[i_count]);
+      if (argv[i_count][0] != '-')
+      {
+         v_error("unexpected argument %s\nTry '%s --help' for more information.\n", argv[i_count], NAME);
+         exit(-1);
+      }
+      if (!strcmp(argv[i_count], "-?") || (i_length > 2 && !strncmp(argv[i_count], "--help", i_length)))
+         v_about();
+      if (i_length > 2 && !strncmp(argv[i_count], "--version", i_length))
+         v_version();
+      if (i_count + 1 >= argc)
+      {
+         v_error("option requires an argument -- %s\n", argv[i_count]);
+         exit(-1);
+      }
+      if (!strcmp(argv[i_count], "-b") || (i_length > 2 && !strncmp(argv[i_count], "--baseline", i_length)))
+         s_compare = argv[++i_count];
+      else if (!strcmp(argv[i_count], "-d") || (i_length > 2 && !strncmp(argv[i_count], "--directory", i_length)))
+         s_directory = argv[++i_count];
+      else if (!strcmp(argv[i_count], "-p") || (i_length > 2 && !strncmp(argv[i_count], "--programs", i_length)))
+         s_programs = argv[++i_count];
+      else if (!strcmp(argv[i_count], "-r") || (i_length > 2 && !strncmp(argv[i_count], "--runs", i_length)))
+         i_runs = atoi(argv[++i_count]);
+      else if (!strcmp(argv[i_count], "-s") || (i_length > 2 && !strncmp(argv[i_count], "--sizes", i_length)))
+         s_sizes = argv[++i_count];
+      else if (!strcmp(argv[i_count], "-t") || (i_length > 2 && !strncmp(argv[i_count], "--tolerance", i_length)))
+         i_tolerance = atoi(argv[++i_count]);
+      else if (!strcmp(argv[i_count], "-w") || (i_length > 2 && !strncmp(argv[i_count], "--write", i_length)))
+         s_save = argv[++i_count];
+      else
+      {
+         v_error("invalid option %s\nTry '%s --help' for more information.\n", argv[i_count], NAME);
+         exit(-1);
+      }
+   }
+   if (i_runs < 1 || i_tolerance < 0)
+   {
+      v_error("invalid number of runs or tolerance\n");
+      exit(-1);
+   }
+   for (s_size_arg = strtok(s_sizes, ","); s_size_arg != NULL && i_sizes < SIZES_MAX; s_size_arg = strtok(NULL, ","))
+      if ((a_sizes[i_sizes++] = ull_size(s_size_arg)) == 0)
+      {
+         v_error("invalid size %s, must be between 1K and %dG\n", s_size_arg, SIZE_MAX_GB);
+         exit(-1);
+      }
+   mkdir(s_directory, 0777);
+   if (s_compare != NULL) v_read_baseline(s_compare);
+   if (s_save != NULL)
+   {
+      if ((h_save = fopen(s_save, "w")) == NULL)
+      {
+         v_error("Cannot open %s: %s\n", s_save, strerror(errno));
+         exit(-1);
+      }
+      fprintf(h_save, "# %s %s - case size MB/s\n", NAME, BUILD);
+   }
+
+   fprintf(stdout, "%-16s %5s %10s %12s %10s %10s %8s\n", "Case", "Size", "MB/s", "Records/s", "Peak KB", "Baseline", "Change");
+   for (i_size = 0; i_size < i_sizes; i_size++)
+   {
+      for (p_case = a_cases; p_case->s_name != NULL; p_case++)
+      {
+         snprintf(s_input, sizeof(s_input), "%s/%s-%s.%s", s_directory, a_kinds[p_case->i_kind], s_size(s_label, a_sizes[i_size]), a_types[p_case->i_kind]);
+         if (!i_generate(s_input, p_case->i_kind, a_sizes[i_size]))
+         {
+            v_error("Cannot write %s: %s\n", s_input, strerror(errno));
+            exit(-1);
+         }
+         d_best = 0;
+         l_most = 0;
+         for (i_run = 0; i_run < i_runs; i_run++)
+         {
+            if (!i_time(s_programs, p_case, s_input, &d_seconds, &l_peak))
+            {
+               v_error("Cannot run %s/%s\n", s_programs, p_case->s_program);
+               i_failed++;
+               break;
+            }
+            if (!i_run || d_seconds < d_best) d_best = d_seconds;
+            if (l_peak > l_most) l_most = l_peak;
+         }
+         if (i_run < i_runs) continue;
+         if (d_best < 1e-6) d_best = 1e-6;
+         d_speed = a_sizes[i_size] / d_best / 1e6;
+         strcpy(s_text, "-");
+         if (p_case->i_bytes) sprintf(s_text, "%.0f", a_sizes[i_size] / p_case->i_bytes / d_best);
+         strcpy(s_name, "-");
+         strcpy(s_change, "-");
+         if ((p_entry = p_find(p_case->s_name, a_sizes[i_size])) != NULL && p_entry->d_speed > 0)
+         {
+            sprintf(s_name, "%.1f", p_entry->d_speed);
+            sprintf(s_change, "%+.1f%%", (d_speed - p_entry->d_speed) / p_entry->d_speed * 100);
+            if (d_speed < p_entry->d_speed * (100 - i_tolerance) / 100)
+            {
+               strcat(s_change, " slower");
+               i_slower++;
+            }
+         }
+         fprintf(stdout, "%-16s %5s %10.1f %12s %10ld %10s %8s\n", p_case->s_name, s_size(s_label, a_sizes[i_size]), d_speed, s_text, l_most, s_name, s_change);
+         fflush(stdout);
+         if (h_save != NULL) fprintf(h_save, "%s %llu %.1f\n", p_case->s_name, a_sizes[i_size], d_speed);
+      }
+   }
+   if (h_save != NULL && fclose(h_save)) v_error("Cannot write %s: %s\n", s_save, strerror(errno));
+   if (i_slower) fprintf(stdout, "\n%d result%s more than %d%% slower than the baseline\n", i_slower, i_slower > 1 ? "s" : "", i_tolerance);
+   exit((i_slower || i_failed) ? 1 : 0);
+}
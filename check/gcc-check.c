@@ -0,0 +1,2126 @@
+/*
+ * check.c
+ *
+ * Copyright(C) 2026   MT
+ *
+ * Compares  what  each program writes, and what the  library  that  reads
+ * and  writes  hexadecimal  records produces, with  the  output  of  simple
+ * reference  versions  of the same functions on randomly  generated  files
+ * and on files of awkward sizes.
+ *
+ * The  reference  functions are the original versions of  'v_dump_hex()'
+ * from  'dump' and 'unload', 'i_read_hex()' from 'load', and 'v_detab()'
+ * and  'v_entab()', which read a character or a record at a time and use
+ * printf().  They  have only been changed to read and write the files they
+ * are  given, so that every faster way the programs now have of doing  the
+ * same  thing  (large blocks, memory mapped files, threads, reusing unchanged
+ * records) can be shown to give exactly the same result.  The options added
+ * since  then,  and 'rehex' and 'hexd', are checked against separate  and
+ * equally simple functions, which are only used when an original can't be.
+ *
+ * Every  input  is  made from a sequence of pseudo random numbers that is
+ * started  from  the seed shown at the start,  so  a failure can be  seen
+ * again  by  giving the same seed.  The files used by a check that failed
+ * are left in the directory for a closer look.
+ *
+ * Deliberatly avoids using 'getopt' or 'argparse' to maximize portability.
+ *
+ * This  program is free software: you can redistribute it and/or modify it
+ * under  the terms of the GNU General Public License as published  by  the
+ * Free  Software Foundation, either version 3 of the License, or (at  your
+ * option) any later version.
+ *
+ * This  program  is distributed in the hope that it will  be  useful,  but
+ * WITHOUT   ANY   WARRANTY;   without even   the   implied   warranty   of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You  should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * 18 Oct 26   0.1   - Initial version - MT
+ *                   - Checks that '-c' never replaces a file, even with
+ *                     '-i', and returns the right status - MT
+ *                   - Reads the records written by 'unload' back with the
+ *                     library, which must find no errors - MT
+ *                   - Expects a wider 'S' end record for a start address
+ *                     above the image - MT
+ *                   - Expects a single element in the array for an empty
+ *                     file - MT
+ *                   - Keeps the original reference functions as they were,
+ *                     and also checks 'entab -l', UTF-8 characters, 'rehex',
+ *                     'hexd' and the number of errors found - MT
+ *                   - Puts a line of text that starts with an 'S' before
+ *                     some of the records read by 'rehex' - MT
+ *
+ */
+
+#define  NAME        "gcc-check"
+#define  VERSION     "0.1"
+#define  BUILD       "0005"
+#define  AUTHOR      "MT"
+#define  COPYRIGHT   (__DATE__ + 7) /* Extract copyright year from date */
+
+#define  DUMP_SIZE   16                       /* Bytes on each line written by 'dump' */
+#define  BUFFER_SIZE 16                       /* Bytes in each record written by the original 'unload' */
+#define  TAB_WIDTH   8                        /* Distance between the tab stops used by the original 'entab' */
+#define  LOAD_ADDRESS 0x0100                  /* Address of the first line written by 'dump' */
+#define  SOURCE_SIZE 12                       /* Default number of bytes on each line of a C array */
+#define  PIECE_SIZE  4194304                  /* Text files larger than this are split between threads */
+#define  CHUNK_SIZE  262144                   /* Files larger than this are formatted by several threads */
+#define  STOPS_MAX   8                        /* Largest number of tab stops in a generated list */
+#define  FILES_MAX   6                        /* Largest number of files given to a program at once */
+#define  ARGS_MAX    32                       /* Largest number of words in a command */
+#define  LINE_SIZE   256
+#define  TIME_LIMIT  120                      /* Seconds a program may run before it is stopped */
+#define  SERVER_WAIT 10                       /* Seconds to wait for 'hexd' to start listening */
+
+#define  BINARY      0                        /* Kinds of input */
+#define  SPARSE      1
+#define  TEXT        2
+#define  UTF8        3                        /* Text with some UTF-8 characters and no other bytes above 0x7F */
+#define  RECORDS     4
+#define  CODE        5                        /* Text that looks like C or assembler */
+#define  IMAGE       6                        /* Records for some bytes written with any of the options for 'unload' */
+
+#define  PLAIN       0                        /* How the input is given to a program */
+#define  FIFO        1                        /* Through a named pipe, so it can't be mapped or its size known */
+#define  SEVERAL     2                        /* Several files at once */
+#define  INPLACE     3                        /* Several files that are replaced */
+#define  DELTA       4                        /* Twice, changing the file in between */
+#define  ENCODE      5                        /* Library, a few bytes at a time */
+#define  FORMAT      6                        /* Library, a chunk at a time */
+#define  DECODE      7                        /* Library, a few characters at a time */
+#define  CHECK       8                        /* Several files that are checked but never replaced */
+#define  VERIFY      9                        /* Output read back by the library, which must load the same bytes */
+#define  SERVER      10                       /* Several files in requests to 'hexd', each written to its own output */
+
+#define  DUMP        0                        /* Reference used */
+#define  UNLOAD      1
+#define  LOAD        2
+#define  DETAB       3
+#define  ENTAB       4
+#define  REHEX       5
+
+#define  VARY_SIZE   0x01                     /* Options given a new random value for every input */
+#define  VARY_LOAD   0x02
+#define  VARY_FILL   0x04
+#define  VARY_START  0x08
+#define  VARY_TABS   0x10
+#define  VARY_LIST   0x20
+#define  VARY_FORMAT 0x40
+#define  VARY_LARGE  0x80                     /* The first input is large enough to be split between threads */
+#define  VARY_LENGTH 0x100
+#define  VARY_OFFSET 0x200
+
+#define  LANGUAGE_C  1                        /* Languages for 'entab -l' */
+#define  LANGUAGE_ASM 2
+
+#define  LEX_CODE    0                        /* Lexer states, spaces in any state from LEX_STRING onwards are left alone */
+#define  LEX_SLASH   1
+#define  LEX_STRING  2
+#define  LEX_S_ESC   3
+#define  LEX_CHAR    4
+#define  LEX_C_ESC   5
+#define  LEX_LINE    6
+#define  LEX_L_ESC   7
+#define  LEX_BLOCK   8
+#define  LEX_STAR    9
+
+#define  false       0
+#define  true        !false
+
+#define  _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>   /* isprint */
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "gcc-hex.h"
+
+typedef struct
+{
+   char *s_name; /* Name shown in the results */
+   char *s_program; /* Program to run, or NULL to call the library */
+   char *a_options[4]; /* Options, ending with NULL */
+   int i_kind; /* Kind of input */
+   int i_method; /* How the input is given to the program */
+   int i_reference; /* Reference function that gives the expected output */
+   int i_vary; /* Options that change for every input */
+} t_case;
+
+t_case a_cases[] = {
+   {"dump", "gcc-dump", {NULL}, BINARY, PLAIN, DUMP, 0},
+   {"dump-ascii", "gcc-dump", {"-a", NULL}, BINARY, PLAIN, DUMP, 0},
+   {"dump-octal", "gcc-dump", {"-b", "-c", NULL}, BINARY, PLAIN, DUMP, 0},
+   {"dump-fifo", "gcc-dump", {"-a", NULL}, BINARY, FIFO, DUMP, 0},
+   {"dump-files", "gcc-dump", {"-c", NULL}, BINARY, SEVERAL, DUMP, 0},
+   {"detab", "gcc-detab", {NULL}, TEXT, PLAIN, DETAB, 0},
+   {"detab-tabs", "gcc-detab", {NULL}, TEXT, PLAIN, DETAB, VARY_TABS},
+   {"detab-list", "gcc-detab", {NULL}, TEXT, PLAIN, DETAB, VARY_LIST},
+   {"detab-utf8", "gcc-detab", {"-u", NULL}, UTF8, PLAIN, DETAB, VARY_TABS},
+   {"detab-utf8-list", "gcc-detab", {"-u", NULL}, UTF8, PLAIN, DETAB, VARY_LIST},
+   {"detab-fifo", "gcc-detab", {NULL}, TEXT, FIFO, DETAB, VARY_TABS},
+   {"detab-jobs", "gcc-detab", {"-j", "4", NULL}, TEXT, SEVERAL, DETAB, VARY_TABS | VARY_LARGE},
+   {"detab-inplace", "gcc-detab", {"-i", NULL}, TEXT, INPLACE, DETAB, VARY_LIST},
+   {"detab-check", "gcc-detab", {"-c", "-i", NULL}, TEXT, CHECK, DETAB, VARY_TABS},
+   {"entab", "gcc-entab", {NULL}, TEXT, PLAIN, ENTAB, 0},
+   {"entab-tabs", "gcc-entab", {NULL}, TEXT, PLAIN, ENTAB, VARY_TABS},
+   {"entab-list", "gcc-entab", {NULL}, TEXT, PLAIN, ENTAB, VARY_LIST},
+   {"entab-utf8", "gcc-entab", {"-u", NULL}, UTF8, PLAIN, ENTAB, VARY_TABS},
+   {"entab-utf8-list", "gcc-entab", {"-u", NULL}, UTF8, PLAIN, ENTAB, VARY_LIST},
+   {"entab-c", "gcc-entab", {"-l", "c", NULL}, CODE, PLAIN, ENTAB, VARY_TABS},
+   {"entab-asm", "gcc-entab", {"-l", "asm", NULL}, CODE, PLAIN, ENTAB, VARY_LIST},
+   {"entab-fifo", "gcc-entab", {NULL}, TEXT, FIFO, ENTAB, VARY_TABS},
+   {"entab-jobs", "gcc-entab", {"-j", "4", NULL}, TEXT, SEVERAL, ENTAB, VARY_TABS | VARY_LARGE},
+   {"entab-inplace", "gcc-entab", {"-i", NULL}, TEXT, INPLACE, ENTAB, VARY_LIST},
+   {"entab-check", "gcc-entab", {"-c", "-i", NULL}, TEXT, CHECK, ENTAB, VARY_TABS},
+   {"unload", "gcc-unload", {NULL}, BINARY, PLAIN, UNLOAD, 0},
+   {"unload-size", "gcc-unload", {NULL}, BINARY, PLAIN, UNLOAD, VARY_SIZE | VARY_LOAD | VARY_START},
+   {"unload-fill", "gcc-unload", {NULL}, BINARY, PLAIN, UNLOAD, VARY_SIZE | VARY_LOAD | VARY_FILL},
+   {"unload-segment", "gcc-unload", {"-x", NULL}, BINARY, PLAIN, UNLOAD, VARY_SIZE | VARY_LOAD | VARY_START},
+   {"unload-sparse", "gcc-unload", {"-f", "0", NULL}, SPARSE, PLAIN, UNLOAD, VARY_SIZE | VARY_LOAD},
+   {"unload-jobs", "gcc-unload", {"-j", "4", NULL}, BINARY, PLAIN, UNLOAD, VARY_SIZE | VARY_LOAD | VARY_FILL | VARY_LARGE},
+   {"unload-srec", "gcc-unload", {"-s", NULL}, BINARY, PLAIN, UNLOAD, VARY_SIZE | VARY_LOAD | VARY_START},
+   {"unload-srec-fifo", "gcc-unload", {"-s", NULL}, BINARY, FIFO, UNLOAD, VARY_SIZE | VARY_LOAD},
+   {"unload-c", "gcc-unload", {"-i", NULL}, BINARY, PLAIN, UNLOAD, VARY_SIZE},
+   {"unload-files", "gcc-unload", {NULL}, BINARY, SEVERAL, UNLOAD, VARY_SIZE | VARY_LOAD | VARY_FILL},
+   {"unload-verify", "gcc-unload", {NULL}, BINARY, VERIFY, UNLOAD, VARY_SIZE},
+   {"unload-delta", "gcc-unload", {"-d", NULL}, BINARY, DELTA, UNLOAD, VARY_SIZE | VARY_LOAD | VARY_FILL | VARY_LARGE},
+   {"load", "gcc-load", {NULL}, RECORDS, PLAIN, LOAD, 0},
+   {"rehex", "gcc-rehex", {NULL}, IMAGE, PLAIN, REHEX, VARY_LENGTH | VARY_OFFSET},
+   {"rehex-srec", "gcc-rehex", {"-s", NULL}, IMAGE, PLAIN, REHEX, VARY_LENGTH | VARY_OFFSET},
+   {"hexd-dump", "gcc-hexd", {"dump", NULL}, BINARY, SERVER, UNLOAD, VARY_FORMAT | VARY_SIZE | VARY_LOAD | VARY_FILL | VARY_START},
+   {"hexd-convert", "gcc-hexd", {"convert", NULL}, RECORDS, SERVER, LOAD, 0},
+   {"hexd-verify", "gcc-hexd", {"verify", NULL}, RECORDS, SERVER, LOAD, 0},
+   {"hex-encode", NULL, {NULL}, BINARY, ENCODE, UNLOAD, VARY_FORMAT | VARY_SIZE | VARY_LOAD | VARY_FILL | VARY_START},
+   {"hex-format", NULL, {NULL}, BINARY, FORMAT, UNLOAD, VARY_FORMAT | VARY_SIZE | VARY_LOAD | VARY_FILL | VARY_START},
+   {"hex-decode", NULL, {NULL}, RECORDS, DECODE, LOAD, 0},
+   {NULL}
+};
+
+char *a_types[] = {"bin", "bin", "txt", "txt", "hex", "c", "hex"};
+
+typedef struct
+{
+   char b_aflag, b_bflag, b_cflag; /* Options for 'dump' */
+   int i_format; /* Options for 'unload' */
+   int i_size;
+   int i_width; /* Number of address bytes in each 'S' record */
+   int i_filler;
+   char b_segment, b_start;
+   unsigned long ul_load, ul_start;
+   int i_tabs; /* Options for 'detab' and 'entab', distance between tab stops or zero to use a list */
+   unsigned long a_stops[STOPS_MAX];
+   int i_stops;
+   char b_utf8;
+   int i_language;
+   unsigned long ul_offset; /* Options for 'rehex' */
+} t_settings;
+
+typedef struct
+{
+   char *s_data; /* Contents of a memory stream */
+   size_t i_length;
+   FILE *h_file;
+} t_text;
+
+char *s_directory; /* Where the files are written */
+char *s_programs = "."; /* Where the programs are */
+char b_verbose = false;
+unsigned long long ull_state; /* Pseudo random number generator */
+unsigned long ul_expected; /* Number of errors found by the reference decoder */
+char *a_created[2 * FILES_MAX + 8]; /* Files written for the current check */
+int i_created;
+
+void v_error(const char *s_fmt, ...) /* Print formatted error message */
+{
+   va_list t_args;
+   va_start(t_args, s_fmt);
+   fprintf(stderr, "%s: ", NAME);
+   vfprintf(stderr, s_fmt, t_args);
+   va_end(t_args);
+}
+
+void v_version() /* Display version information */
+{
+   fprintf(stderr, "%s: Version %s\n", NAME, VERSION);
+   fprintf(stdout, "Copyright(C) %s %s\n", COPYRIGHT, AUTHOR);
+   fprintf(stdout, "License GPLv3+: GNU GPL version 3 or later <http://gnu.org/licenses/gpl.html>.\n");
+   fprintf(stdout, "This is free software: you are free to change and redistribute it.\n");
+   fprintf(stdout, "There is NO WARRANTY, to the extent permitted by law.\n");
+   exit(0);
+}
+
+void v_about() /* Display help text */
+{
+   fprintf(stdout, "Usage: %s [OPTION]...\n", NAME);
+   fprintf(stdout, "Compares the output of each program and of the hex record library with the reference versions.\n\n");
+   fprintf(stdout, "  -c, --case NAME          only run the checks with names starting with NAME\n");
+   fprintf(stdout, "  -d, --directory DIR      write the files to check in DIR (default a new one in /tmp)\n");
+   fprintf(stdout, "  -n, --rounds N           check N inputs for each case (default 50)\n");
+   fprintf(stdout, "  -p, --programs DIR       run the programs in DIR (default .)\n");
+   fprintf(stdout, "  -s, --seed N             start the random numbers from N (default the time)\n");
+   fprintf(stdout, "  -v, --verbose            show each command that is run\n");
+   fprintf(stdout, "  -?, --help               display this help and exit\n");
+   fprintf(stdout, "      --version            output version information and exit\n");
+   exit(0);
+}
+
+void *p_allocate(size_t i_size) /* Allocate memory or give up */
+{
+   void *p_memory;
+
+   if ((p_memory = malloc(i_size ? i_size : 1)) == NULL)
+   {
+      v_error("Cannot allocate memory: %s\n", strerror(errno));
+      exit(-1);
+   }
+   return p_memory;
+}
+
+unsigned long long ull_random() /* Next pseudo random number (xorshift64*) */
+{
+   ull_state ^= ull_state >> 12;
+   ull_state ^= ull_state << 25;
+   ull_state ^= ull_state >> 27;
+   return ull_state * 0x2545F4914F6CDD1DULL;
+}
+
+unsigned long ul_pick(unsigned long ul_limit) /* Random number less than a limit */
+{
+   return ull_random() % ul_limit;
+}
+
+/*
+ * Reference functions, as they were first written apart from the files
+ * they read and write.
+ */
+
+void v_ref_dump(FILE *h_file, FILE *h_output, int i_address, t_settings *p_settings) /* Display a file using hexadecimal starting at the specified address */
+{
+   unsigned char a_buffer[DUMP_SIZE];
+   int i_count;
+   int i_bytes = 0; /* Number of bytes read from file into buffer */
+
+   while ((i_bytes = fread(a_buffer, 1, DUMP_SIZE, h_file)) > 0)
+   {
+      if (p_settings->b_bflag)
+         fprintf(h_output, "%06o", i_address); /* Print address in octal */
+      else
+         fprintf(h_output, "%04X", i_address); /* Otherwise print address in hex */
+      for (i_count = 0; i_count < i_bytes; i_count++) {
+         if (p_settings->b_bflag)
+            fprintf(h_output, "%03o ", (unsigned char) a_buffer[i_count]); /* Print bytes using octal */
+         else
+         {
+            if (!(i_count % 4))
+               fprintf(h_output, " "); /* Space out bytes in groups of four */
+            fprintf(h_output, "%02X", (unsigned char) a_buffer[i_count]); /* Otherwise print bytes using hex (default) */
+         }
+      }
+      for (i_count = 0; i_count < i_bytes; i_count++) /* Replace non printing characters */
+      {
+         if (!(isprint(a_buffer[i_count]) && a_buffer[i_count] < 127))
+         {
+            if (p_settings->b_cflag)
+               a_buffer[i_count] = ' ';
+            else
+               a_buffer[i_count] = '.';
+         }
+      }
+      if (p_settings->b_aflag) /* Print ASCII characters on same line */
+      {
+         fprintf(h_output, " %*s", 4 - ((i_bytes - 1) / 4) + 2  * (DUMP_SIZE - i_bytes), ""); /* Print required number of spaces */
+         fprintf(h_output, "%.*s", i_bytes, a_buffer); /* Print the number of characters in the buffer */
+      }
+      i_address += i_bytes;
+      fprintf(h_output, "\n");/* Print newline */
+   }
+}
+
+void v_ref_unload(FILE *h_file, FILE *h_output, int i_address) /* Display a file using intel hex starting at the specified address */
+{
+   unsigned char a_buffer[BUFFER_SIZE];
+   int i_count;
+   int i_bytes = 0; /* Number of bytes read from file into buffer */ 
+   int i_type = 0;
+   unsigned int i_checksum = 0;
+
+   while ((i_bytes = fread(a_buffer, 1, BUFFER_SIZE, h_file)) > 0)
+   {
+      fprintf(h_output, ":%02X%04X%02X", i_bytes, i_address, i_type); /* Print record length, address and record type */
+      i_checksum = i_bytes + i_type + (i_address / 256) + (i_address % 256);
+      for (i_count = 0; i_count < i_bytes; i_count++)
+      {
+         fprintf(h_output, "%02X", a_buffer[i_count] & 0xFF);  /* Print each byte */
+         i_checksum += a_buffer[i_count];
+      }
+      /* The checksum is the least significant byte of the the two's complement of the sum of all bytes values in the record */      
+      fprintf(h_output, "%02X\n", (~(i_checksum & 0xFF) + 1) & 0xFF); /* Print the checksum byte */
+      i_address += i_bytes;
+   }
+   /* Print the end of file record - this could be shortened (a lot) but I've left it like this to show how the checksum is calculated */
+   i_type = 1; /* EOF record type */
+   i_checksum = i_type; /* Address and record length are both zero */
+   fprintf(h_output, ":%02X%04X%02X", 0, 0, i_type); /* Print record length, address and record type */
+   fprintf(h_output, "%02X\n", (~(i_checksum & 0xFF) + 1) & 0xFF); 
+}
+
+int i_ref_load(FILE *h_input, FILE *h_output, FILE *h_list, int i_offset) /* Read intel hexadecimal and print bytes */
+{
+   int i_last = '\n';
+   int i_char;
+   int i_bytes;
+   int i_address;
+   int i_type;
+   int i_data;
+   int i_checksum;
+   int i_error = 0;
+   int i_count = 0;
+
+   while ((i_char = fgetc(h_input)) != EOF)
+   {
+      switch (i_count)
+      {
+         case 0: /* Check for start of record */
+            if (((i_last == '\n') || (i_last == '\r')) && (i_char == ':')) /* Start of record */
+            {
+               fprintf (h_list, "%c", i_char);
+               i_bytes = 0; /* Reset values */
+               i_address = 0;
+               i_type = 0;
+               i_data = 0;
+               i_checksum = 0;
+               i_count++;
+            }
+            break;
+         case 1: /* Get number of bytes in record */
+         case 2:
+            i_bytes <<= 4;
+            if (i_char >= '0' && i_char <= '9') i_bytes |= ((i_char - '0') & 0x0F);
+            else if (i_char >= 'a' && i_char <= 'f') i_bytes |= ((i_char - 'a' + 10) & 0x0F);
+            else if (i_char >= 'A' && i_char <= 'F') i_bytes |= ((i_char - 'A' + 10) & 0x0F);
+            else i_error++;
+            if (i_count == 2) fprintf (h_list, "%02X", i_bytes);
+            i_count++;
+            break;
+         case 3: /* Get address of bytes in record */
+         case 4:
+         case 5:
+         case 6:
+            i_address <<= 4;
+            if (i_char >= '0' && i_char <= '9') i_address |= ((i_char - '0') & 0x0F);
+            else if (i_char >= 'a' && i_char <= 'f') i_address |= ((i_char - 'a' + 10) & 0x0F);
+            else if (i_char >= 'A' && i_char <= 'F') i_address |= ((i_char - 'A' + 10) & 0x0F);
+            else i_error++;
+            if (i_count == 6) fprintf (h_list, "%04X", i_address);
+            if (i_address < i_offset) i_error++; /* Can't go backwards! */
+            while (i_offset < i_address) /* If the address of the next record is greater than the current offset then pad output with NOPs */
+            {
+               i_offset++;
+               fputc(0x00, h_output);
+            }
+            i_count++;
+            break;
+         case 7: /* Get record type */
+         case 8:
+            i_type <<= 4;
+            if (i_char >= '0' && i_char <= '9') i_type |= ((i_char - '0') & 0x0F);
+            else if (i_char >= 'a' && i_char <= 'f') i_type |= ((i_char - 'a' + 10) & 0x0F);
+            else if (i_char >= 'A' && i_char <= 'F') i_type |= ((i_char - 'A' + 10) & 0x0F);
+            else i_error++;
+            if (i_count == 8) fprintf (h_list, "%02X", i_type);
+            i_checksum = i_bytes + i_type + (i_address / 256) + (i_address % 256);
+            i_count++;
+            break;
+         default:
+            if (i_char == '\r' || i_char == '\n')
+            {
+               i_count = 0; /* Read next record */
+               if (i_bytes >= 0)
+               {
+                  i_error++;
+                  fprintf (h_list, " - Error");
+               }
+               fprintf (h_list, "\n");
+            }
+            else
+            {
+               i_data <<= 4;
+               if (i_char >= '0' && i_char <= '9') i_data |= ((i_char - '0') & 0x0F);
+               else if (i_char >= 'a' && i_char <= 'f') i_data |= ((i_char - 'a' + 10) & 0x0F);
+               else if (i_char >= 'A' && i_char <= 'F') i_data |= ((i_char - 'A' + 10) & 0x0F);
+               else i_error++;
+               i_count++;
+               if (i_count % 2) 
+               {
+                  fprintf (h_list, "%02X", i_data);
+                  if (i_bytes) 
+                  {
+                     fputc(i_data, h_output);
+                     i_offset++;
+                     i_checksum += i_data;
+                  }
+                  else 
+                  {
+                     i_checksum = (~(i_checksum & 0xFF) + 1) & 0xFF;
+                     if (i_checksum != i_data) 
+                     {
+                        i_error++;
+                        fprintf (h_list, " - Error");
+                     }
+                     else
+                        fprintf (h_list, " - Ok");
+                  }
+                  i_bytes--;
+                  i_data = 0; /* Reset value before reading next byte */
+               }
+            }
+
+      }
+      if (i_last != '\n' || i_char != '\0') i_last= i_char; /* Ignore any leading NULL chracters at the start of each record */
+   }
+   return (i_char);
+}
+
+void v_ref_detab(FILE *h_file, FILE *h_output)
+{
+   int i_offset = 0;
+   int i_char;
+   
+   while ((i_char = fgetc(h_file)) != EOF)
+   {
+      if (i_char == '\t')
+      {
+         while (i_offset % 8)
+         {
+            fputc(' ', h_output);
+            i_offset++;
+         }
+         fputc(' ', h_output);
+      }
+      else
+      {
+         fputc(i_char, h_output);
+         if ((i_char == '\n') || (i_char == '\r')) i_offset = 0;
+      }
+      i_offset++;
+   }
+}
+
+void v_ref_entab(FILE *h_file, FILE *h_output)
+{
+   int i_offset = 1;
+   int i_blanks = 0;
+   int i_char;
+   
+   while ((i_char = fgetc(h_file)) != EOF)
+   {
+      if (i_char == ' ')
+      {
+         ++i_blanks;
+         if ((i_offset % TAB_WIDTH) == 0) /* Check for TAB position */
+         {
+            fputc('\t', h_output);
+            i_blanks = 0;
+         }        
+      }
+      else
+      {
+         while (i_blanks > 0)
+         {
+            fputc(' ', h_output);
+            i_blanks--;
+         }
+         fputc(i_char, h_output);
+         if ((i_char == '\n') || (i_char == '\r')) i_offset = 0;
+      }
+      i_offset++;
+   }
+}
+
+/*
+ * Reference functions for the options added since then, and for 'rehex'
+ * and 'hexd', written in the same way.
+ */
+
+void v_new_record(FILE *h_output, int i_type, unsigned int i_address, unsigned char *p_data, int i_bytes) /* Print an intel hex record */
+{
+   int i_checksum;
+   int i_count;
+
+   fprintf(h_output, ":%02X%04X%02X", i_bytes, i_address, i_type);
+   i_checksum = i_bytes + i_type + (i_address >> 8) + (i_address & 0xFF);
+   for (i_count = 0; i_count < i_bytes; i_count++)
+   {
+      fprintf(h_output, "%02X", p_data[i_count]);
+      i_checksum += p_data[i_count];
+   }
+   fprintf(h_output, "%02X\n", (~(i_checksum & 0xFF) + 1) & 0xFF); /* Two's complement of the sum of all the bytes */
+}
+
+void v_new_srecord(FILE *h_output, int i_type, unsigned long ul_address, int i_width, unsigned char *p_data, int i_bytes) /* Print a motorola 'S' record */
+{
+   int i_checksum;
+   int i_count;
+
+   ul_address &= 0xFFFFFFFFUL >> (8 * (4 - i_width)); /* Only the address bytes that fit */
+   fprintf(h_output, "S%d%02X%0*lX", i_type, i_width + i_bytes + 1, 2 * i_width, ul_address);
+   i_checksum = i_width + i_bytes + 1;
+   for (i_count = 0; i_count < i_width; i_count++)
+      i_checksum += (ul_address >> (8 * i_count)) & 0xFF;
+   for (i_count = 0; i_count < i_bytes; i_count++)
+   {
+      fprintf(h_output, "%02X", p_data[i_count]);
+      i_checksum += p_data[i_count];
+   }
+   fprintf(h_output, "%02X\n", ~i_checksum & 0xFF); /* One's complement of the sum of all the bytes */
+}
+
+void v_new_symbol(FILE *h_output, const char *s_name) /* Print a file name as a C identifier */
+{
+   if (*s_name >= '0' && *s_name <= '9') fputc('_', h_output);
+   for (; *s_name; s_name++)
+      fputc(isalnum((unsigned char) *s_name) ? *s_name : '_', h_output);
+}
+
+void v_new_unload(FILE *h_file, FILE *h_output, const char *s_name, t_settings *p_settings) /* Also writes 'S' records or a C array, any size of record at any address, and leaves out records that only hold the fill byte */
+{
+   unsigned char a_buffer[HEX_RECORD_MAX], a_upper[2];
+   unsigned long ul_address = p_settings->ul_load;
+   unsigned long ul_records = 0;
+   unsigned long ul_start = p_settings->b_start ? p_settings->ul_start : p_settings->ul_load;
+   unsigned long ul_upper = 0; /* Upper address bits of the last record */
+   int i_width = p_settings->i_width;
+   int i_bytes, i_count;
+
+   if (p_settings->i_format == HEX_SOURCE)
+   {
+      fprintf(h_output, "const unsigned char ");
+      v_new_symbol(h_output, s_name);
+      fprintf(h_output, "[] = {\n");
+   }
+   if (p_settings->i_format == HEX_MOTOROLA) /* Header holds the file name */
+      v_new_srecord(h_output, 0, 0, 2, (unsigned char *) s_name, strlen(s_name) > 64 ? 64 : strlen(s_name));
+   for (;;)
+   {
+      i_bytes = p_settings->i_size;
+      if (p_settings->i_format == HEX_INTEL && i_bytes > 0x10000 - (ul_address & 0xFFFF)) /* Records stop at each 64K boundary */
+         i_bytes = 0x10000 - (ul_address & 0xFFFF);
+      if ((i_bytes = fread(a_buffer, 1, i_bytes, h_file)) <= 0) break;
+      for (i_count = 0; i_count < i_bytes && a_buffer[i_count] == p_settings->i_filler; i_count++);
+      if (i_count < i_bytes) /* Leave out records that only hold the fill byte */
+      {
+         ul_records++;
+         if (p_settings->i_format == HEX_SOURCE)
+         {
+            for (i_count = 0; i_count < i_bytes; i_count++)
+               fprintf(h_output, "%s0x%02X,", i_count ? " " : "  ", a_buffer[i_count]);
+            fprintf(h_output, "\n");
+         }
+         else if (p_settings->i_format == HEX_MOTOROLA)
+            v_new_srecord(h_output, i_width - 1, ul_address, i_width, a_buffer, i_bytes);
+         else
+         {
+            if ((ul_address >> 16) != ul_upper) /* Extended segment or linear address */
+            {
+               ul_upper = ul_address >> 16;
+               a_upper[0] = p_settings->b_segment ? (ul_upper << 4) & 0xFF : (ul_upper >> 8) & 0xFF;
+               a_upper[1] = p_settings->b_segment ? 0 : ul_upper & 0xFF;
+               v_new_record(h_output, p_settings->b_segment ? 2 : 4, 0, a_upper, 2);
+            }
+            v_new_record(h_output, 0, ul_address & 0xFFFF, a_buffer, i_bytes);
+         }
+      }
+      ul_address += i_bytes;
+   }
+   if (p_settings->i_format == HEX_SOURCE)
+   {
+      if (ul_address == p_settings->ul_load) fprintf(h_output, "  0x00\n");
+      fprintf(h_output, "};\nconst unsigned int ");
+      v_new_symbol(h_output, s_name);
+      fprintf(h_output, "_len = %lu;\n", ul_address - p_settings->ul_load);
+   }
+   else if (p_settings->i_format == HEX_MOTOROLA)
+   {
+      if (ul_records <= 0xFFFF) /* Record count */
+         v_new_srecord(h_output, 5, ul_records, 2, NULL, 0);
+      else if (ul_records <= 0xFFFFFF)
+         v_new_srecord(h_output, 6, ul_records, 3, NULL, 0);
+      if (i_hex_width(ul_start) > i_width) i_width = i_hex_width(ul_start);
+      v_new_srecord(h_output, 11 - i_width, ul_start, i_width, NULL, 0);
+   }
+   else
+   {
+      if (p_settings->b_start || ul_upper) /* Start address */
+      {
+         a_buffer[0] = p_settings->b_segment ? (ul_start >> 12) & 0xF0 : (ul_start >> 24) & 0xFF;
+         a_buffer[1] = p_settings->b_segment ? 0 : (ul_start >> 16) & 0xFF;
+         a_buffer[2] = (ul_start >> 8) & 0xFF;
+         a_buffer[3] = ul_start & 0xFF;
+         v_new_record(h_output, p_settings->b_segment ? 3 : 5, 0, a_buffer, 4);
+      }
+      fprintf(h_output, ":00000001FF\n");
+   }
+}
+
+unsigned long ul_new_errors(FILE *h_file) /* Count the errors in intel hexadecimal records the way the library does, only data records can go backwards */
+{
+   int i_last = '\n';
+   int i_char, i_digit;
+   int i_bytes = 0, i_address = 0, i_type = 0, i_data = 0, i_checksum = 0, i_count = 0;
+   int i_offset = LOAD_ADDRESS;
+   unsigned long ul_errors = 0;
+
+   while ((i_char = fgetc(h_file)) != EOF)
+   {
+      if (i_char >= '0' && i_char <= '9') i_digit = i_char - '0';
+      else if (i_char >= 'a' && i_char <= 'f') i_digit = i_char - 'a' + 10;
+      else if (i_char >= 'A' && i_char <= 'F') i_digit = i_char - 'A' + 10;
+      else i_digit = -1;
+      if (!i_count) /* Check for start of record */
+      {
+         if (((i_last == '\n') || (i_last == '\r')) && (i_char == ':'))
+         {
+            i_bytes = i_address = i_type = i_data = i_checksum = 0;
+            i_count++;
+         }
+      }
+      else if (i_count > 8 && (i_char == '\r' || i_char == '\n'))
+      {
+         i_count = 0; /* Read next record */
+         if (i_bytes >= 0) ul_errors++; /* Short record */
+      }
+      else
+      {
+         if (i_digit < 0)
+         {
+            ul_errors++;
+            i_digit = 0;
+         }
+         i_count++;
+         if (i_count <= 3) i_bytes = (i_bytes << 4) | i_digit;
+         else if (i_count <= 7) i_address = (i_address << 4) | i_digit;
+         else if (i_count <= 9) i_type = (i_type << 4) | i_digit;
+         else i_data = (i_data << 4) | i_digit;
+         if (i_count == 7 && i_offset < i_address) i_offset = i_address; /* Gaps are padded */
+         if (i_count == 9)
+         {
+            if (!i_type && i_address < i_offset) ul_errors++; /* Data can't go backwards */
+            i_checksum = i_bytes + i_type + (i_address / 256) + (i_address % 256);
+         }
+         if (i_count > 9 && (i_count % 2))
+         {
+            if (i_bytes)
+            {
+               i_offset++;
+               i_checksum += i_data;
+            }
+            else if (((~(i_checksum & 0xFF) + 1) & 0xFF) != i_data)
+               ul_errors++;
+            i_bytes--;
+            i_data = 0;
+         }
+      }
+      if (i_last != '\n' || i_char != '\0') i_last = i_char; /* Leading NULL characters are ignored */
+   }
+   return ul_errors;
+}
+
+void v_new_data(FILE *h_output, t_settings *p_settings, unsigned long ul_address, unsigned char *p_data, int i_bytes, int *i_width, unsigned long *ul_upper) /* Print a data record written by 'rehex' */
+{
+   unsigned char a_upper[2];
+
+   if (p_settings->i_format == HEX_MOTOROLA)
+   {
+      if (i_hex_width(ul_address + i_bytes - 1) > *i_width) *i_width = i_hex_width(ul_address + i_bytes - 1); /* The address size never goes down */
+      v_new_srecord(h_output, *i_width - 1, ul_address, *i_width, p_data, i_bytes);
+      return;
+   }
+   if ((ul_address >> 16) != *ul_upper) /* Extended linear address */
+   {
+      *ul_upper = ul_address >> 16;
+      a_upper[0] = (*ul_upper >> 8) & 0xFF;
+      a_upper[1] = *ul_upper & 0xFF;
+      v_new_record(h_output, 4, 0, a_upper, 2);
+   }
+   v_new_record(h_output, 0, ul_address & 0xFFFF, p_data, i_bytes);
+}
+
+void v_new_rehex(FILE *h_file, FILE *h_output, t_settings *p_settings) /* Read valid intel hex or 'S' records and write the same data again in records of the given size */
+{
+   static const int a_widths[] = {2, 2, 3, 4, 0, 2, 3, 4, 3, 2}; /* Address bytes in each type of 'S' record */
+   unsigned char a_line[HEX_RECORD_MAX + 5], a_record[HEX_RECORD_MAX], a_address[4];
+   char s_line[2 * HEX_LINE];
+   unsigned long ul_base = 0, ul_address, ul_record = 0, ul_upper = 0, ul_records = 0, ul_start = 0;
+   unsigned int i_value;
+   unsigned char *p_data;
+   int i_type, i_bytes, i_count, i_length = 0, i_width = 2;
+   char b_start = false, b_motorola;
+
+   if (p_settings->i_format == HEX_MOTOROLA) v_new_srecord(h_output, 0, 0, 2, NULL, 0); /* No file name */
+   while (fgets(s_line, sizeof(s_line), h_file) != NULL)
+   {
+      if (s_line[0] != ':' && (s_line[0] != 'S' || !isdigit((unsigned char) s_line[1]))) continue; /* Not a record */
+      b_motorola = (s_line[0] == 'S');
+      for (i_count = 0; sscanf(s_line + 1 + b_motorola + 2 * i_count, "%2X", &i_value) == 1; i_count++)
+         a_line[i_count] = i_value;
+      if (!b_motorola)
+      {
+         i_type = a_line[3];
+         ul_address = ul_base + ((a_line[1] << 8) | a_line[2]);
+         p_data = a_line + 4;
+         i_bytes = a_line[0];
+         if (i_type == 1) break;
+         if (i_type == 2 || i_type == 4) ul_base = (unsigned long) ((p_data[0] << 8) | p_data[1]) << ((i_type == 2) ? 4 : 16);
+         if (i_type == 3 || i_type == 5)
+         {
+            b_start = true;
+            ul_start = (i_type == 3) ? (((p_data[0] << 8) | p_data[1]) << 4) + ((p_data[2] << 8) | p_data[3]) :
+               ((unsigned long) p_data[0] << 24) | (p_data[1] << 16) | (p_data[2] << 8) | p_data[3];
+         }
+         if (i_type) continue;
+      }
+      else
+      {
+         i_type = s_line[1] - '0';
+         for (ul_address = 0, i_count = 1; i_count <= a_widths[i_type]; i_count++) ul_address = (ul_address << 8) | a_line[i_count];
+         p_data = a_line + i_count;
+         i_bytes = a_line[0] - i_count;
+         if (i_type > 6 && ul_address) /* A zero address is no start address */
+         {
+            b_start = true;
+            ul_start = ul_address;
+         }
+         if (i_type > 6) break;
+         if (i_type == 0 || i_type > 3) continue;
+      }
+      for (ul_address += p_settings->ul_offset; i_bytes > 0; i_bytes--, ul_address++)
+      {
+         if (i_length && (ul_address != ul_record + i_length || i_length >= p_settings->i_size ||
+            (p_settings->i_format == HEX_INTEL && !(ul_address & 0xFFFF)))) /* Start a new record */
+         {
+            v_new_data(h_output, p_settings, ul_record, a_record, i_length, &i_width, &ul_upper);
+            ul_records++;
+            i_length = 0;
+         }
+         if (!i_length) ul_record = ul_address;
+         a_record[i_length++] = *p_data++;
+      }
+   }
+   if (i_length)
+   {
+      v_new_data(h_output, p_settings, ul_record, a_record, i_length, &i_width, &ul_upper);
+      ul_records++;
+   }
+   ul_start = b_start ? ul_start + p_settings->ul_offset : 0;
+   if (p_settings->i_format == HEX_MOTOROLA)
+   {
+      if (ul_records <= 0xFFFF) /* Record count */
+         v_new_srecord(h_output, 5, ul_records, 2, NULL, 0);
+      else if (ul_records <= 0xFFFFFF)
+         v_new_srecord(h_output, 6, ul_records, 3, NULL, 0);
+      if (i_hex_width(ul_start) > i_width) i_width = i_hex_width(ul_start);
+      v_new_srecord(h_output, 11 - i_width, ul_start, i_width, NULL, 0);
+      return;
+   }
+   if (b_start)
+   {
+      for (i_count = 0; i_count < 4; i_count++) a_address[i_count] = (ul_start >> (24 - 8 * i_count)) & 0xFF;
+      v_new_record(h_output, 5, 0, a_address, 4);
+   }
+   fprintf(h_output, ":00000001FF\n");
+}
+
+int i_stop(t_settings *p_settings, unsigned long ul_offset, char b_beyond) /* Return true at a tab stop, b_beyond is true if every column after the last one in a list is a stop */
+{
+   int i_count;
+
+   if (p_settings->i_tabs) return !(ul_offset % p_settings->i_tabs);
+   for (i_count = 0; i_count < p_settings->i_stops; i_count++)
+      if (p_settings->a_stops[i_count] == ul_offset) return true;
+   return b_beyond && ul_offset > p_settings->a_stops[p_settings->i_stops - 1];
+}
+
+int i_new_char(FILE *h_file, FILE *h_output, int i_char) /* Copy the rest of a UTF-8 character, returns the number of columns it uses */
+{
+   unsigned long ul_code = i_char & ((i_char >= 0xF0) ? 0x07 : (i_char >= 0xE0) ? 0x0F : 0x1F);
+   int i_count;
+
+   fputc(i_char, h_output);
+   for (i_count = (i_char >= 0xF0) ? 3 : (i_char >= 0xE0) ? 2 : 1; i_count > 0 && (i_char = fgetc(h_file)) != EOF; i_count--)
+   {
+      fputc(i_char, h_output);
+      ul_code = (ul_code << 6) | (i_char & 0x3F);
+   }
+   if (ul_code >= 0x0300 && ul_code <= 0x036F) return 0; /* Combining accents */
+   if ((ul_code >= 0x4E00 && ul_code <= 0x9FFF) || (ul_code >= 0xAC00 && ul_code <= 0xD7A3) || (ul_code >= 0x1F300 && ul_code <= 0x1F64F))
+      return 2; /* Chinese, Korean and emoji */
+   return 1;
+}
+
+int i_new_lex(int i_state, int i_char, int i_language) /* Return the state of a lexer for C or assembler after a character */
+{
+   char b_newline = (i_char == '\n' || i_char == '\r');
+
+   switch (i_state)
+   {
+   case LEX_CODE:
+   case LEX_SLASH:
+      if (i_char == '"') return LEX_STRING;
+      if (i_char == '\'' && i_language == LANGUAGE_C) return LEX_CHAR; /* A quote is not special in assembler */
+      if ((i_char == ';' || i_char == '#') && i_language == LANGUAGE_ASM) return LEX_LINE;
+      if (i_char == '/') return (i_state == LEX_SLASH) ? LEX_LINE : LEX_SLASH;
+      if (i_char == '*' && i_state == LEX_SLASH) return LEX_BLOCK;
+      return LEX_CODE;
+   case LEX_STRING:
+      if (i_char == '\\') return LEX_S_ESC;
+      return (i_char == '"' || b_newline) ? LEX_CODE : LEX_STRING;
+   case LEX_CHAR:
+      if (i_char == '\\') return LEX_C_ESC;
+      return (i_char == '\'' || b_newline) ? LEX_CODE : LEX_CHAR;
+   case LEX_LINE:
+      if (i_char == '\\') return LEX_L_ESC;
+      return b_newline ? LEX_CODE : LEX_LINE;
+   case LEX_BLOCK:
+      return (i_char == '*') ? LEX_STAR : LEX_BLOCK;
+   case LEX_STAR:
+      return (i_char == '/') ? LEX_CODE : (i_char == '*') ? LEX_STAR : LEX_BLOCK;
+   default: /* Any character after a backslash */
+      return i_state - 1;
+   }
+}
+
+void v_new_detab(FILE *h_file, FILE *h_output, t_settings *p_settings) /* Also takes any tab stops, and counts the columns used by UTF-8 characters */
+{
+   unsigned long ul_offset = 0;
+   int i_char;
+
+   while ((i_char = fgetc(h_file)) != EOF)
+   {
+      if (i_char == '\t')
+      {
+         while (!i_stop(p_settings, ul_offset, true))
+         {
+            fputc(' ', h_output);
+            ul_offset++;
+         }
+         fputc(' ', h_output);
+      }
+      else if (p_settings->b_utf8 && i_char >= 0xC0)
+      {
+         ul_offset += i_new_char(h_file, h_output, i_char);
+         continue;
+      }
+      else
+      {
+         fputc(i_char, h_output);
+         if ((i_char == '\n') || (i_char == '\r')) ul_offset = 0;
+      }
+      ul_offset++;
+   }
+}
+
+void v_new_entab(FILE *h_file, FILE *h_output, t_settings *p_settings) /* Also takes any tab stops, counts the columns used by UTF-8 characters, and leaves quoted text and comments alone */
+{
+   unsigned long ul_offset = 1;
+   int i_blanks = 0;
+   int i_state = LEX_CODE;
+   int i_last = 0;
+   char b_quoted = false;
+   int i_char;
+
+   while ((i_char = fgetc(h_file)) != EOF)
+   {
+      if (i_char == ' ' && i_last != ' ') b_quoted = (i_state >= LEX_STRING); /* A run of spaces is left alone if it starts in quoted text or a comment */
+      if (p_settings->i_language) i_state = i_new_lex(i_state, i_char, p_settings->i_language);
+      i_last = i_char;
+      if (i_char == ' ')
+      {
+         ++i_blanks;
+         if (!b_quoted && i_stop(p_settings, ul_offset, false)) /* Check for TAB position */
+         {
+            fputc('\t', h_output);
+            i_blanks = 0;
+         }
+      }
+      else
+      {
+         while (i_blanks > 0)
+         {
+            fputc(' ', h_output);
+            i_blanks--;
+         }
+         if (p_settings->b_utf8 && i_char >= 0xC0)
+         {
+            ul_offset += i_new_char(h_file, h_output, i_char);
+            continue;
+         }
+         fputc(i_char, h_output);
+         if ((i_char == '\n') || (i_char == '\r')) ul_offset = 0;
+      }
+      ul_offset++;
+   }
+}
+
+/*
+ * Generated inputs.
+ */
+
+unsigned long ul_length(t_case *p_case, int i_round) /* Choose the size of an input, trying the awkward sizes first */
+{
+   static const unsigned long a_edges[] = {0, 1, 2, 7, 8, 9, 15, 16, 17, 255, 256, 257, 4095, 4096, 4097,
+      65535, 65536, 65537, 262143, 262144, 262145, 262161};
+   int i_edges = sizeof(a_edges) / sizeof(a_edges[0]);
+   unsigned long ul_length;
+
+   if (!i_round && (p_case->i_vary & VARY_LARGE))
+      return ((p_case->i_kind == TEXT) ? 2 * PIECE_SIZE : 4 * CHUNK_SIZE) + ul_pick(65536);
+   if (i_round > 0 && i_round <= i_edges) ul_length = a_edges[i_round - 1];
+   else switch (ul_pick(4))
+   {
+   case 0: ul_length = ul_pick(64); break;
+   case 1: ul_length = ul_pick(8192); break;
+   case 2: ul_length = ul_pick(131072); break;
+   default: ul_length = ul_pick(3 * CHUNK_SIZE); break;
+   }
+   if (p_case->i_method == VERIFY) /* Reading records back doesn't follow extended addresses */
+      ul_length %= 0x10000 - LOAD_ADDRESS + 1;
+   return ul_length;
+}
+
+void v_binary(unsigned char *p_data, unsigned long ul_length) /* Make some bytes with runs of the usual fill bytes in between */
+{
+   unsigned long ul_done, ul_run, ul_count;
+
+   for (ul_done = 0; ul_done < ul_length; ul_done += ul_run)
+   {
+      ul_run = 1 + ul_pick(ul_pick(4) ? 64 : 4096);
+      if (ul_run > ul_length - ul_done) ul_run = ul_length - ul_done;
+      switch (ul_pick(5))
+      {
+      case 0: memset(p_data + ul_done, 0x00, ul_run); break;
+      case 1: memset(p_data + ul_done, 0xFF, ul_run); break;
+      case 2: memset(p_data + ul_done, ul_pick(256), ul_run); break;
+      case 3: for (ul_count = 0; ul_count < ul_run; ul_count++) p_data[ul_done + ul_count] = ' ' + ul_pick(95); break;
+      default: for (ul_count = 0; ul_count < ul_run; ul_count++) p_data[ul_done + ul_count] = ull_random(); break;
+      }
+   }
+}
+
+void v_text(char *s_data, unsigned long ul_length, int i_kind) /* Make some text with runs of tabs and spaces, and all kinds of line break */
+{
+   static const char *a_chars[] = {"\xC3\xA9", "\xCE\xA9", "\xCC\x81", "\xE4\xB8\xAD", "\xED\x95\x9C", "\xF0\x9F\x98\x80"}; /* Characters that use one, none or two columns */
+   unsigned long ul_done, ul_run, ul_count;
+
+   for (ul_done = 0; ul_done < ul_length; ul_done += ul_run)
+   {
+      ul_run = 1;
+      switch (ul_pick(16))
+      {
+      case 0: case 1: case 2: case 3: /* Word */
+         ul_run = 1 + ul_pick(12);
+         if (ul_run > ul_length - ul_done) ul_run = ul_length - ul_done;
+         for (ul_count = 0; ul_count < ul_run; ul_count++) s_data[ul_done + ul_count] = 'a' + ul_pick(26);
+         break;
+      case 4: case 5: case 6: case 7: /* Spaces */
+         ul_run = 1 + ul_pick(ul_pick(3) ? 4 : 40);
+         if (ul_run > ul_length - ul_done) ul_run = ul_length - ul_done;
+         memset(s_data + ul_done, ' ', ul_run);
+         break;
+      case 8: case 9: /* Tabs */
+         ul_run = 1 + ul_pick(3);
+         if (ul_run > ul_length - ul_done) ul_run = ul_length - ul_done;
+         memset(s_data + ul_done, '\t', ul_run);
+         break;
+      case 10: case 11:
+         s_data[ul_done] = '\n';
+         break;
+      case 12:
+         s_data[ul_done] = '\r';
+         break;
+      case 13:
+         s_data[ul_done] = "\"'/*\\#;,"[ul_pick(8)];
+         break;
+      case 14:
+         if (i_kind == UTF8 && (ul_run = strlen(a_chars[ul_count = ul_pick(6)])) <= ul_length - ul_done)
+            memcpy(s_data + ul_done, a_chars[ul_count], ul_run);
+         else
+         {
+            ul_run = 1;
+            s_data[ul_done] = (i_kind == TEXT) ? ul_pick(256) : '0' + ul_pick(10); /* Any byte at all */
+         }
+         break;
+      default:
+         ul_run = 1 + ul_pick(ul_pick(8) ? 80 : 8000); /* Some long lines */
+         if (ul_run > ul_length - ul_done) ul_run = ul_length - ul_done;
+         for (ul_count = 0; ul_count < ul_run; ul_count++) s_data[ul_done + ul_count] = ' ' + ul_pick(95);
+         break;
+      }
+   }
+}
+
+void v_code(char *s_data, unsigned long ul_length) /* Make some text that looks like C or assembler, with quotes, comments and escapes that may not be closed */
+{
+   static const char *a_pieces[] = {"\"", "'", "\\", "/", "*", "/*", "*/", "//", ";", "#", "\"a  \\\"  b\"", "'  '", "'\\''",
+      "\\\n", "\n", "\n", "\r\n", "x", "label:", "i_count = 1", "mov  a, b", " ", " ", "  ", "   ", "    ", "\t"};
+   unsigned long ul_done, ul_run;
+   const char *s_piece;
+
+   for (ul_done = 0; ul_done < ul_length; ul_done += ul_run)
+   {
+      s_piece = a_pieces[ul_pick(sizeof(a_pieces) / sizeof(a_pieces[0]))];
+      if (!ul_pick(8)) /* A longer run of spaces */
+      {
+         ul_run = 1 + ul_pick(20);
+         if (ul_run > ul_length - ul_done) ul_run = ul_length - ul_done;
+         memset(s_data + ul_done, ' ', ul_run);
+         continue;
+      }
+      ul_run = strlen(s_piece);
+      if (ul_run > ul_length - ul_done) ul_run = ul_length - ul_done;
+      memcpy(s_data + ul_done, s_piece, ul_run);
+   }
+}
+
+void v_records(FILE *h_output, unsigned long ul_length) /* Write intel hex records holding some bytes, damaging some of them */
+{
+   static const char *s_digits = "0123456789ABCDEF";
+   unsigned char a_data[HEX_RECORD_MAX + 5];
+   char s_line[2 * HEX_LINE];
+   unsigned long ul_done = 0;
+   unsigned int i_address = LOAD_ADDRESS;
+   int i_bytes, i_type, i_length, i_count, i_sum;
+
+   while (ul_done < ul_length)
+   {
+      i_bytes = ul_pick(4) ? 16 : ul_pick(HEX_RECORD_MAX + 1);
+      i_type = ul_pick(16) ? 0 : ul_pick(6);
+      if (!ul_pick(32)) i_address += ul_pick(512); /* Leave a gap */
+      if (!ul_pick(64)) i_address -= ul_pick(64); /* Go backwards */
+      a_data[0] = i_bytes;
+      a_data[1] = (i_address >> 8) & 0xFF;
+      a_data[2] = i_address & 0xFF;
+      a_data[3] = i_type;
+      v_binary(a_data + 4, i_bytes);
+      for (i_count = 0, i_sum = 0; i_count < i_bytes + 4; i_count++) i_sum += a_data[i_count];
+      a_data[i_bytes + 4] = (~(i_sum & 0xFF) + 1) & 0xFF;
+      s_line[0] = ':';
+      for (i_count = 0; i_count < i_bytes + 5; i_count++)
+      {
+         s_line[1 + 2 * i_count] = s_digits[a_data[i_count] >> 4];
+         s_line[2 + 2 * i_count] = s_digits[a_data[i_count] & 0x0F];
+      }
+      i_length = 2 * i_bytes + 11;
+      switch (ul_pick(24)) /* Damage some of the records */
+      {
+      case 0: for (i_count = 1; i_count < i_length; i_count++) s_line[i_count] = tolower((unsigned char) s_line[i_count]); break;
+      case 1: s_line[1 + ul_pick(i_length - 1)] ^= 0x01; break; /* Wrong digit */
+      case 2: s_line[1 + ul_pick(i_length - 1)] = "G \t:x"[ul_pick(5)]; break; /* Not a digit */
+      case 3: i_length = 1 + ul_pick(i_length - 1); break; /* Short record */
+      case 4: i_length += sprintf(s_line + i_length, "%02X", (unsigned int) ul_pick(256)); break; /* Long record */
+      case 5: s_line[0] = ' '; break; /* No colon */
+      case 6: fputs("junk :00000001FF", h_output); break; /* Text before the colon */
+      }
+      fwrite(s_line, 1, i_length, h_output);
+      switch (ul_pick(16)) /* Every kind of line break */
+      {
+      case 0: fputs("\r\n", h_output); break;
+      case 1: fputc('\r', h_output); break;
+      case 2: fwrite("\n\0\0", 1, 3, h_output); break; /* Leading nulls are ignored */
+      case 3: fputs("\n\n", h_output); break;
+      default: fputc('\n', h_output); break;
+      }
+      i_address += i_bytes;
+      ul_done += i_bytes;
+   }
+   if (ul_pick(4)) fputs(":00000001FF", h_output);
+   if (ul_pick(4)) fputc('\n', h_output);
+}
+
+/*
+ * Running the checks.
+ */
+
+void v_open(t_text *p_text) /* Start collecting text in memory */
+{
+   if ((p_text->h_file = open_memstream(&p_text->s_data, &p_text->i_length)) == NULL)
+   {
+      v_error("Cannot allocate memory: %s\n", strerror(errno));
+      exit(-1);
+   }
+}
+
+void v_done(t_text *p_text) /* Finish collecting text, leaving it in the buffer */
+{
+   if (fclose(p_text->h_file))
+   {
+      v_error("Cannot allocate memory: %s\n", strerror(errno));
+      exit(-1);
+   }
+   p_text->h_file = NULL;
+}
+
+void v_stream(void *p_context, const char *s_text, size_t i_length) /* Collect the text written by the library */
+{
+   fwrite(s_text, 1, i_length, (FILE *) p_context);
+}
+
+void v_loaded(void *p_context, const char *p_data, size_t i_length) /* Collect the bytes loaded by the library */
+{
+   fwrite(p_data, 1, i_length, ((FILE **) p_context)[0]);
+}
+
+void v_listed(void *p_context, const char *s_text, size_t i_length) /* Collect the listing written by the library */
+{
+   fwrite(s_text, 1, i_length, ((FILE **) p_context)[1]);
+}
+
+char *s_path(char *s_case, int i_round, int i_file, char *s_type) /* Name a file used by a check and remember to remove it */
+{
+   char *s_name = p_allocate(strlen(s_directory) + strlen(s_case) + strlen(s_type) + 32);
+
+   sprintf(s_name, "%s/%s.%d.%d.%s", s_directory, s_case, i_round, i_file, s_type);
+   if (i_created < sizeof(a_created) / sizeof(a_created[0])) a_created[i_created++] = s_name;
+   return s_name;
+}
+
+void v_save(char *s_name, const char *p_data, unsigned long ul_length, char b_sparse) /* Write a file, leaving holes in a sparse file where there are zeros */
+{
+   unsigned long ul_done, ul_block;
+   int h_file;
+
+   if ((h_file = open(s_name, O_WRONLY | O_CREAT | O_TRUNC, 0666)) < 0)
+   {
+      v_error("Cannot open %s: %s\n", s_name, strerror(errno));
+      exit(-1);
+   }
+   for (ul_done = 0; ul_done < ul_length; ul_done += ul_block)
+   {
+      ul_block = (ul_length - ul_done < 65536) ? ul_length - ul_done : 65536;
+      if (b_sparse && !p_data[ul_done] && !memcmp(p_data + ul_done, p_data + ul_done + 1, ul_block - 1))
+         continue; /* Skip a block that is all zeros */
+      if (pwrite(h_file, p_data + ul_done, ul_block, ul_done) != ul_block)
+      {
+         v_error("Cannot write %s: %s\n", s_name, strerror(errno));
+         exit(-1);
+      }
+   }
+   if (ftruncate(h_file, ul_length) || close(h_file))
+   {
+      v_error("Cannot write %s: %s\n", s_name, strerror(errno));
+      exit(-1);
+   }
+}
+
+char *s_slurp(char *s_name, size_t *i_length) /* Read the whole of a file, returns NULL if it can't be read */
+{
+   struct stat t_file_d;
+   char *s_data;
+   FILE *h_file;
+
+   if ((h_file = fopen(s_name, "rb")) == NULL) return NULL;
+   if (fstat(fileno(h_file), &t_file_d))
+   {
+      fclose(h_file);
+      return NULL;
+   }
+   s_data = p_allocate(t_file_d.st_size);
+   *i_length = fread(s_data, 1, t_file_d.st_size, h_file);
+   fclose(h_file);
+   return s_data;
+}
+
+void v_show(const char *s_label, const char *p_data, size_t i_length, size_t i_offset) /* Show the line where two outputs differ */
+{
+   size_t i_first = i_offset, i_last = i_offset;
+
+   while (i_first > 0 && p_data[i_first - 1] != '\n' && i_offset - i_first < 60) i_first--;
+   while (i_last < i_length && p_data[i_last] != '\n' && i_last - i_first < 100) i_last++;
+   fprintf(stdout, "    %-10s ", s_label);
+   for (; i_first < i_last; i_first++)
+      fputc(isprint((unsigned char) p_data[i_first]) ? p_data[i_first] : (p_data[i_first] == '\t') ? '>' : '.', stdout);
+   fprintf(stdout, "%s\n", i_last >= i_length ? " <end>" : "");
+}
+
+int i_same(const char *s_what, const char *p_expected, size_t i_expected, const char *p_actual, size_t i_actual) /* Compare some output with the reference, returns false if they differ */
+{
+   size_t i_offset, i_line = 1;
+
+   for (i_offset = 0; i_offset < i_expected && i_offset < i_actual && p_expected[i_offset] == p_actual[i_offset]; i_offset++)
+      if (p_expected[i_offset] == '\n') i_line++;
+   if (i_offset == i_expected && i_offset == i_actual) return true;
+   fprintf(stdout, "  %s differs from the reference at byte %lu, line %lu (%lu bytes expected, %lu written)\n",
+      s_what, (unsigned long) i_offset, (unsigned long) i_line, (unsigned long) i_expected, (unsigned long) i_actual);
+   v_show("expected:", p_expected, i_expected, i_offset);
+   v_show("written:", p_actual, i_actual, i_offset);
+   return false;
+}
+
+int i_compare(const char *s_what, t_text *p_text, char *s_name) /* Compare a file with the reference, returns false if they differ */
+{
+   size_t i_length = 0;
+   char *s_data;
+   int b_same;
+
+   if ((s_data = s_slurp(s_name, &i_length)) == NULL)
+   {
+      fprintf(stdout, "  Cannot read %s: %s\n", s_name, strerror(errno));
+      return false;
+   }
+   b_same = i_same(s_what, p_text->s_data, p_text->i_length, s_data, i_length);
+   free(s_data);
+   return b_same;
+}
+
+void v_feed(char *s_fifo, char *s_name) /* Write a file to a named pipe in pieces of any size, in a process of its own */
+{
+   char a_buffer[65536];
+   size_t i_length, i_done;
+   ssize_t i_written;
+   FILE *h_file;
+   int h_fifo;
+
+   signal(SIGPIPE, SIG_DFL);
+   if ((h_fifo = open(s_fifo, O_WRONLY)) < 0 || (h_file = fopen(s_name, "rb")) == NULL) _exit(1);
+   while ((i_length = fread(a_buffer, 1, 1 + ul_pick(sizeof(a_buffer)), h_file)) > 0)
+      for (i_done = 0; i_done < i_length; i_done += i_written)
+         if ((i_written = write(h_fifo, a_buffer + i_done, i_length - i_done)) < 0) _exit(1);
+   _exit(0);
+}
+
+int i_run(char **a_args, char *s_fifo, char *s_input, char *s_output, char *s_errors) /* Run a program, feeding a named pipe from a file if needed, returns the exit status or -1 if it didn't finish */
+{
+   pid_t t_child, t_feeder = 0;
+   int i_status, h_file, i_count;
+
+   if (b_verbose)
+   {
+      for (i_count = 0; a_args[i_count] != NULL; i_count++) fprintf(stdout, "%s%s", i_count ? " " : "  ", a_args[i_count]);
+      fprintf(stdout, "\n");
+   }
+   fflush(stdout);
+   if (s_fifo != NULL && (t_feeder = fork()) == 0) v_feed(s_fifo, s_input);
+   if (t_feeder < 0 || (t_child = fork()) < 0)
+   {
+      v_error("Cannot run %s: %s\n", a_args[0], strerror(errno));
+      exit(-1);
+   }
+   if (t_child == 0)
+   {
+      if ((h_file = open(s_output, O_WRONLY | O_CREAT | O_TRUNC, 0666)) >= 0) dup2(h_file, 1);
+      if ((h_file = open(s_errors, O_WRONLY | O_CREAT | O_TRUNC, 0666)) >= 0) dup2(h_file, 2);
+      alarm(TIME_LIMIT); /* Don't wait for ever if the program hangs */
+      execv(a_args[0], a_args);
+      _exit(127);
+   }
+   while (waitpid(t_child, &i_status, 0) < 0)
+      if (errno != EINTR) return -1;
+   if (t_feeder > 0)
+   {
+      if (!WIFEXITED(i_status)) kill(t_feeder, SIGKILL); /* Nothing is reading the pipe */
+      while (waitpid(t_feeder, NULL, 0) < 0 && errno == EINTR);
+   }
+   if (WIFSIGNALED(i_status))
+      fprintf(stdout, "  %s was stopped by signal %d (%s)\n", a_args[0], WTERMSIG(i_status), strsignal(WTERMSIG(i_status)));
+   else if (WEXITSTATUS(i_status) == 127)
+      fprintf(stdout, "  Cannot run %s\n", a_args[0]);
+   else
+      return WEXITSTATUS(i_status);
+   return -1;
+}
+
+void v_errors(char *s_errors) /* Show the first few lines written to standard error by a program that failed */
+{
+   char s_line[LINE_SIZE];
+   FILE *h_file;
+   int i_lines = 0;
+
+   if ((h_file = fopen(s_errors, "r")) == NULL) return;
+   while (fgets(s_line, sizeof(s_line), h_file) != NULL && i_lines++ < 20)
+      fprintf(stdout, "    %s%s", s_line, strchr(s_line, '\n') ? "" : "\n");
+   fclose(h_file);
+}
+
+pid_t t_listen(char *s_program, char *s_socket, char *s_errors) /* Start 'hexd' and wait until it accepts connections, returns its process id or -1 if it didn't start */
+{
+   char *a_args[] = {s_program, s_socket, NULL};
+   struct sockaddr_un t_address;
+   pid_t t_server;
+   int h_file, h_socket, i_count;
+
+   if (b_verbose) fprintf(stdout, "  %s %s &\n", s_program, s_socket);
+   fflush(stdout);
+   if ((t_server = fork()) < 0)
+   {
+      v_error("Cannot run %s: %s\n", s_program, strerror(errno));
+      exit(-1);
+   }
+   if (t_server == 0)
+   {
+      if ((h_file = open(s_errors, O_WRONLY | O_CREAT | O_TRUNC, 0666)) >= 0)
+      {
+         dup2(h_file, 1);
+         dup2(h_file, 2);
+      }
+      alarm(TIME_LIMIT); /* Don't wait for ever if the server is never stopped */
+      execv(s_program, a_args);
+      _exit(127);
+   }
+   memset(&t_address, 0, sizeof(t_address));
+   t_address.sun_family = AF_UNIX;
+   strncpy(t_address.sun_path, s_socket, sizeof(t_address.sun_path) - 1);
+   for (i_count = 0; i_count < 100 * SERVER_WAIT && waitpid(t_server, NULL, WNOHANG) == 0; i_count++)
+   {
+      if ((h_socket = socket(AF_UNIX, SOCK_SEQPACKET, 0)) < 0)
+      {
+         v_error("Cannot create socket: %s\n", strerror(errno));
+         exit(-1);
+      }
+      if (!connect(h_socket, (struct sockaddr *) &t_address, sizeof(t_address)))
+      {
+         close(h_socket);
+         return t_server;
+      }
+      close(h_socket);
+      usleep(10000);
+   }
+   fprintf(stdout, "  %s did not start listening on %s\n", s_program, s_socket);
+   v_errors(s_errors);
+   if (!kill(t_server, SIGKILL)) waitpid(t_server, NULL, 0);
+   return -1;
+}
+
+void v_requests(char *s_requests, char **a_args, int i_words, int i_files, char **a_inputs, char **a_outputs) /* Write a request to 'hexd' for each file, made from the words of the command line that came before the file names */
+{
+   FILE *h_file;
+   int i_count, i_word;
+
+   if ((h_file = fopen(s_requests, "w")) == NULL)
+   {
+      v_error("Cannot open %s: %s\n", s_requests, strerror(errno));
+      exit(-1);
+   }
+   for (i_count = 0; i_count < i_files; i_count++)
+   {
+      for (i_word = 1; i_word < i_words; i_word++) fprintf(h_file, "%s ", a_args[i_word]);
+      if (strcmp(a_args[1], "verify")) /* Only checking the records doesn't write anything */
+         fprintf(h_file, "%s %s\n", a_inputs[i_count], a_outputs[i_count]);
+      else
+         fprintf(h_file, "%s\n", a_inputs[i_count]);
+   }
+   if (fclose(h_file))
+   {
+      v_error("Cannot write %s: %s\n", s_requests, strerror(errno));
+      exit(-1);
+   }
+}
+
+int i_replies(char *s_output, int i_files, char **a_inputs, unsigned long *a_errors, unsigned long *a_bytes) /* Compare the replies printed by the 'hexd' client with the errors and bytes expected, returns false if any differ */
+{
+   char s_line[LINE_SIZE];
+   unsigned long ul_records, ul_errors, ul_bytes;
+   FILE *h_file;
+   int i_count, i_length, b_same = true;
+
+   if ((h_file = fopen(s_output, "r")) == NULL)
+   {
+      fprintf(stdout, "  Cannot read %s: %s\n", s_output, strerror(errno));
+      return false;
+   }
+   for (i_count = 0; i_count < i_files && b_same; i_count++) /* Replies are printed in the order the requests were sent */
+   {
+      i_length = strlen(a_inputs[i_count]);
+      if (fgets(s_line, sizeof(s_line), h_file) == NULL || strncmp(s_line, a_inputs[i_count], i_length) ||
+         sscanf(s_line + i_length, ": ok %lu %lu %lu", &ul_records, &ul_errors, &ul_bytes) != 3)
+      {
+         fprintf(stdout, "  Unexpected reply for %s: %s", a_inputs[i_count], feof(h_file) ? "nothing\n" : s_line);
+         b_same = false;
+      }
+      else if (ul_errors != a_errors[i_count] || ul_bytes != a_bytes[i_count])
+      {
+         fprintf(stdout, "  %lu errors and %lu bytes reported for %s instead of %lu and %lu\n", ul_errors, ul_bytes, a_inputs[i_count],
+            a_errors[i_count], a_bytes[i_count]);
+         b_same = false;
+      }
+   }
+   fclose(h_file);
+   return b_same;
+}
+
+unsigned long ul_address(t_settings *p_settings, unsigned long ul_length) /* Choose a load address that leaves room for some bytes */
+{
+   unsigned long ul_limit = p_settings->b_segment ? 0xFFFFFUL : 0xFFFFFFFFUL; /* Highest address that can be used */
+   unsigned long ul_load;
+
+   switch (ul_pick(7))
+   {
+   case 0: ul_load = 0; break;
+   case 1: ul_load = LOAD_ADDRESS; break;
+   case 2: ul_load = ul_pick(0x10000); break;
+   case 3: ul_load = 0x10000 - ul_pick(512); break; /* Just below a 64K boundary */
+   case 4: ul_load = 0x10000 * (1 + ul_pick(15)) - ul_pick(512); break;
+   case 5: ul_load = 0x1000000 - ul_pick(1024) - ul_length; break; /* 'S' records need another address byte */
+   default: ul_load = ull_random() & ul_limit; break;
+   }
+   if (ul_length > ul_limit) return 0;
+   if (ul_load > ul_limit + 1 - ul_length) ul_load = ul_limit + 1 - ul_length; /* Every byte must have an address */
+   return ul_load;
+}
+
+int i_args(t_case *p_case, t_settings *p_settings, unsigned long ul_longest, char **a_args, char *s_values) /* Choose the settings for an input and make the command line, returns the number of words */
+{
+   int i_count, i_args = 0;
+   char *s_option;
+
+   memset(p_settings, 0, sizeof(t_settings));
+   p_settings->i_format = HEX_INTEL;
+   p_settings->i_filler = -1;
+   p_settings->ul_load = LOAD_ADDRESS;
+   p_settings->i_tabs = 8;
+   for (i_count = 0; (s_option = p_case->a_options[i_count]) != NULL; i_count++) /* Settings given by the case */
+   {
+      if (p_case->i_reference == DUMP)
+      {
+         if (!strcmp(s_option, "-a")) p_settings->b_aflag = true, p_settings->b_cflag = false;
+         if (!strcmp(s_option, "-b")) p_settings->b_bflag = true;
+         if (!strcmp(s_option, "-c")) p_settings->b_cflag = true, p_settings->b_aflag = false;
+      }
+      if (p_case->i_reference == DETAB || p_case->i_reference == ENTAB)
+      {
+         if (!strcmp(s_option, "-u")) p_settings->b_utf8 = true;
+         if (!strcmp(s_option, "-l")) p_settings->i_language = strcmp(p_case->a_options[i_count + 1], "asm") ? LANGUAGE_C : LANGUAGE_ASM;
+      }
+      if (p_case->i_reference == REHEX && !strcmp(s_option, "-s")) p_settings->i_format = HEX_MOTOROLA;
+      if (p_case->i_reference == UNLOAD)
+      {
+         if (!strcmp(s_option, "-s")) p_settings->i_format = HEX_MOTOROLA;
+         if (!strcmp(s_option, "-i")) p_settings->i_format = HEX_SOURCE;
+         if (!strcmp(s_option, "-x")) p_settings->b_segment = true;
+         if (!strcmp(s_option, "-f")) p_settings->i_filler = atoi(p_case->a_options[i_count + 1]);
+      }
+   }
+   if (p_case->i_vary & VARY_FORMAT)
+   {
+      p_settings->i_format = ul_pick(3);
+      p_settings->b_segment = (p_settings->i_format == HEX_INTEL && !ul_pick(3));
+      if (p_case->s_program != NULL && p_settings->i_format != HEX_INTEL) /* The library is given the format directly */
+         a_args[i_args++] = (p_settings->i_format == HEX_MOTOROLA) ? "-s" : "-i";
+      if (p_case->s_program != NULL && p_settings->b_segment)
+         a_args[i_args++] = "-x";
+   }
+   p_settings->i_size = (p_settings->i_format == HEX_SOURCE) ? SOURCE_SIZE : HEX_SIZE;
+   if (p_case->i_vary & VARY_SIZE)
+   {
+      switch (ul_pick(4))
+      {
+      case 0: p_settings->i_size = 1 << ul_pick(8); break;
+      case 1: p_settings->i_size = HEX_RECORD_MAX; break;
+      default: p_settings->i_size = 1 + ul_pick(HEX_RECORD_MAX); break;
+      }
+      if (p_settings->i_format == HEX_MOTOROLA && p_settings->i_size > HEX_MOTOROLA_MAX) p_settings->i_size = HEX_MOTOROLA_MAX;
+      a_args[i_args++] = "-r";
+      a_args[i_args++] = s_values;
+      s_values += sprintf(s_values, "%d", p_settings->i_size) + 1;
+   }
+   if (p_case->i_vary & VARY_LOAD)
+   {
+      p_settings->ul_load = ul_address(p_settings, ul_longest);
+      a_args[i_args++] = "-a";
+      a_args[i_args++] = s_values;
+      s_values += sprintf(s_values, "0x%lX", p_settings->ul_load) + 1;
+   }
+   if ((p_case->i_vary & VARY_FILL) && p_settings->i_format != HEX_SOURCE) /* Every byte must be in an array */
+   {
+      p_settings->i_filler = ul_pick(4) ? ((ul_pick(2) ? 0x00 : 0xFF)) : ul_pick(256);
+      a_args[i_args++] = "-f";
+      a_args[i_args++] = s_values;
+      s_values += sprintf(s_values, "%d", p_settings->i_filler) + 1;
+   }
+   if ((p_case->i_vary & VARY_START) && ul_pick(2))
+   {
+      p_settings->b_start = true;
+      p_settings->ul_start = ull_random() & (p_settings->b_segment ? 0xFFFFFUL : 0xFFFFFFFFUL);
+      a_args[i_args++] = "-t";
+      a_args[i_args++] = s_values;
+      s_values += sprintf(s_values, "0x%lX", p_settings->ul_start) + 1;
+   }
+   if (p_case->i_vary & VARY_LENGTH) /* 'rehex' leaves room for a four byte address itself */
+   {
+      i_count = ul_pick(4) ? 1 + ul_pick(HEX_RECORD_MAX) : HEX_RECORD_MAX;
+      p_settings->i_size = (p_settings->i_format == HEX_MOTOROLA && i_count > HEX_MOTOROLA_MAX) ? HEX_MOTOROLA_MAX : i_count;
+      a_args[i_args++] = "-l";
+      a_args[i_args++] = s_values;
+      s_values += sprintf(s_values, "%d", i_count) + 1;
+   }
+   if ((p_case->i_vary & VARY_OFFSET) && ul_pick(2)) /* Addresses in the input leave room for this */
+   {
+      p_settings->ul_offset = ul_pick(0x10000000);
+      a_args[i_args++] = "-o";
+      a_args[i_args++] = s_values;
+      s_values += sprintf(s_values, "0x%lX", p_settings->ul_offset) + 1;
+   }
+   if (p_case->i_vary & VARY_TABS)
+   {
+      p_settings->i_tabs = 1 + ul_pick(12);
+      a_args[i_args++] = "-t";
+      a_args[i_args++] = s_values;
+      s_values += sprintf(s_values, "%d", p_settings->i_tabs) + 1;
+   }
+   if (p_case->i_vary & VARY_LIST)
+   {
+      p_settings->i_tabs = 0;
+      p_settings->i_stops = 1 + ul_pick(STOPS_MAX);
+      a_args[i_args++] = "-t";
+      a_args[i_args++] = s_values;
+      for (i_count = 0; i_count < p_settings->i_stops; i_count++)
+      {
+         p_settings->a_stops[i_count] = (i_count ? p_settings->a_stops[i_count - 1] : 0) + 1 + ul_pick(12);
+         s_values += sprintf(s_values, "%s%lu", i_count ? "," : "", p_settings->a_stops[i_count]);
+      }
+      if (p_settings->i_stops == 1) /* A single value would be the distance between the stops */
+      {
+         p_settings->a_stops[p_settings->i_stops++] = p_settings->a_stops[0] + 1 + ul_pick(12);
+         s_values += sprintf(s_values, ",%lu", p_settings->a_stops[1]);
+      }
+      s_values++;
+   }
+   return i_args;
+}
+
+void v_reference(t_case *p_case, t_settings *p_settings, char *s_input, char *s_name, unsigned long ul_length, t_text *p_text, t_text *p_bytes) /* Write the expected output for a file */
+{
+   FILE *h_file;
+
+   if ((h_file = fopen(s_input, "rb")) == NULL)
+   {
+      v_error("Cannot open %s: %s\n", s_input, strerror(errno));
+      exit(-1);
+   }
+   ul_expected = 0;
+   switch (p_case->i_reference)
+   {
+   case DUMP:
+      v_ref_dump(h_file, p_text->h_file, LOAD_ADDRESS, p_settings);
+      break;
+   case UNLOAD: /* 'S' records use the fewest address bytes they can, unless the size of the file is unknown */
+      p_settings->i_width = i_hex_width(p_settings->ul_load + (ul_length ? ul_length - 1 : 0));
+      if (p_case->i_method == FIFO) p_settings->i_width = 4;
+      if (p_settings->i_format == HEX_INTEL && !p_settings->b_segment && p_settings->i_size == BUFFER_SIZE && p_settings->ul_load == LOAD_ADDRESS &&
+         p_settings->i_filler < 0 && !p_settings->b_start && ul_length <= 0x10000 - LOAD_ADDRESS) /* Only options the original had */
+         v_ref_unload(h_file, p_text->h_file, LOAD_ADDRESS);
+      else
+         v_new_unload(h_file, p_text->h_file, s_name, p_settings);
+      break;
+   case LOAD: /* The original counted errors in a different way */
+      i_ref_load(h_file, p_bytes->h_file, p_text->h_file, LOAD_ADDRESS);
+      rewind(h_file);
+      ul_expected = ul_new_errors(h_file);
+      break;
+   case DETAB:
+      if (p_settings->i_tabs == TAB_WIDTH && !p_settings->b_utf8)
+         v_ref_detab(h_file, p_text->h_file);
+      else
+         v_new_detab(h_file, p_text->h_file, p_settings);
+      break;
+   case ENTAB:
+      if (p_settings->i_tabs == TAB_WIDTH && !p_settings->b_utf8 && !p_settings->i_language)
+         v_ref_entab(h_file, p_text->h_file);
+      else
+         v_new_entab(h_file, p_text->h_file, p_settings);
+      break;
+   case REHEX:
+      v_new_rehex(h_file, p_text->h_file, p_settings);
+      break;
+   }
+   fclose(h_file);
+}
+
+void v_make(t_case *p_case, char *s_name, unsigned long ul_length) /* Make an input file */
+{
+   char *s_data;
+   t_text t_text;
+   t_settings t_image;
+   FILE *h_file;
+
+   if (p_case->i_kind == RECORDS)
+   {
+      v_open(&t_text);
+      v_records(t_text.h_file, ul_length);
+      v_done(&t_text);
+      v_save(s_name, t_text.s_data, t_text.i_length, false);
+      free(t_text.s_data);
+      return;
+   }
+   s_data = p_allocate(ul_length);
+   if (p_case->i_kind == TEXT || p_case->i_kind == UTF8)
+      v_text(s_data, ul_length, p_case->i_kind);
+   else if (p_case->i_kind == CODE)
+      v_code(s_data, ul_length);
+   else
+      v_binary((unsigned char *) s_data, ul_length);
+   if (p_case->i_kind == SPARSE && ul_length > 0) /* Mostly holes with a little data */
+      memset(s_data + ul_length / 8, 0, ul_length - ul_length / 4);
+   v_save(s_name, s_data, ul_length, p_case->i_kind == SPARSE);
+   free(s_data);
+   if (p_case->i_kind == IMAGE) /* Replace the bytes with records written by the reference */
+   {
+      memset(&t_image, 0, sizeof(t_image));
+      t_image.i_format = ul_pick(2) ? HEX_INTEL : HEX_MOTOROLA;
+      t_image.b_segment = (t_image.i_format == HEX_INTEL && !ul_pick(3));
+      t_image.i_size = 1 + ul_pick((t_image.i_format == HEX_MOTOROLA) ? HEX_MOTOROLA_MAX : HEX_RECORD_MAX);
+      t_image.i_filler = ul_pick(2) ? -1 : ul_pick(2) ? 0x00 : 0xFF;
+      t_image.ul_load = ul_address(&t_image, ul_length) & 0x0FFFFFFFUL; /* Leave room for an offset */
+      t_image.i_width = i_hex_width(t_image.ul_load + (ul_length ? ul_length - 1 : 0));
+      t_image.b_start = ul_pick(2);
+      t_image.ul_start = ull_random() & (t_image.b_segment ? 0xFFFFFUL : 0x0FFFFFFFUL);
+      if ((h_file = fopen(s_name, "rb")) == NULL)
+      {
+         v_error("Cannot open %s: %s\n", s_name, strerror(errno));
+         exit(-1);
+      }
+      v_open(&t_text);
+      if (!ul_pick(4)) fputs("Some text that isn't a record\n", t_text.h_file); /* Starts with an 'S' but must be skipped */
+      v_new_unload(h_file, t_text.h_file, s_name, &t_image);
+      fclose(h_file);
+      v_done(&t_text);
+      v_save(s_name, t_text.s_data, t_text.i_length, false);
+      free(t_text.s_data);
+   }
+}
+
+void v_change(char *s_name, unsigned long *ul_length) /* Change a few bytes of a file, and sometimes its length */
+{
+   size_t i_length = 0;
+   char *s_data = s_slurp(s_name, &i_length);
+   int i_changes;
+
+   if (s_data == NULL)
+   {
+      v_error("Cannot read %s: %s\n", s_name, strerror(errno));
+      exit(-1);
+   }
+   for (i_changes = ul_pick(4); i_changes > 0 && i_length > 0; i_changes--)
+      s_data[ul_pick(i_length)] ^= 1 + ul_pick(255);
+   if (!ul_pick(4)) i_length -= ul_pick(i_length + 1); /* Shorter */
+   else if (!ul_pick(4)) /* Longer */
+   {
+      i_changes = 1 + ul_pick(1024);
+      s_data = realloc(s_data, i_length + i_changes);
+      if (s_data == NULL)
+      {
+         v_error("Cannot allocate memory: %s\n", strerror(errno));
+         exit(-1);
+      }
+      v_binary((unsigned char *) s_data + i_length, i_changes);
+      i_length += i_changes;
+   }
+   v_save(s_name, s_data, i_length, false);
+   *ul_length = i_length;
+   free(s_data);
+}
+
+char *s_delta(char *s_name, t_settings *p_settings) /* Name of the file written by 'unload -d' */
+{
+   char *s_output = p_allocate(strlen(s_name) + 8);
+   char *s_type;
+
+   strcpy(s_output, s_name);
+   if ((s_type = strrchr(s_output, '.')) == NULL || strchr(s_type, '/') != NULL) s_type = s_output + strlen(s_output);
+   strcpy(s_type, (p_settings->i_format == HEX_SOURCE) ? ".c" : (p_settings->i_format == HEX_MOTOROLA) ? ".srec" : ".hex");
+   return s_output;
+}
+
+int i_library(t_case *p_case, t_settings *p_settings, char *s_input, unsigned long ul_length, t_text *p_text, t_text *p_bytes) /* Call the library in pieces of random sizes, returns false if the output differs */
+{
+   unsigned long ul_offset, ul_end;
+   size_t i_length = 0, i_piece, i_buffer;
+   char *s_data, *s_buffer;
+   t_encoder t_encoder;
+   t_decoder t_decoder;
+   t_chunk t_chunk;
+   t_text t_list, t_loaded;
+   FILE *a_files[2];
+   unsigned long ul_errors;
+   int b_same;
+
+   if ((s_data = s_slurp(s_input, &i_length)) == NULL)
+   {
+      v_error("Cannot read %s: %s\n", s_input, strerror(errno));
+      exit(-1);
+   }
+   v_open(&t_list);
+   if (p_case->i_method == DECODE)
+   {
+      v_open(&t_loaded);
+      a_files[0] = t_loaded.h_file; /* Bytes and the listing go to different places */
+      a_files[1] = t_list.h_file;
+      s_buffer = p_allocate(i_buffer = 1 + ul_pick(ul_pick(2) ? 16 : 65536)); /* Buffers of any size are passed on when they are full */
+      v_hex_decoder(&t_decoder, s_buffer, i_buffer, v_loaded, v_listed, a_files);
+      for (ul_offset = 0; ul_offset < i_length; ul_offset += i_piece)
+      {
+         i_piece = 1 + ul_pick(ul_pick(2) ? 8 : 100000);
+         if (i_piece > i_length - ul_offset) i_piece = i_length - ul_offset;
+         v_hex_decode(&t_decoder, s_data + ul_offset, i_piece);
+      }
+      ul_errors = ul_hex_flush(&t_decoder);
+      v_done(&t_loaded);
+      v_done(&t_list);
+      b_same = i_same("bytes loaded", p_bytes->s_data, p_bytes->i_length, t_loaded.s_data, t_loaded.i_length) &
+         i_same("listing", p_text->s_data, p_text->i_length, t_list.s_data, t_list.i_length);
+      if (ul_errors != ul_expected)
+      {
+         fprintf(stdout, "  %lu errors found instead of %lu\n", ul_errors, ul_expected);
+         b_same = false;
+      }
+      free(t_loaded.s_data);
+      free(t_list.s_data);
+      free(s_buffer);
+      free(s_data);
+      return b_same;
+   }
+   s_buffer = p_allocate(i_buffer = HEX_BUFFER_MIN + ul_pick(65536));
+   v_hex_encoder(&t_encoder, s_buffer, i_buffer, v_stream, t_list.h_file);
+   t_encoder.i_format = p_settings->i_format;
+   t_encoder.i_size = p_settings->i_size;
+   t_encoder.i_width = p_settings->i_width;
+   t_encoder.i_filler = p_settings->i_filler;
+   t_encoder.b_segment = p_settings->b_segment;
+   t_encoder.b_start = p_settings->b_start;
+   t_encoder.ul_load = p_settings->ul_load;
+   t_encoder.ul_start = p_settings->ul_start;
+   v_hex_begin(&t_encoder, s_input);
+   if (p_case->i_method == ENCODE) /* Any number of bytes at a time */
+   {
+      for (ul_offset = 0; ul_offset < i_length; ul_offset += i_piece)
+      {
+         i_piece = ul_pick(ul_pick(2) ? 40 : 100000);
+         if (i_piece > i_length - ul_offset) i_piece = i_length - ul_offset;
+         i_hex_encode(&t_encoder, (unsigned char *) s_data + ul_offset, i_piece);
+      }
+   }
+   else /* Whole records at a time, the way 'unload' does it */
+   {
+      t_chunk.s_output = p_allocate(i_hex_capacity(&t_encoder, 2 * CHUNK_SIZE));
+      for (ul_offset = 0; ul_offset < i_length; ul_offset = ul_end)
+      {
+         ul_end = ul_hex_align(&t_encoder, p_settings->ul_load + ul_offset + ul_pick(ul_pick(2) ? 1024 : CHUNK_SIZE)) - p_settings->ul_load;
+         if (ul_end <= ul_offset) ul_end = ul_hex_align(&t_encoder, p_settings->ul_load + ul_offset + p_settings->i_size) - p_settings->ul_load;
+         if (ul_end > i_length) ul_end = i_length;
+         v_hex_format(&t_encoder, &t_chunk, (unsigned char *) s_data + ul_offset, p_settings->ul_load + ul_offset, ul_end - ul_offset);
+         i_hex_write(&t_encoder, &t_chunk);
+      }
+      t_encoder.ul_address = p_settings->ul_load + i_length;
+      free(t_chunk.s_output);
+   }
+   i_hex_end(&t_encoder);
+   v_done(&t_list);
+   b_same = i_same("records", p_text->s_data, p_text->i_length, t_list.s_data, t_list.i_length);
+   free(t_list.s_data);
+   free(s_buffer);
+   free(s_data);
+   return b_same;
+}
+
+int i_verify(char *s_output, char *s_input) /* Read the records written by a program back with the library, returns false if they load different bytes or have errors */
+{
+   size_t i_length = 0, i_expected = 0;
+   char *s_records, *s_data, a_buffer[HEX_BUFFER_MIN];
+   unsigned long ul_errors;
+   t_decoder t_decoder;
+   t_text t_loaded;
+   int b_same;
+
+   if ((s_records = s_slurp(s_output, &i_length)) == NULL || (s_data = s_slurp(s_input, &i_expected)) == NULL)
+   {
+      fprintf(stdout, "  Cannot read %s: %s\n", s_records == NULL ? s_output : s_input, strerror(errno));
+      free(s_records);
+      return false;
+   }
+   v_open(&t_loaded);
+   v_hex_decoder(&t_decoder, a_buffer, sizeof(a_buffer), v_stream, NULL, t_loaded.h_file);
+   v_hex_decode(&t_decoder, s_records, i_length);
+   ul_errors = ul_hex_flush(&t_decoder);
+   v_done(&t_loaded);
+   b_same = i_same("bytes read back", s_data, i_expected, t_loaded.s_data, t_loaded.i_length);
+   if (ul_errors)
+   {
+      fprintf(stdout, "  %lu errors found reading the records back\n", ul_errors);
+      b_same = false;
+   }
+   free(t_loaded.s_data);
+   free(s_records);
+   free(s_data);
+   return b_same;
+}
+
+int i_check(t_case *p_case, int i_round) /* Check one input, or several for some cases, returns false if the output differs */
+{
+   char *a_args[ARGS_MAX], *a_inputs[FILES_MAX], *a_names[FILES_MAX], *a_outputs[FILES_MAX];
+   char s_values[LINE_SIZE], s_program[LINE_SIZE];
+   unsigned long a_lengths[FILES_MAX], a_errors[FILES_MAX], a_bytes[FILES_MAX], ul_longest = 0;
+   char *s_output, *s_errors, *s_fifo = NULL, *s_result = NULL, *s_socket = NULL, *s_requests, *s_log = NULL;
+   int i_files = 1, i_count, i_arg = 0, i_words, i_pass, i_status, b_same = true;
+   char b_each = (p_case->i_method == INPLACE || p_case->i_method == CHECK || p_case->i_method == SERVER); /* Each file has its own output */
+   char b_changed = false, b_failed = false;
+   pid_t t_server = 0;
+   t_settings t_settings;
+   t_text a_expected[FILES_MAX], a_original[FILES_MAX], t_bytes;
+
+   if (p_case->i_method == SEVERAL || b_each) i_files = 1 + ul_pick(FILES_MAX); /* Small files are batched together */
+   for (i_count = 0; i_count < i_files; i_count++)
+   {
+      a_lengths[i_count] = ul_length(p_case, i_count ? i_round + 1 : i_round);
+      if (a_lengths[i_count] > ul_longest) ul_longest = a_lengths[i_count];
+      a_inputs[i_count] = a_names[i_count] = s_path(p_case->s_name, i_round, i_count, a_types[p_case->i_kind]);
+      v_make(p_case, a_inputs[i_count], a_lengths[i_count]);
+   }
+   snprintf(s_program, sizeof(s_program), "%s/%s", s_programs, p_case->s_program ? p_case->s_program : "");
+   a_args[i_arg++] = s_program;
+   for (i_count = 0; p_case->a_options[i_count] != NULL; i_count++) a_args[i_arg++] = p_case->a_options[i_count];
+   i_arg += i_args(p_case, &t_settings, ul_longest, a_args + i_arg, s_values);
+   if (p_case->i_method == FIFO) /* The program reads a named pipe with the same contents */
+   {
+      a_names[0] = s_fifo = s_path(p_case->s_name, i_round, 0, "fifo");
+      if (mkfifo(s_fifo, 0666))
+      {
+         v_error("Cannot create %s: %s\n", s_fifo, strerror(errno));
+         exit(-1);
+      }
+   }
+   i_words = i_arg;
+   for (i_count = 0; i_count < i_files; i_count++) a_args[i_arg++] = a_names[i_count];
+   a_args[i_arg] = NULL;
+   s_output = s_path(p_case->s_name, i_round, 0, "out");
+   s_errors = s_path(p_case->s_name, i_round, 0, "err");
+   if (p_case->i_method == SERVER) /* The client sends a request for each file to the server */
+   {
+      for (i_count = 0; i_count < i_files; i_count++)
+         a_outputs[i_count] = s_path(p_case->s_name, i_round, i_count, (p_case->i_reference == LOAD) ? "com" : "rec");
+      s_requests = s_path(p_case->s_name, i_round, 0, "req");
+      v_requests(s_requests, a_args, i_words, i_files, a_inputs, a_outputs);
+      a_args[1] = "--client";
+      a_args[2] = s_socket = s_path(p_case->s_name, i_round, 0, "sock");
+      a_args[3] = s_requests;
+      a_args[4] = NULL;
+      s_log = s_path(p_case->s_name, i_round, 0, "log");
+   }
+   if (p_case->i_reference == LOAD && p_case->s_program != NULL)
+      s_result = s_path(p_case->s_name, i_round, 0, "com"); /* Where 'load' writes the bytes */
+   if (p_case->i_method == DELTA)
+   {
+      s_result = s_delta(a_inputs[0], &t_settings);
+      s_path(p_case->s_name, i_round, 0, (t_settings.i_format == HEX_INTEL) ? "hex.sum" : (t_settings.i_format == HEX_MOTOROLA) ? "srec.sum" : "c.sum");
+      a_created[i_created++] = s_result;
+   }
+
+   for (i_pass = 0; i_pass < ((p_case->i_method == DELTA) ? 2 : 1) && b_same; i_pass++)
+   {
+      if (i_pass) v_change(a_inputs[0], &a_lengths[0]); /* Unchanged records are reused the second time */
+      for (i_count = 0; i_count < i_files; i_count++) /* Expected output of each file, or of all of them together */
+      {
+         if (!i_count || b_each) v_open(&a_expected[i_count]);
+         v_open(&t_bytes);
+         if (p_case->i_method == SERVER && p_case->i_reference == LOAD) /* Only the bytes loaded are written to a file */
+            v_reference(p_case, &t_settings, a_inputs[i_count], a_names[i_count], a_lengths[i_count], &t_bytes, &a_expected[i_count]);
+         else
+            v_reference(p_case, &t_settings, a_inputs[i_count], a_names[i_count], a_lengths[i_count], &a_expected[b_each ? i_count : 0], &t_bytes);
+         v_done(&t_bytes);
+         a_errors[i_count] = ul_expected;
+         b_failed |= (ul_expected > 0);
+         if (i_count < i_files - 1) free(t_bytes.s_data);
+         if (i_count == i_files - 1 || b_each) v_done(&a_expected[b_each ? i_count : 0]);
+         if (p_case->i_method == CHECK) /* Keep what was there to show nothing was replaced */
+         {
+            if ((a_original[i_count].s_data = s_slurp(a_inputs[i_count], &a_original[i_count].i_length)) == NULL)
+            {
+               v_error("Cannot read %s: %s\n", a_inputs[i_count], strerror(errno));
+               exit(-1);
+            }
+            b_changed |= !(a_original[i_count].i_length == a_expected[i_count].i_length &&
+               !memcmp(a_original[i_count].s_data, a_expected[i_count].s_data, a_expected[i_count].i_length));
+         }
+      }
+      for (i_count = 0; i_count < i_files; i_count++) /* Nothing is written when 'hexd' only checks the records */
+         a_bytes[i_count] = strcmp(p_case->a_options[0] ? p_case->a_options[0] : "", "verify") ? a_expected[b_each ? i_count : 0].i_length : 0;
+      if (p_case->i_method == SERVER && (t_server = t_listen(s_program, s_socket, s_log)) < 0)
+         b_same = false;
+      else if (p_case->s_program == NULL)
+         b_same = i_library(p_case, &t_settings, a_inputs[0], a_lengths[0], &a_expected[0], &t_bytes);
+      else if ((i_status = i_run(a_args, s_fifo, a_inputs[0], s_output, s_errors)) < 0 ||
+         (i_status && p_case->i_method != CHECK && p_case->i_method != SERVER))
+      {
+         if (i_status > 0) fprintf(stdout, "  %s failed with status %d\n", a_args[0], i_status);
+         v_errors(s_errors);
+         b_same = false;
+      }
+      else if (p_case->i_method == CHECK) /* The status shows whether any file would change */
+      {
+         for (i_count = 0; i_count < i_files; i_count++)
+            b_same &= i_compare(a_inputs[i_count], &a_original[i_count], a_inputs[i_count]);
+         if (i_status != (b_changed ? 1 : 0))
+         {
+            fprintf(stdout, "  %s returned %d instead of %d\n", a_args[0], i_status, b_changed ? 1 : 0);
+            b_same = false;
+         }
+      }
+      else if (p_case->i_method == SERVER) /* Each request writes its own file, and the replies give the number of errors found */
+      {
+         b_same = i_replies(s_output, i_files, a_inputs, a_errors, a_bytes);
+         for (i_count = 0; i_count < i_files && b_same && strcmp(p_case->a_options[0], "verify"); i_count++)
+            b_same &= i_compare(a_outputs[i_count], &a_expected[i_count], a_outputs[i_count]);
+         if (i_status != (b_failed ? 1 : 0))
+         {
+            fprintf(stdout, "  %s returned %d instead of %d\n", a_args[0], i_status, b_failed ? 1 : 0);
+            b_same = false;
+         }
+      }
+      else if (p_case->i_method == INPLACE) /* Each file is replaced */
+         for (i_count = 0; i_count < i_files; i_count++)
+            b_same &= i_compare(a_inputs[i_count], &a_expected[i_count], a_inputs[i_count]);
+      else if (p_case->i_method == DELTA)
+         b_same = i_compare(s_result, &a_expected[0], s_result);
+      else if (s_result != NULL)
+         b_same = i_compare("listing", &a_expected[0], s_output) & i_compare("bytes loaded", &t_bytes, s_result);
+      else
+         b_same = i_compare("output", &a_expected[0], s_output);
+      if (b_same && p_case->i_method == VERIFY)
+         b_same = i_verify(s_output, a_inputs[0]);
+      if (t_server > 0) /* Stop the server, which removes the socket */
+      {
+         kill(t_server, SIGTERM);
+         while (waitpid(t_server, NULL, 0) < 0 && errno == EINTR);
+      }
+      for (i_count = 0; i_count < (b_each ? i_files : 1); i_count++)
+      {
+         free(a_expected[i_count].s_data);
+         if (p_case->i_method == CHECK) free(a_original[i_count].s_data);
+      }
+      free(t_bytes.s_data);
+   }
+
+   if (!b_same)
+   {
+      fprintf(stdout, "  Check %d of %s failed on", i_round + 1, p_case->s_name);
+      for (i_count = 0; a_args[i_count] != NULL; i_count++) fprintf(stdout, " %s", a_args[i_count]);
+      fprintf(stdout, "\n");
+   }
+   for (i_count = 0; i_count < i_created; i_count++)
+   {
+      if (b_same) remove(a_created[i_count]); /* Keep the files for a check that failed */
+      free(a_created[i_count]);
+   }
+   i_created = 0;
+   return b_same;
+}
+
+int main(int argc, char **argv)
+{
+   char *s_only = NULL;
+   unsigned long long ull_seed = time(NULL);
+   int i_rounds = 50, i_failed = 0, i_cases = 0;
+   int i_count, i_round, i_length;
+   char b_temporary = false;
+   t_case *p_case;
+
+   for (i_count = 1; i_count < argc; i_count++)
+   {
+      i_length = strlen(argv[i_count]);
+      if (argv[i_count][0] != '-')
+      {
+         v_error("unexpected argument %s\nTry '%s --help' for more information.\n", argv[i_count], NAME);
+         exit(-1);
+      }
+      if (!strcmp(argv[i_count], "-?") || (i_length > 2 && !strncmp(argv[i_count], "--help", i_length)))
+         v_about();
+      if (i_length > 2 && !strncmp(argv[i_count], "--version", i_length))
+         v_version();
+      if (!strcmp(argv[i_count], "-v") || (i_length > 2 && !strncmp(argv[i_count], "--verbose", i_length)))
+      {
+         b_verbose = true;
+         continue;
+      }
+      if (i_count + 1 >= argc)
+      {
+         v_error("option requires an argument -- %s\n", argv[i_count]);
+         exit(-1);
+      }
+      if (!strcmp(argv[i_count], "-c") || (i_length > 2 && !strncmp(argv[i_count], "--case", i_length)))
+         s_only = argv[++i_count];
+      else if (!strcmp(argv[i_count], "-d") || (i_length > 2 && !strncmp(argv[i_count], "--directory", i_length)))
+         s_directory = argv[++i_count];
+      else if (!strcmp(argv[i_count], "-n") || (i_length > 2 && !strncmp(argv[i_count], "--rounds", i_length)))
+         i_rounds = atoi(argv[++i_count]);
+      else if (!strcmp(argv[i_count], "-p") || (i_length > 2 && !strncmp(argv[i_count], "--programs", i_length)))
+         s_programs = argv[++i_count];
+      else if (!strcmp(argv[i_count], "-s") || (i_length > 2 && !strncmp(argv[i_count], "--seed", i_length)))
+         ull_seed = strtoull(argv[++i_count], NULL, 0);
+      else
+      {
+         v_error("invalid option %s\nTry '%s --help' for more information.\n", argv[i_count], NAME);
+         exit(-1);
+      }
+   }
+   if (i_rounds < 1)
+   {
+      v_error("invalid number of rounds %d\n", i_rounds);
+      exit(-1);
+   }
+   if (s_directory == NULL) /* Use a new directory that is removed if everything passes */
+   {
+      s_directory = p_allocate(LINE_SIZE);
+      snprintf(s_directory, LINE_SIZE, "%s/%s.XXXXXX", getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp", NAME);
+      if (mkdtemp(s_directory) == NULL)
+      {
+         v_error("Cannot create %s: %s\n", s_directory, strerror(errno));
+         exit(-1);
+      }
+      b_temporary = true;
+   }
+   else if (mkdir(s_directory, 0777) && errno != EEXIST)
+   {
+      v_error("Cannot create %s: %s\n", s_directory, strerror(errno));
+      exit(-1);
+   }
+   signal(SIGPIPE, SIG_IGN); /* A program that stops early must not stop the checks too */
+
+   fprintf(stdout, "Checking with seed %llu\n", ull_seed);
+   for (p_case = a_cases; p_case->s_name != NULL; p_case++)
+   {
+      if (s_only != NULL && strncmp(p_case->s_name, s_only, strlen(s_only))) continue;
+      i_cases++;
+      for (i_round = 0; i_round < i_rounds; i_round++)
+      {
+         ull_state = ull_seed * 0x9E3779B97F4A7C15ULL + (p_case - a_cases) * 0x10000ULL + i_round + 1; /* Each input can be made again on its own */
+         if (!ull_state) ull_state = 1;
+         if (!i_check(p_case, i_round)) break;
+      }
+      fprintf(stdout, "%-18s %6d %s\n", p_case->s_name, i_round < i_rounds ? i_round + 1 : i_rounds, i_round < i_rounds ? "FAILED" : "ok");
+      fflush(stdout);
+      if (i_round < i_rounds) i_failed++;
+   }
+   if (!i_cases)
+   {
+      v_error("no checks match %s\n", s_only);
+      exit(-1);
+   }
+   if (i_failed)
+      fprintf(stdout, "\n%d of %d checks failed, the files used were left in %s\n", i_failed, i_cases, s_directory);
+   else
+   {
+      if (b_temporary) rmdir(s_directory);
+      fprintf(stdout, "\nAll %d checks passed\n", i_cases);
+   }
+   exit(i_failed ? 1 : 0);
+}
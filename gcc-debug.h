@@ -25,6 +25,8 @@
  *                   - Added verbose macro - MT
  * 03 Jan 21         - Changed both macros to allow DEBUG and VERBOSE to be
  *                     defined from the command line - MT
+ * 18 Oct 26         - Added  stats macro to count and time the work  done
+ *                     unless STATS is not defined - MT
  *
  */
 
@@ -44,3 +46,12 @@
 #else
 #define verbose(code)
 #endif
+
+/* Execute code if STATS is defined */
+#ifndef stats /* Don't redefine macro if already defined. */
+#if defined(STATS)
+#define stats(code) do {code;} while(0)
+#else
+#define stats(code)
+#endif
+#endif
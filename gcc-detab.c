@@ -21,6 +21,36 @@
  * with this program.  If not, see <http://www.gnu.org/licenses/>.
  * 
  * 08 Aug 23   0.1   - Initial version - MT   
+ * 18 Oct 26         - Reads  the input in large blocks, copying the  text
+ *                     between  tabs  and  line  breaks  in  one  go  and
+ *                     replacing each tab from a string of spaces  instead
+ *                     of writing one character at a time - MT
+ *                   - Added an option to set the distance between the tab
+ *                     stops or give a list of tab stops - MT
+ *                   - Added  options to process the files in directories
+ *                     using a pool of threads, splitting large files  at
+ *                     line  breaks and batching small files together, and
+ *                     report what was done to each file - MT
+ *                   - Added  an option to replace the contents of  files
+ *                     instead of writing them to standard output, leaving
+ *                     files that would not change alone - MT
+ *                   - Added  an option to report the first line in  each
+ *                     file that would change without writing anything - MT
+ *                   - Added an option to count the columns used by  UTF-8
+ *                     characters,  including  wide  characters,  checking
+ *                     whether each block is plain ASCII first - MT
+ *                   - Uses  the shared input and output module to  read
+ *                     files  and buffer the output, and reports  errors
+ *                     writing standard output - MT
+ *                   - Added '--stats' to print what was done - MT
+ *                   - Don't compare an empty file with a null pointer - MT
+ *                   - '-c' never replaces a file, even with '-i' - MT
+ *                   - Reuses the table of tab stops if '-t' is given more
+ *                     than once - MT
+ *                   - Checks the number of jobs before it is narrowed to
+ *                     an int - MT
+ *                   - Moved  the tab stops, UTF-8 widths and the  pool
+ *                     of threads into a module shared with 'entab' - MT
  * 
  * ToDo:             - Ignore quoted strings and comments!
  * 
@@ -28,13 +58,13 @@
 
 #define  NAME        "gcc-detab"
 #define  VERSION     "0.1"
-#define  BUILD       "0001"
+#define  BUILD       "0014"
 #define  AUTHOR      "MT"
 #define  COPYRIGHT   (__DATE__ + 7) /* Extract copyright year from date */
 
 #define  DEBUG
 
-#define  TAB_WIDTH   8
+#define  BLOCK_SIZE  65536                    /* Number of characters read from the file at once */
 
 #define  false       0
 #define  true        !false
@@ -51,8 +81,10 @@
 #include <sys/stat.h>                
 #endif
 #include "gcc-debug.h"
+#include "gcc-io.h"
+#include "gcc-tabs.h"
 
-char b_hflag = false;
+char s_program[] = NAME;
 
 void v_version() /* Display version information */
 {
@@ -69,6 +101,8 @@ void v_about() /* Display help text */
 {
    fprintf(stdout, "Usage: %s [OPTION]... [FILE]...\n", NAME);
    fprintf(stdout, "Displays FILE(s) replacing tabs with spaces.\n\n");
+   fprintf(stdout, "  /statistics              print what was done on exit\n");
+   fprintf(stdout, "  /tabs=N[,N]...           set tab stops every N columns or at a list of columns\n");
    fprintf(stdout, "  /version                 output version information and exit\n");
    fprintf(stdout, "  /?, /help                display this help and exit\n");
    exit(0);
@@ -78,84 +112,135 @@ void v_about() /* Display help text */
 {
    fprintf(stdout, "Usage: %s [OPTION]... [FILE]...\n", NAME);
    fprintf(stdout, "Displays FILE(s) replacing tabs with spaces.\n\n");
+   fprintf(stdout, "  -c, --check              report the first line in each FILE that would change\n");
+   fprintf(stdout, "  -i, --in-place           replace the contents of each FILE that changes\n");
+   fprintf(stdout, "  -j, --jobs N             use N threads to process files\n");
+   fprintf(stdout, "  -p, --pattern GLOB       only process files in directories that match GLOB\n");
+   fprintf(stdout, "  -r, --recursive          process the files in directories and subdirectories\n");
+   fprintf(stdout, "  -s, --sync               flush each replaced FILE to the disk before renaming it\n");
+   fprintf(stdout, "  -t, --tabs N[,N]...      set tab stops every N columns or at a list of columns\n");
+   fprintf(stdout, "  -u, --utf-8              count the columns used by UTF-8 characters\n");
+   fprintf(stdout, "      --stats              print what was done on exit\n");
+   fprintf(stdout, "      --stats-json         print what was done on exit in JSON\n");
    fprintf(stdout, "  -?, --help               display this help and exit\n");
    fprintf(stdout, "      --version            output version information and exit\n");
    exit(0);
 }
 #endif
  
-void v_error(const char *s_fmt, ...) /* Print formatted error message */
+void v_spaces(t_output *p_output, unsigned long ul_count) /* Append a number of spaces */
 {
-   va_list t_args;
-   va_start(t_args, s_fmt);
-   fprintf(stderr, "%s: ", NAME);
-   vfprintf(stderr, s_fmt, t_args);
-   va_end(t_args);
+   static const char s_spaces[] = "                ";
+   unsigned long ul_length;
+
+   for (; ul_count > 0; ul_count -= ul_length)
+   {
+      ul_length = (ul_count < sizeof(s_spaces) - 1) ? ul_count : sizeof(s_spaces) - 1;
+      v_write(p_output, s_spaces, ul_length);
+   }
 }
 
-int i_isfile(char *s_name) /* Return true if path is a file */
+const char *p_newline(const char *p_first, const char *p_last) /* Return the last line break before p_last, or NULL */
 {
-   struct stat t_file_d;
-   stat(s_name, &t_file_d);
-#if defined(VMS)
-   return ((t_file_d.st_mode & S_IFMT) == S_IFREG);
-#else
-   return (S_ISREG(t_file_d.st_mode));
-#endif
+   while (p_last > p_first)
+      if (*--p_last == '\n' || *p_last == '\r') return p_last;
+   return NULL;
 }
 
-int i_isdir(char *s_name) /* Return true if path is a directory */
+static inline unsigned long ul_next(unsigned long ul_offset, int i_columns) /* Return the first tab stop at or after an offset */
 {
-   struct stat t_file_d;
-   stat(s_name, &t_file_d);
-#if defined(VMS)
-   return ((t_file_d.st_mode & S_IFMT) == S_IFDIR);
-#else
-   return (S_ISDIR(t_file_d.st_mode));
-#endif
+   if (i_columns) return ul_offset + (i_columns - ul_offset % i_columns) % i_columns;
+   return (ul_offset < ul_stops) ? a_next[ul_offset] : ul_offset; /* Tabs after the last stop become a single space */
 }
 
-void v_detab(FILE *h_file)
+INLINE void v_replace(t_output *p_output, const char *p_data, size_t i_length, unsigned long *ul_offset, int i_columns) /* Replace the tabs in a block of text */
 {
-   int i_offset = 0;
-   int i_char;
-   
-   while ((i_char = fgetc(h_file)) != EOF)
+   const char *p_end = p_data + i_length;
+   const char *p_tab, *p_break;
+   unsigned long ul_spaces;
+   char b_wide = b_utf8 && !i_ascii(p_data, i_length); /* Count columns a character at a time */
+
+   while (p_data < p_end)
    {
-      if (i_char == '\t')
+      if ((p_tab = memchr(p_data, '\t', p_end - p_data)) == NULL) p_tab = p_end;
+      if (p_tab > p_data) /* Copy the text up to the tab in one go */
       {
-         while (i_offset % 8)
-         {
-            fputc(' ', stdout);
-            i_offset++;
-         }
-         fputc(' ', stdout);
+         v_write(p_output, p_data, p_tab - p_data);
+         if ((p_break = p_newline(p_data, p_tab)) != NULL) /* Columns are counted from the last line break */
+            *ul_offset = b_wide ? ul_width(p_break + 1, p_tab) + 1 : p_tab - p_break;
+         else
+            *ul_offset += b_wide ? ul_width(p_data, p_tab) : p_tab - p_data;
       }
-      else
+      if (p_tab < p_end) /* Pad to the next tab stop and then add one more space */
       {
-         fputc(i_char, stdout);
-         if ((i_char == '\n') || (i_char == '\r')) i_offset = 0;
+         ul_spaces = ul_next(*ul_offset, i_columns) - *ul_offset + 1;
+         v_spaces(p_output, ul_spaces);
+         p_output->ul_count++;
+         *ul_offset += ul_spaces;
+         p_tab++;
       }
-      i_offset++;
+      p_data = p_tab;
+   }
+}
+
+void v_expand(t_output *p_output, const char *p_data, size_t i_length, unsigned long *ul_offset) /* Replace the tabs in a block of text */
+{
+   switch (i_width) /* Let the compiler simplify the arithmetic for the most common tab widths */
+   {
+   case 2: v_replace(p_output, p_data, i_length, ul_offset, 2); break;
+   case 4: v_replace(p_output, p_data, i_length, ul_offset, 4); break;
+   case 8: v_replace(p_output, p_data, i_length, ul_offset, 8); break;
+   default: v_replace(p_output, p_data, i_length, ul_offset, i_width); /* Also handles a list of tab stops */
+   }
+}
+
+void v_detab(t_input *p_input)
+{
+   unsigned long ul_offset = 0;
+   size_t i_held = 0;
+
+   while (i_fill(p_input, i_held) > 0)
+   {
+      i_held = b_utf8 ? i_partial(p_input->s_data, p_input->i_length) : 0; /* Keep an incomplete character for the next block */
+      v_expand(&t_stdout, p_input->s_data, p_input->i_length - i_held, &ul_offset);
    }
+   if (i_held) v_expand(&t_stdout, p_input->s_data, i_held, &ul_offset);
+   i_flush(&t_stdout);
+}
+
+void v_convert(t_output *p_output, const char *p_data, size_t i_length, char b_start) /* Replace the tabs in part of a file that starts on a new line */
+{
+   unsigned long ul_offset = b_start ? 0 : 1;
+
+   v_expand(p_output, p_data, i_length, &ul_offset);
 }
 
+const char *p_check(const char *p_data, size_t i_length) /* Return the first tab, or NULL */
+{
+   return memchr(p_data, '\t', i_length);
+}
 
 int main(int argc, char **argv)
 {
-   FILE *h_file;
-   int i_count, i_index;
+   t_input t_input;
+   t_tabs t_pool = {v_convert, p_check, "tabs replaced", "contains a tab", false}; /* How the threads convert and check each file */
+   long l_jobs = 1; /* Checked before it is narrowed */
+   int i_count, i_index, i_status = 0;
 
 #if defined(VMS) || defined(MSDOS) || defined (WIN32) /* Parse DEC/Microsoft style command line options */
    for (i_count = 1; i_count < argc; i_count++) 
    {
       if (argv[i_count][0] == '/')
       {
-         for (i_index = 0; argv[i_count][i_index]; i_index++) /* Convert option to uppercase */
+         for (i_index = 0; argv[i_count][i_index] && argv[i_count][i_index] != '='; i_index++) /* Convert option to uppercase */
             if (argv[i_count][i_index] >= 'a' && argv[i_count][i_index] <= 'z')
                argv[i_count][i_index] = argv[i_count][i_index] - 32;
          if (!strncmp(argv[i_count], "/VERSION", i_index))
             v_version(); /* Display version information */
+         else if (!strncmp(argv[i_count], "/TABS", i_index))
+            v_stops(argv[i_count][i_index] ? argv[i_count] + i_index + 1 : NULL, "/TABS");
+         else if (!strncmp(argv[i_count], "/STATISTICS", i_index))
+            v_stats(false, "tabs");
          else if (!strncmp(argv[i_count], "/HELP", i_index))
             v_about();
          else if (!strncmp(argv[i_count], "/?", i_index))
@@ -182,6 +267,23 @@ int main(int argc, char **argv)
          {
             switch (argv[i_count][i_index])
             {
+            case 'c': /* Only report the first change */
+               b_check = true; break;
+            case 'i': /* Replace the contents of files */
+               b_inplace = true; break;
+            case 'j': /* Number of threads */
+               l_jobs = l_number(s_value(&argc, argv, i_count), "-j"); break;
+            case 'p': /* File name pattern */
+               if ((s_pattern = s_value(&argc, argv, i_count)) == NULL) l_number(NULL, "-p");
+               break;
+            case 'r': /* Process directories */
+               b_recursive = true; break;
+            case 's': /* Flush replaced files to the disk */
+               b_sync = true; break;
+            case 'u': /* Count the columns used by UTF-8 characters */
+               b_utf8 = true; break;
+            case 't': /* Tab stops */
+               v_stops(s_value(&argc, argv, i_count), "-t"); break;
             case '?': /* Display help */
                v_about();
             case '-': /* '--' terminates command line processing */
@@ -191,6 +293,28 @@ int main(int argc, char **argv)
                else
                   if (!strncmp(argv[i_count], "--version", i_index))
                      v_version(); /* Display version information */
+                  else if (!strncmp(argv[i_count], "--check", i_index))
+                     b_check = true;
+                  else if (!strncmp(argv[i_count], "--in-place", i_index))
+                     b_inplace = true;
+                  else if (!strncmp(argv[i_count], "--jobs", i_index))
+                     l_jobs = l_number(s_value(&argc, argv, i_count), "--jobs");
+                  else if (!strncmp(argv[i_count], "--pattern", i_index))
+                  {
+                     if ((s_pattern = s_value(&argc, argv, i_count)) == NULL) l_number(NULL, "--pattern");
+                  }
+                  else if (!strncmp(argv[i_count], "--recursive", i_index))
+                     b_recursive = true;
+                  else if (!strncmp(argv[i_count], "--sync", i_index))
+                     b_sync = true;
+                  else if (!strncmp(argv[i_count], "--stats", i_index))
+                     v_stats(false, "tabs");
+                  else if (!strncmp(argv[i_count], "--stats-json", i_index))
+                     v_stats(true, "tabs");
+                  else if (!strncmp(argv[i_count], "--tabs", i_index))
+                     v_stops(s_value(&argc, argv, i_count), "--tabs");
+                  else if (!strncmp(argv[i_count], "--utf-8", i_index))
+                     b_utf8 = true;
                   else if (!strncmp(argv[i_count], "--help", i_index))
                      v_about();
                   else
@@ -212,28 +336,48 @@ int main(int argc, char **argv)
          }
       }
    }
+#endif
+   if (l_jobs < 1 || l_jobs > JOBS_MAX)
+   {
+      v_error("invalid number of jobs %ld, must be between 1 and %d\n", l_jobs, JOBS_MAX);
+      exit(-1);
+   }
+   i_jobs = l_jobs;
+
+   if (b_check) b_inplace = false; /* Checking never changes a file, even with '-i' */
+
+#if defined(THREADS)
+   if (b_recursive || i_jobs > 1 || b_inplace || b_check)
+   {
+      b_hflag = b_recursive && !b_inplace && !b_check; /* Show where each file starts */
+      i_status = i_pool(argc, argv, &t_pool) ? 1 : 0; /* Fail if any files would change */
+   }
+   else
 #endif
    for (i_count = 1; i_count < argc; i_count++) /* Dump files */
    {
       if (!i_isdir(argv[i_count])) /* Check that input files isn't a directory! */
       {
-         if ((h_file = fopen(argv[i_count], "r")) != NULL) /* Open input file, do not use binary mode as it makes a difference on non unix systems! */
+         if (i_open(&t_input, argv[i_count], false)) /* Open input file, do not use binary mode as it makes a difference on non unix systems! */
          {
-            if (b_hflag) fprintf(stdout, "%s:\n", argv[i_count]); /* Optionally print filename */
-            v_detab(h_file);
-            fclose(h_file);
+            if (b_hflag) i_printf(&t_stdout, "%s:\n", argv[i_count]); /* Optionally print filename */
+            stats_stage(STATS_FORMAT);
+            v_detab(&t_input);
+            stats_stage(STATS_OTHER);
+            if (t_input.i_error) v_error("Cannot read %s: %s\n", argv[i_count], s_reason(t_input.i_error));
+            v_close(&t_input);
          }
          else
-         {
-#if defined(VMS) /* Use VAX-C extension (avoids potential ACCVIO) */
-            v_error("Cannot open %s: %s\n", argv[i_count], strerror(errno, vaxc$errno)); 
-#else
-            v_error("Cannot open %s: %s\n", argv[i_count], strerror(errno));
-#endif
-         }
+            v_error("Cannot open %s: %s\n", argv[i_count], s_reason(errno));
       }
       else
          v_error("Cannot open %s: Can't read from a directory\n", argv[i_count], argv[i_count]);
    }
-   exit (0);
+   if (!i_flush(&t_stdout))
+   {
+      v_error("Cannot write standard output: %s\n", s_reason(errno));
+      exit(-1);
+   }
+   stats_count(ull_records, t_stdout.ul_count);
+   exit (i_status);
 }
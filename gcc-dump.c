@@ -26,12 +26,16 @@
  * 10 Aug 23         - Fixed very silly error with true/false values! - MT
  *                   - Do not use stdbool.h as this isn;t available on some
  *                     platforms - MT
+ * 18 Oct 26         - Uses  the shared input and output module to  read
+ *                     the file in large blocks and buffer the output - MT
+ *                   - Added '--stats' to print what was done - MT
+ *                   - Opens and reads the files ahead in a batch - MT
  *
  */
 
 #define  NAME        "gcc-unload"
 #define  VERSION     "0.1"
-#define  BUILD       "0003"
+#define  BUILD       "0006"
 #define  AUTHOR      "MT"
 #define  COPYRIGHT   (__DATE__ + 7) /* Extract copyright year from date */
  
@@ -43,12 +47,14 @@
 #include <errno.h>
 
 #include <sys/stat.h>
+#include "gcc-io.h"
  
 #define  BUFFER_SIZE 16
 
 #define  false       0
 #define  true        !false
 
+char s_program[] = NAME;
 char b_aflag, b_bflag, b_cflag, b_hflag;
 unsigned char a_buffer[BUFFER_SIZE];
 
@@ -71,6 +77,7 @@ void v_about() /* Display help text */
    fprintf(stdout, "  /characters              print characters under hex\n");
    fprintf(stdout, "  /octal                   display bytes in octal\n");
    fprintf(stdout, "  /header                  print filenames\n");
+   fprintf(stdout, "  /statistics              print what was done on exit\n");
    fprintf(stdout, "  /version                 output version information and exit\n");
    fprintf(stdout, "  /?, /help                display this help and exit\n");
    exit(0);
@@ -84,80 +91,69 @@ void v_about() /* Display help text */
    fprintf(stdout, "  -b, --octal              display bytes in octal\n");
    fprintf(stdout, "  -c, --characters         print characters under hex\n");
    fprintf(stdout, "  -f, --filenames          print filenames\n");
+   fprintf(stdout, "      --stats              print what was done on exit\n");
+   fprintf(stdout, "      --stats-json         print what was done on exit in JSON\n");
    fprintf(stdout, "  -?, --help               display this help and exit\n");
    fprintf(stdout, "      --version            output version information and exit\n");
    exit(0);
 }
 #endif
  
-void v_error(const char *s_fmt, ...) /* Print formatted error message */
-{
-   va_list t_args;
-   va_start(t_args, s_fmt);
-   fprintf(stderr, "%s : ", NAME);
-   vfprintf(stderr, s_fmt, t_args);
-   va_end(t_args);
-}
-
-int i_isfile(char *s_name) /* Return true if path is a file */
-{
-   struct stat t_file_d;
-   stat(s_name, &t_file_d);
-   return (S_ISREG(t_file_d.st_mode));
-}
-
-int i_isdir(char *s_name) /* Return true if path is a directory */
-{
-   struct stat t_file_d;
-   stat(s_name, &t_file_d);
-   return (S_ISDIR(t_file_d.st_mode));
-}
-
-void v_dump_hex(FILE *h_file, int i_address) /* Display a file using hexadecimal starting at the specified address */
+void v_dump_hex(t_input *p_input, int i_address) /* Display a file using hexadecimal starting at the specified address */
 {
    int i_count;
-   int i_bytes = 0; /* Number of bytes read from file into buffer */ 
+   int i_bytes = 0; /* Number of bytes copied from the file into buffer */ 
+   size_t i_next, i_left = 0;
+   char b_end = false;
 
-   while ((i_bytes = fread(a_buffer, 1, BUFFER_SIZE, h_file)) > 0)
+   while (!b_end)
    {
-      if (b_bflag) 
-         printf("%06o", i_address); /* Print address in octal */
-      else 
-         printf("%04X", i_address); /* Otherwise print address in hex */
-      for (i_count = 0; i_count < i_bytes; i_count++) {
+      b_end = !i_fill(p_input, i_left); /* Bytes left over that don't fill a line are kept until the end of the file */
+      for (i_next = 0; i_next < p_input->i_length && (b_end || p_input->i_length - i_next >= BUFFER_SIZE); i_next += i_bytes)
+      {
+         i_bytes = (p_input->i_length - i_next < BUFFER_SIZE) ? p_input->i_length - i_next : BUFFER_SIZE;
+         memcpy(a_buffer, p_input->s_data + i_next, i_bytes);
          if (b_bflag) 
-            printf("%03o ", (unsigned char) a_buffer[i_count]); /* Print bytes using octal */
+            i_printf(&t_stdout, "%06o", i_address); /* Print address in octal */
          else 
-         {
-            if (!(i_count % 4))
-               printf(" "); /* Space out bytes in groups of four */
-            printf("%02X", (unsigned char) a_buffer[i_count]); /* Otherwise print bytes using hex (default) */
+            i_printf(&t_stdout, "%04X", i_address); /* Otherwise print address in hex */
+         for (i_count = 0; i_count < i_bytes; i_count++) {
+            if (b_bflag) 
+               i_printf(&t_stdout, "%03o ", (unsigned char) a_buffer[i_count]); /* Print bytes using octal */
+            else 
+            {
+               if (!(i_count % 4))
+                  v_putc(&t_stdout, ' '); /* Space out bytes in groups of four */
+               i_printf(&t_stdout, "%02X", (unsigned char) a_buffer[i_count]); /* Otherwise print bytes using hex (default) */
+            }
          }
-      }
-      for (i_count = 0; i_count < i_bytes; i_count++) /* Replace non printing characters */
-      { 
-         if (!(isprint(a_buffer[i_count]) && a_buffer[i_count] < 127))
+         for (i_count = 0; i_count < i_bytes; i_count++) /* Replace non printing characters */
+         { 
+            if (!(isprint(a_buffer[i_count]) && a_buffer[i_count] < 127))
+            {
+               if (b_cflag) 
+                  a_buffer[i_count] = ' ';
+               else
+                  a_buffer[i_count] = '.';
+            }
+         }
+         if (b_aflag) /* Print ASCII characters on same line */
          {
-            if (b_cflag) 
-               a_buffer[i_count] = ' ';
-            else
-               a_buffer[i_count] = '.';
+            i_printf(&t_stdout, " %*s", 4 - ((i_bytes - 1) / 4) + 2  * (BUFFER_SIZE - i_bytes), ""); /* Print required number of spaces */
+            v_write(&t_stdout, (char *) a_buffer, i_bytes); /* Print the number of characters in the buffer */
          }
+         i_address += i_bytes;
+         v_putc(&t_stdout, '\n'); /* Print newline */
       }
-      if (b_aflag) /* Print ASCII characters on same line */
-      {
-         printf(" %*s", 4 - ((i_bytes - 1) / 4) + 2  * (BUFFER_SIZE - i_bytes), ""); /* Print required number of spaces */
-         printf("%.*s", i_bytes, a_buffer); /* Print the number of characters in the buffer */
-      }
-      i_address += i_bytes;
-      printf("\n");/* Print newline */
+      i_left = p_input->i_length - i_next;
    }
 }
 
 
 int main(int argc, char **argv)
 {
-   FILE *h_file;
+   t_input t_input;
+   t_batch t_batch;
    int i_count, i_index;
 
 #if defined(VMS) || defined(MSDOS) || defined (WIN32) /* Parse DEC/Microsoft style command line options */
@@ -193,6 +189,8 @@ int main(int argc, char **argv)
             }
             b_hflag = true;
          }
+         else if (!strncmp(argv[i_count], "/STATISTICS", i_index))
+            v_stats(false, "lines");
          else if (!strncmp(argv[i_count], "/HELP", i_index))
             v_about();
          else if (!strncmp(argv[i_count], "/?", i_index))
@@ -252,6 +250,10 @@ int main(int argc, char **argv)
                   }
                   else if (!strncmp(argv[i_count], "--filenames", i_index))
                      b_hflag = true;
+                  else if (!strncmp(argv[i_count], "--stats", i_index))
+                     v_stats(false, "lines");
+                  else if (!strncmp(argv[i_count], "--stats-json", i_index))
+                     v_stats(true, "lines");
                   else if (!strncmp(argv[i_count], "--help", i_index))
                      v_about();
                   else
@@ -275,27 +277,29 @@ int main(int argc, char **argv)
    }
 #endif
 
+   v_batch(&t_batch, argv + 1, argc - 1, true); /* Open and read the files ahead */
    for (i_count = 1; i_count < argc; i_count++) /* Dump files */
    {
-      if (!i_isdir(argv[i_count])) /* Check that input files isn't a directory! */
+      if (i_batch_open(&t_batch, &t_input))
       {
-         if ((h_file = fopen(argv[i_count], "rb")) != NULL) 
-         {
-            if (b_hflag) fprintf(stdout, "%s:\n", argv[i_count]); /* Optionally print filename */
-            v_dump_hex(h_file, 0x0100);
-            fclose(h_file);
-         }
-         else
-         {
-#if defined(VMS) /* Use VAX-C extension (avoids potential ACCVIO) */
-            v_error("Cannot open %s: %s\n", argv[i_count], strerror(errno, vaxc$errno)); 
-#else
-            v_error("Cannot open %s: %s\n", argv[i_count], strerror(errno));
-#endif
-         }
+         if (b_hflag) i_printf(&t_stdout, "%s:\n", argv[i_count]); /* Optionally print filename */
+         stats_stage(STATS_FORMAT);
+         v_dump_hex(&t_input, 0x0100);
+         stats_stage(STATS_OTHER);
+         stats_count(ull_records, (t_input.ul_offset + BUFFER_SIZE - 1) / BUFFER_SIZE);
+         if (t_input.i_error) v_error("Cannot read %s: %s\n", argv[i_count], s_reason(t_input.i_error));
+         v_close(&t_input);
       }
+      else if (errno == EISDIR) /* Check that input files isn't a directory! */
+         v_error("Cannot open %s: Can't read from a directory\n", argv[i_count]);
       else
-         v_error("Cannot open %s: Can't read from a directory\n", argv[i_count], argv[i_count]);
+         v_error("Cannot open %s: %s\n", argv[i_count], s_reason(errno));
+   }
+   v_batch_close(&t_batch);
+   if (!i_flush(&t_stdout))
+   {
+      v_error("Cannot write standard output: %s\n", s_reason(errno));
+      exit(-1);
    }
    exit (0);
 }
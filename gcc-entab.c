@@ -22,20 +22,63 @@
  * 
  * 08 Aug 23   0.1   - Initial version - MT   
  * 10 Aug 23         - Fixed very silly error with true/false values! - MT
- * 
- * ToDo:             - Ignore quoted strings and comments!
+ * 18 Oct 26         - Reads the input in large blocks and only checks the
+ *                     characters at each tab position for a space, working
+ *                     out  the tabs needed for the whole run of spaces  at
+ *                     once and copying the text between them in one go - MT
+ *                   - Added an option to set the distance between the tab
+ *                     stops or give a list of tab stops - MT
+ *                   - Added  options to process the files in directories
+ *                     using a pool of threads, splitting large files  at
+ *                     line  breaks and batching small files together, and
+ *                     report what was done to each file - MT
+ *                   - Added  an option to replace the contents of  files
+ *                     instead of writing them to standard output, leaving
+ *                     files that would not change alone - MT
+ *                   - Added  an option to report the first line in  each
+ *                     file that would change without writing anything - MT
+ *                   - Added an option to count the columns used by  UTF-8
+ *                     characters,  including  wide  characters,  checking
+ *                     whether each block is plain ASCII first - MT
+ *                   - Added an option to leave the spaces in quoted  text
+ *                     and comments in C or assembler alone - MT
+ *                   - Uses  the shared input and output module to  read
+ *                     files  and buffer the output, and reports  errors
+ *                     writing standard output - MT
+ *                   - Added '--stats' to print what was done - MT
+ *                   - Don't compare an empty file with a null pointer - MT
+ *                   - '-c' never replaces a file, even with '-i' - MT
+ *                   - Reuses the table of tab stops if '-t' is given more
+ *                     than once - MT
+ *                   - Checks the number of jobs before it is narrowed to
+ *                     an int - MT
+ *                   - Moved  the tab stops, UTF-8 widths and the  pool
+ *                     of threads into a module shared with 'detab' - MT
  * 
  */
 
 #define  NAME        "gcc-entab"
 #define  VERSION     "0.1"
-#define  BUILD       "0002"
+#define  BUILD       "0016"
 #define  AUTHOR      "MT"
 #define  COPYRIGHT   (__DATE__ + 7) /* Extract copyright year from date */
 
 #define  DEBUG
 
-#define  TAB_WIDTH   8
+#define  BLOCK_SIZE  65536                    /* Number of characters read from the file at once */
+
+#define  LEX_CODE    0                        /* Lexer states, spaces in any state from LEX_STRING onwards are left alone */
+#define  LEX_SLASH   1
+#define  LEX_STRING  2
+#define  LEX_S_ESC   3
+#define  LEX_CHAR    4
+#define  LEX_C_ESC   5
+#define  LEX_LINE    6
+#define  LEX_L_ESC   7
+#define  LEX_BLOCK   8
+#define  LEX_STAR    9
+#define  LEX_STATES  10
+#define  SPECIAL_MAX 8                        /* Most characters that are not in the other class */
 
 #define  false       0
 #define  true        !false
@@ -52,8 +95,34 @@
 #include <sys/stat.h>                
 #endif
 #include "gcc-debug.h"
+#include "gcc-io.h"
+#include "gcc-tabs.h"
 
-char b_hflag = false;
+char b_language = false; /* Leave the spaces in quoted text and comments alone */
+typedef struct
+{
+   const char *p_lexed; /* Start of the text that has not been through the lexer */
+   const char *p_end; /* End of the block */
+   const char *a_found[SPECIAL_MAX]; /* Next place each special character appears in the block */
+   int i_state;
+} t_lexer;
+const unsigned char a_lexer[LEX_STATES][8] = { /* Next lexer state for each state and character class */
+/*  other        "           '           \           /           *           newline     comment */
+   {LEX_CODE,    LEX_STRING, LEX_CHAR,   LEX_CODE,   LEX_SLASH,  LEX_CODE,   LEX_CODE,   LEX_LINE},  /* Code */
+   {LEX_CODE,    LEX_STRING, LEX_CHAR,   LEX_CODE,   LEX_LINE,   LEX_BLOCK,  LEX_CODE,   LEX_LINE},  /* Code after a slash */
+   {LEX_STRING,  LEX_CODE,   LEX_STRING, LEX_S_ESC,  LEX_STRING, LEX_STRING, LEX_CODE,   LEX_STRING}, /* String */
+   {LEX_STRING,  LEX_STRING, LEX_STRING, LEX_STRING, LEX_STRING, LEX_STRING, LEX_STRING, LEX_STRING}, /* Escape in a string */
+   {LEX_CHAR,    LEX_CHAR,   LEX_CODE,   LEX_C_ESC,  LEX_CHAR,   LEX_CHAR,   LEX_CODE,   LEX_CHAR},  /* Character constant */
+   {LEX_CHAR,    LEX_CHAR,   LEX_CHAR,   LEX_CHAR,   LEX_CHAR,   LEX_CHAR,   LEX_CHAR,   LEX_CHAR},  /* Escape in a character constant */
+   {LEX_LINE,    LEX_LINE,   LEX_LINE,   LEX_L_ESC,  LEX_LINE,   LEX_LINE,   LEX_CODE,   LEX_LINE},  /* Line comment */
+   {LEX_LINE,    LEX_LINE,   LEX_LINE,   LEX_LINE,   LEX_LINE,   LEX_LINE,   LEX_LINE,   LEX_LINE},  /* Line comment continued on the next line */
+   {LEX_BLOCK,   LEX_BLOCK,  LEX_BLOCK,  LEX_BLOCK,  LEX_BLOCK,  LEX_STAR,   LEX_BLOCK,  LEX_BLOCK}, /* Block comment */
+   {LEX_BLOCK,   LEX_BLOCK,  LEX_BLOCK,  LEX_BLOCK,  LEX_CODE,   LEX_STAR,   LEX_BLOCK,  LEX_BLOCK}, /* Block comment after an asterisk */
+};
+unsigned char a_class[256]; /* Lexer character class of each character */
+char *s_special = ""; /* Characters that are not in the other class */
+char a_exits[LEX_STATES][SPECIAL_MAX + 1]; /* Special characters that change each state, or nothing if any character can */
+char s_program[] = NAME;
 
 void v_version() /* Display version information */
 {
@@ -70,6 +139,9 @@ void v_about() /* Display help text */
 {
    fprintf(stdout, "Usage: %s [OPTION]... [FILE]...\n", NAME);
    fprintf(stdout, "Replaces multiple spaces with tab characters in FILE(s).\n\n");
+   fprintf(stdout, "  /language=LANG           leave the spaces in quoted text and comments alone (c or asm)\n");
+   fprintf(stdout, "  /statistics              print what was done on exit\n");
+   fprintf(stdout, "  /tabs=N[,N]...           set tab stops every N columns or at a list of columns\n");
    fprintf(stdout, "  /version                 output version information and exit\n");
    fprintf(stdout, "  /?, /help                display this help and exit\n");
    exit(0);
@@ -79,90 +151,359 @@ void v_about() /* Display help text */
 {
    fprintf(stdout, "Usage: %s [OPTION]... [FILE]...\n", NAME);
    fprintf(stdout, "Replaces multiple spaces with tab characters in FILE(s).\n\n");
+   fprintf(stdout, "  -c, --check              report the first line in each FILE that would change\n");
+   fprintf(stdout, "  -i, --in-place           replace the contents of each FILE that changes\n");
+   fprintf(stdout, "  -j, --jobs N             use N threads to process files\n");
+   fprintf(stdout, "  -l, --language LANG      leave the spaces in quoted text and comments alone (c or asm)\n");
+   fprintf(stdout, "  -p, --pattern GLOB       only process files in directories that match GLOB\n");
+   fprintf(stdout, "  -r, --recursive          process the files in directories and subdirectories\n");
+   fprintf(stdout, "  -s, --sync               flush each replaced FILE to the disk before renaming it\n");
+   fprintf(stdout, "  -t, --tabs N[,N]...      set tab stops every N columns or at a list of columns\n");
+   fprintf(stdout, "  -u, --utf-8              count the columns used by UTF-8 characters\n");
+   fprintf(stdout, "      --stats              print what was done on exit\n");
+   fprintf(stdout, "      --stats-json         print what was done on exit in JSON\n");
    fprintf(stdout, "  -?, --help               display this help and exit\n");
    fprintf(stdout, "      --version            output version information and exit\n");
    exit(0);
 }
 #endif
  
-void v_error(const char *s_fmt, ...) /* Print formatted error message */
+void v_language(char *s_arg, char *s_option) /* Set the character classes used to find quoted text and comments */
 {
-   va_list t_args;
-   va_start(t_args, s_fmt);
-   fprintf(stderr, "%s: ", NAME);
-   vfprintf(stderr, s_fmt, t_args);
-   va_end(t_args);
+   char a_name[8];
+   int i_count, i_state, i_exits;
+
+   for (i_count = 0; s_arg != NULL && s_arg[i_count] && i_count < sizeof(a_name) - 1; i_count++) /* Language names are not case sensitive */
+      a_name[i_count] = (s_arg[i_count] >= 'A' && s_arg[i_count] <= 'Z') ? s_arg[i_count] + 32 : s_arg[i_count];
+   a_name[i_count] = 0;
+   if (s_arg == NULL)
+   {
+      v_error("option requires an argument -- %s\n", s_option);
+      exit(-1);
+   }
+   if (!strcmp(a_name, "c") || !strcmp(a_name, "c++"))
+      s_special = "\"'\\/*\n\r";
+   else if (!strcmp(a_name, "asm")) /* A quote does not start a character constant */
+      s_special = "\"\\/*\n\r;#";
+   else
+   {
+      v_error("invalid language '%s' for option %s\n", s_arg, s_option);
+      exit(-1);
+   }
+   a_class['"'] = 1;
+   a_class['\''] = 2;
+   a_class['\\'] = 3;
+   a_class['/'] = 4;
+   a_class['*'] = 5;
+   a_class['\n'] = a_class['\r'] = 6;
+   a_class[';'] = a_class['#'] = 7;
+   for (i_count = 1; i_count < 256; i_count++) /* Only the special characters for the language have a class */
+      if (!strchr(s_special, i_count)) a_class[i_count] = 0;
+   for (i_state = 0; i_state < LEX_STATES; i_state++)
+   {
+      for (i_count = i_exits = 0; s_special[i_count] && a_lexer[i_state][0] == i_state; i_count++)
+         if (a_lexer[i_state][a_class[(unsigned char) s_special[i_count]]] != i_state)
+            a_exits[i_state][i_exits++] = i_count + 1; /* Index of the character plus one */
+      a_exits[i_state][i_exits] = 0;
+   }
+   b_language = true;
 }
 
-int i_isfile(char *s_name) /* Return true if path is a file */
+void v_begin(t_lexer *p_lexer, const char *p_data, const char *p_end, int i_state) /* Start passing a block of text through the lexer */
 {
-   struct stat t_file_d;
-   stat(s_name, &t_file_d);
-#if defined(VMS)
-   return ((t_file_d.st_mode & S_IFMT) == S_IFREG);
-#else
-   return (S_ISREG(t_file_d.st_mode));
-#endif
+   int i_count;
+
+   p_lexer->p_lexed = p_data;
+   p_lexer->p_end = p_end;
+   p_lexer->i_state = i_state;
+   for (i_count = 0; i_count < SPECIAL_MAX; i_count++) p_lexer->a_found[i_count] = p_data - 1; /* Not looked for yet */
 }
 
-int i_isdir(char *s_name) /* Return true if path is a directory */
+int i_lex(t_lexer *p_lexer, const char *p_to) /* Pass the text up to a point through the lexer, returns the new state */
 {
-   struct stat t_file_d;
-   stat(s_name, &t_file_d);
-#if defined(VMS)
-   return ((t_file_d.st_mode & S_IFMT) == S_IFDIR);
-#else
-   return (S_ISDIR(t_file_d.st_mode));
-#endif
+   const char *p_data = p_lexer->p_lexed, *p_exit;
+   char *p_index;
+   int i_state = p_lexer->i_state;
+
+   while (p_data < p_to)
+   {
+      if (!a_exits[i_state][0]) /* Any character can change the state */
+         p_exit = p_data;
+      else
+         for (p_exit = p_lexer->p_end, p_index = a_exits[i_state]; *p_index; p_index++) /* Find the next character that changes the state */
+         {
+            if (p_lexer->a_found[*p_index - 1] < p_data) /* Look for each character once however often it is needed */
+               if ((p_lexer->a_found[*p_index - 1] = memchr(p_data, s_special[*p_index - 1], p_lexer->p_end - p_data)) == NULL)
+                  p_lexer->a_found[*p_index - 1] = p_lexer->p_end;
+            if (p_lexer->a_found[*p_index - 1] < p_exit) p_exit = p_lexer->a_found[*p_index - 1];
+         }
+      if (p_exit >= p_to) break;
+      i_state = a_lexer[i_state][a_class[(unsigned char) *p_exit]];
+      p_data = p_exit + 1;
+   }
+   p_lexer->i_state = i_state;
+   p_lexer->p_lexed = p_to;
+   return p_lexer->i_state;
 }
 
-void v_entab(FILE *h_file)
+INLINE int i_quoted(t_lexer *p_lexer, const char *p_stop, const char *p_line) /* Return true if a run of spaces is in quoted text or a comment */
 {
-   int i_offset = 1;
-   int i_blanks = 0;
-   int i_char;
-   
-   while ((i_char = fgetc(h_file)) != EOF)
+   const char *p_first;
+
+   for (p_first = p_stop; p_first > p_line && p_first[-1] == ' '; p_first--);
+   return i_lex(p_lexer, p_first) >= LEX_STRING;
+}
+
+void v_repeat(t_output *p_output, char c_char, unsigned long ul_count) /* Append a character a number of times */
+{
+   static const char s_spaces[] = "                ";
+   static const char s_tabs[] = "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
+   const char *s_string = (c_char == ' ') ? s_spaces : s_tabs;
+   unsigned long ul_length;
+
+   for (; ul_count > 0; ul_count -= ul_length)
    {
-      if (i_char == ' ')
+      ul_length = (ul_count < sizeof(s_spaces) - 1) ? ul_count : sizeof(s_spaces) - 1;
+      v_write(p_output, s_string, ul_length);
+   }
+}
+
+const char *p_break(const char *p_data, const char *p_end, const char **p_return) /* Return the next line break, or p_end */
+{
+   const char *p_newline;
+
+   if (*p_return < p_data && (*p_return = memchr(p_data, '\r', p_end - p_data)) == NULL) /* Only look for the next carriage return when we have passed the last one */
+      *p_return = p_end;
+   if ((p_newline = memchr(p_data, '\n', *p_return - p_data)) == NULL) p_newline = *p_return;
+   return p_newline;
+}
+
+static inline unsigned long ul_next(unsigned long ul_offset, int i_columns) /* Return the first tab position at or after an offset */
+{
+   if (i_columns) return ul_offset + (i_columns - ul_offset % i_columns) % i_columns;
+   return (ul_offset < ul_stops) ? a_next[ul_offset] : ~0UL; /* No more tab positions after the last stop */
+}
+
+static inline const char *p_tab(const char *p_line, const char *p_next, unsigned long ul_column, unsigned long ul_stop) /* Return the character at a tab position, or p_next if it is not on the line */
+{
+   return (ul_stop - ul_column < (unsigned long) (p_next - p_line)) ? p_line + (ul_stop - ul_column) : p_next;
+}
+
+static inline const char *p_after(const char *p_stop, const char *p_line, const char *p_next, unsigned long ul_column, int i_columns) /* Return the next tab position on a line */
+{
+   if (i_columns) return p_stop + i_columns;
+   return p_tab(p_line, p_next, ul_column, ul_next(ul_column + (p_stop - p_line) + 1, 0));
+}
+
+const char *p_space(const char *p_data, const char *p_next, unsigned long *ul_column, int i_columns) /* Return the next space at a tab position on a line with UTF-8 characters, or p_next */
+{
+   unsigned long ul_code;
+
+   while (p_data < p_next)
+   {
+      if (*p_data == ' ' && ul_next(*ul_column, i_columns) == *ul_column) return p_data;
+      if (!(*p_data & 0x80))
       {
-         ++i_blanks;
-         if ((i_offset % TAB_WIDTH) == 0) /* Check for TAB position */
-         {
-            fputc('\t', stdout);
-            i_blanks = 0;
-         }        
+         (*ul_column)++;
+         p_data++;
       }
       else
       {
-         while (i_blanks > 0)
-         {
-            fputc(' ', stdout);
-            i_blanks--;
-         }
-         fputc(i_char, stdout);
-         if ((i_char == '\n') || (i_char == '\r')) i_offset = 0;
+         p_data += i_decode(p_data, p_next, &ul_code);
+         *ul_column += i_wide(ul_code);
       }
-      i_offset++;
    }
+   return p_next;
 }
 
+INLINE const char *p_run(t_output *p_output, const char *p_data, const char *p_line, const char *p_next, const char *p_copy,
+   const char *p_stop, unsigned long ul_stop, unsigned long *ul_blanks, int i_columns) /* Replace a run of spaces that reaches a tab position, returns the start of the text still to be written */
+{
+   const char *p_first, *p_last, *p_base = p_stop;
+   unsigned long ul_tabs;
+
+   for (p_first = p_stop; p_first > p_line && p_first[-1] == ' '; p_first--); /* Find the whole run of spaces */
+   for (p_last = p_stop; p_last < p_next && *p_last == ' '; p_last++);
+   if (p_first > p_data) v_repeat(p_output, ' ', *ul_blanks); /* Spaces left over from the last block didn't reach a tab position */
+   *ul_blanks = 0;
+   v_write(p_output, p_copy, p_first - p_copy);
+   if (i_columns) /* Work out the last tab position in the run */
+   {
+      ul_tabs = (p_last - 1 - p_stop) / i_columns + 1;
+      p_stop += (ul_tabs - 1) * i_columns;
+   }
+   else
+      for (ul_tabs = 1; (p_first = p_after(p_stop, p_base, p_next, ul_stop, i_columns)) < p_last; ul_tabs++)
+         p_stop = p_first;
+   v_repeat(p_output, '\t', ul_tabs);
+   p_output->ul_count += ul_tabs;
+   return p_stop + 1; /* Spaces after the last tab are copied with the text that follows them */
+}
+
+INLINE void v_replace(t_output *p_output, const char *p_data, size_t i_length, unsigned long *ul_offset, unsigned long *ul_blanks, int *i_state, int i_columns) /* Replace the spaces in a block of text */
+{
+   const char *p_end = p_data + i_length;
+   const char *p_copy = p_data; /* Start of the text that has not been written */
+   const char *p_line = p_data; /* Start of the current line */
+   const char *p_return = p_data - 1; /* Next carriage return */
+   const char *p_next, *p_stop, *p_last;
+   unsigned long ul_column = *ul_offset; /* Column of the start of the current line */
+   unsigned long ul_stop;
+   char b_wide = b_utf8 && !i_ascii(p_data, i_length); /* Some lines may need their columns counted a character at a time */
+   char b_line = false;
+   t_lexer t_lex;
+
+   if (b_language) v_begin(&t_lex, p_data, p_end, *i_state);
+   while (p_line < p_end)
+   {
+      p_next = p_break(p_line, p_end, &p_return);
+      if (b_wide && (b_line = !i_ascii(p_line, p_next - p_line)))
+      {
+         for (p_stop = p_line, ul_stop = ul_column; (p_stop = p_space(p_stop, p_next, &ul_stop, i_columns)) < p_next; )
+            if (b_language && i_quoted(&t_lex, p_stop, p_line))
+            {
+               p_stop++;
+               ul_stop++;
+            }
+            else
+            {
+               p_copy = p_run(p_output, p_data, p_line, p_next, p_copy, p_stop, ul_stop, ul_blanks, i_columns);
+               ul_stop += p_copy - p_stop; /* Only spaces in between */
+               p_stop = p_copy;
+            }
+      }
+      else
+         for (p_stop = p_tab(p_line, p_next, ul_column, ul_next(ul_column, i_columns)); p_stop < p_next; p_stop = p_after(p_stop, p_line, p_next, ul_column, i_columns)) /* Only a space at a tab position can start a tab */
+            if (*p_stop == ' ' && !(b_language && i_quoted(&t_lex, p_stop, p_line)))
+            {
+               p_copy = p_run(p_output, p_data, p_line, p_next, p_copy, p_stop, ul_column + (p_stop - p_line), ul_blanks, i_columns);
+               p_stop = p_copy - 1;
+            }
+      if (p_next < p_end) /* Columns are counted from the line break */
+      {
+         ul_column = 1;
+         p_line = p_next + 1;
+      }
+      else
+      {
+         ul_column += b_line ? ul_width(p_line, p_next) : p_next - p_line;
+         p_line = p_next;
+      }
+   }
+   *ul_offset = ul_column;
+   if (b_language) *i_state = i_lex(&t_lex, p_end); /* Quoted text and comments can carry on into the next block */
+   for (p_last = p_end; p_last > p_copy && p_last[-1] == ' '; p_last--); /* Hold back any trailing spaces until we know what follows them */
+   if (p_last > p_copy)
+   {
+      v_repeat(p_output, ' ', *ul_blanks);
+      *ul_blanks = 0;
+      v_write(p_output, p_copy, p_last - p_copy);
+   }
+   *ul_blanks += p_end - p_last;
+}
+
+void v_compress(t_output *p_output, const char *p_data, size_t i_length, unsigned long *ul_offset, unsigned long *ul_blanks, int *i_state) /* Replace the spaces in a block of text */
+{
+   switch (i_width) /* Let the compiler simplify the arithmetic for the most common tab widths */
+   {
+   case 2: v_replace(p_output, p_data, i_length, ul_offset, ul_blanks, i_state, 2); break;
+   case 4: v_replace(p_output, p_data, i_length, ul_offset, ul_blanks, i_state, 4); break;
+   case 8: v_replace(p_output, p_data, i_length, ul_offset, ul_blanks, i_state, 8); break;
+   default: v_replace(p_output, p_data, i_length, ul_offset, ul_blanks, i_state, i_width); /* Also handles a list of tab stops */
+   }
+}
+
+void v_entab(t_input *p_input)
+{
+   unsigned long ul_offset = 1;
+   unsigned long ul_blanks = 0;
+   int i_state = LEX_CODE;
+   size_t i_held = 0;
+
+   while (i_fill(p_input, i_held) > 0)
+   {
+      i_held = b_utf8 ? i_partial(p_input->s_data, p_input->i_length) : 0; /* Keep an incomplete character for the next block */
+      v_compress(&t_stdout, p_input->s_data, p_input->i_length - i_held, &ul_offset, &ul_blanks, &i_state);
+   }
+   if (i_held) v_compress(&t_stdout, p_input->s_data, i_held, &ul_offset, &ul_blanks, &i_state);
+   i_flush(&t_stdout);
+}
+
+void v_convert(t_output *p_output, const char *p_data, size_t i_length, char b_start) /* Replace the spaces in part of a file that starts on a new line */
+{
+   unsigned long ul_offset = 1;
+   unsigned long ul_blanks = 0; /* Any spaces left at the end of the file are dropped */
+   int i_state = LEX_CODE;
+
+   v_compress(p_output, p_data, i_length, &ul_offset, &ul_blanks, &i_state);
+}
+
+INLINE const char *p_scan(const char *p_data, size_t i_length, int i_columns) /* Return the first space that would be replaced or removed, or NULL */
+{
+   const char *p_end = p_data + i_length;
+   const char *p_line = p_data; /* Start of the current line */
+   const char *p_return = p_data - 1; /* Next carriage return */
+   const char *p_next, *p_stop, *p_trailing;
+   unsigned long ul_column;
+   char b_wide = b_utf8 && !i_ascii(p_data, i_length);
+   t_lexer t_lex;
+
+   for (p_trailing = p_end; p_trailing > p_data && p_trailing[-1] == ' '; p_trailing--); /* Spaces at the end of the file are always removed */
+   if (p_trailing == p_end) p_trailing = NULL;
+   if (b_language) v_begin(&t_lex, p_data, p_end, LEX_CODE);
+   while (p_line < p_end && (p_trailing == NULL || p_line < p_trailing))
+   {
+      p_next = p_break(p_line, p_end, &p_return);
+      ul_column = 1;
+      if (b_wide && !i_ascii(p_line, p_next - p_line))
+         for (p_stop = p_line; (p_stop = p_space(p_stop, p_next, &ul_column, i_columns)) < p_next && b_language && i_quoted(&t_lex, p_stop, p_line); ul_column++)
+            p_stop++;
+      else
+         for (p_stop = p_tab(p_line, p_next, 1, ul_next(1, i_columns)); p_stop < p_next && (*p_stop != ' ' || (b_language && i_quoted(&t_lex, p_stop, p_line))); p_stop = p_after(p_stop, p_line, p_next, 1, i_columns));
+      if (p_stop < p_next)
+      {
+         while (p_stop > p_line && p_stop[-1] == ' ') p_stop--; /* Start of the run of spaces */
+         return (p_trailing == NULL || p_stop < p_trailing) ? p_stop : p_trailing;
+      }
+      p_line = p_next + 1; /* Every line starts in column one */
+   }
+   return p_trailing;
+}
+
+const char *p_check(const char *p_data, size_t i_length) /* Return the first space that would be replaced or removed, or NULL */
+{
+   switch (i_width) /* Let the compiler simplify the arithmetic for the most common tab widths */
+   {
+   case 2: return p_scan(p_data, i_length, 2);
+   case 4: return p_scan(p_data, i_length, 4);
+   case 8: return p_scan(p_data, i_length, 8);
+   default: return p_scan(p_data, i_length, i_width); /* Also handles a list of tab stops */
+   }
+}
 
 int main(int argc, char **argv)
 {
-   FILE *h_file;
-   int i_count, i_index;
+   t_input t_input;
+   t_tabs t_pool = {v_convert, p_check, "tabs written", "has spaces that would be replaced", false}; /* How the threads convert and check each file */
+   long l_jobs = 1; /* Checked before it is narrowed */
+   int i_count, i_index, i_status = 0;
 
 #if defined(VMS) || defined(MSDOS) || defined (WIN32) /* Parse DEC/Microsoft style command line options */
    for (i_count = 1; i_count < argc; i_count++) 
    {
       if (argv[i_count][0] == '/')
       {
-         for (i_index = 0; argv[i_count][i_index]; i_index++) /* Convert option to uppercase */
+         for (i_index = 0; argv[i_count][i_index] && argv[i_count][i_index] != '='; i_index++) /* Convert option to uppercase */
             if (argv[i_count][i_index] >= 'a' && argv[i_count][i_index] <= 'z')
                argv[i_count][i_index] = argv[i_count][i_index] - 32;
          if (!strncmp(argv[i_count], "/VERSION", i_index))
             v_version(); /* Display version information */
+         else if (!strncmp(argv[i_count], "/LANGUAGE", i_index))
+            v_language(argv[i_count][i_index] ? argv[i_count] + i_index + 1 : NULL, "/LANGUAGE");
+         else if (!strncmp(argv[i_count], "/TABS", i_index))
+            v_stops(argv[i_count][i_index] ? argv[i_count] + i_index + 1 : NULL, "/TABS");
+         else if (!strncmp(argv[i_count], "/STATISTICS", i_index))
+            v_stats(false, "tabs");
          else if (!strncmp(argv[i_count], "/HELP", i_index))
             v_about();
          else if (!strncmp(argv[i_count], "/?", i_index))
@@ -189,6 +530,25 @@ int main(int argc, char **argv)
          {
             switch (argv[i_count][i_index])
             {
+            case 'c': /* Only report the first change */
+               b_check = true; break;
+            case 'i': /* Replace the contents of files */
+               b_inplace = true; break;
+            case 'j': /* Number of threads */
+               l_jobs = l_number(s_value(&argc, argv, i_count), "-j"); break;
+            case 'l': /* Leave quoted text and comments alone */
+               v_language(s_value(&argc, argv, i_count), "-l"); break;
+            case 'p': /* File name pattern */
+               if ((s_pattern = s_value(&argc, argv, i_count)) == NULL) l_number(NULL, "-p");
+               break;
+            case 'r': /* Process directories */
+               b_recursive = true; break;
+            case 's': /* Flush replaced files to the disk */
+               b_sync = true; break;
+            case 'u': /* Count the columns used by UTF-8 characters */
+               b_utf8 = true; break;
+            case 't': /* Tab stops */
+               v_stops(s_value(&argc, argv, i_count), "-t"); break;
             case '?': /* Display help */
                v_about();
             case '-': /* '--' terminates command line processing */
@@ -198,6 +558,30 @@ int main(int argc, char **argv)
                else
                   if (!strncmp(argv[i_count], "--version", i_index))
                      v_version(); /* Display version information */
+                  else if (!strncmp(argv[i_count], "--check", i_index))
+                     b_check = true;
+                  else if (!strncmp(argv[i_count], "--in-place", i_index))
+                     b_inplace = true;
+                  else if (!strncmp(argv[i_count], "--jobs", i_index))
+                     l_jobs = l_number(s_value(&argc, argv, i_count), "--jobs");
+                  else if (!strncmp(argv[i_count], "--language", i_index))
+                     v_language(s_value(&argc, argv, i_count), "--language");
+                  else if (!strncmp(argv[i_count], "--pattern", i_index))
+                  {
+                     if ((s_pattern = s_value(&argc, argv, i_count)) == NULL) l_number(NULL, "--pattern");
+                  }
+                  else if (!strncmp(argv[i_count], "--recursive", i_index))
+                     b_recursive = true;
+                  else if (!strncmp(argv[i_count], "--sync", i_index))
+                     b_sync = true;
+                  else if (!strncmp(argv[i_count], "--stats", i_index))
+                     v_stats(false, "tabs");
+                  else if (!strncmp(argv[i_count], "--stats-json", i_index))
+                     v_stats(true, "tabs");
+                  else if (!strncmp(argv[i_count], "--tabs", i_index))
+                     v_stops(s_value(&argc, argv, i_count), "--tabs");
+                  else if (!strncmp(argv[i_count], "--utf-8", i_index))
+                     b_utf8 = true;
                   else if (!strncmp(argv[i_count], "--help", i_index))
                      v_about();
                   else
@@ -219,28 +603,49 @@ int main(int argc, char **argv)
          }
       }
    }
+#endif
+   if (l_jobs < 1 || l_jobs > JOBS_MAX)
+   {
+      v_error("invalid number of jobs %ld, must be between 1 and %d\n", l_jobs, JOBS_MAX);
+      exit(-1);
+   }
+   i_jobs = l_jobs;
+
+   if (b_check) b_inplace = false; /* Checking never changes a file, even with '-i' */
+
+#if defined(THREADS)
+   if (b_recursive || i_jobs > 1 || b_inplace || b_check)
+   {
+      b_hflag = b_recursive && !b_inplace && !b_check; /* Show where each file starts */
+      t_pool.b_whole = b_language; /* The lexer must start at the beginning of each file */
+      i_status = i_pool(argc, argv, &t_pool) ? 1 : 0; /* Fail if any files would change */
+   }
+   else
 #endif
    for (i_count = 1; i_count < argc; i_count++) /* Dump files */
    {
       if (!i_isdir(argv[i_count])) /* Check that input files isn't a directory! */
       {
-         if ((h_file = fopen(argv[i_count], "r")) != NULL) /* Open input file, do not use binary mode as it makes a difference on non unix systems! */
+         if (i_open(&t_input, argv[i_count], false)) /* Open input file, do not use binary mode as it makes a difference on non unix systems! */
          {
-            if (b_hflag) fprintf(stdout, "%s:\n", argv[i_count]); /* Optionally print filename */
-            v_entab(h_file);
-            fclose(h_file);
+            if (b_hflag) i_printf(&t_stdout, "%s:\n", argv[i_count]); /* Optionally print filename */
+            stats_stage(STATS_FORMAT);
+            v_entab(&t_input);
+            stats_stage(STATS_OTHER);
+            if (t_input.i_error) v_error("Cannot read %s: %s\n", argv[i_count], s_reason(t_input.i_error));
+            v_close(&t_input);
          }
          else
-         {
-#if defined(VMS) /* Use VAX-C extension (avoids potential ACCVIO) */
-            v_error("Cannot open %s: %s\n", argv[i_count], strerror(errno, vaxc$errno)); 
-#else
-            v_error("Cannot open %s: %s\n", argv[i_count], strerror(errno));
-#endif
-         }
+            v_error("Cannot open %s: %s\n", argv[i_count], s_reason(errno));
       }
       else
          v_error("Cannot open %s: Can't read from a directory\n", argv[i_count], argv[i_count]);
    }
-   exit (0);
+   if (!i_flush(&t_stdout))
+   {
+      v_error("Cannot write standard output: %s\n", s_reason(errno));
+      exit(-1);
+   }
+   stats_count(ull_records, t_stdout.ul_count);
+   exit (i_status);
 }
@@ -0,0 +1,626 @@
+/*
+ * gcc-hex.c
+ *
+ * Copyright(C) 2026   MT
+ *
+ * Reads and writes Intel Hex records, and writes Motorola 'S' records and
+ * C arrays, for use by other programs as well as 'load' and 'unload'.
+ *
+ * An  encoder formats records into the caller's buffer, holding back  any
+ * bytes  that don't yet fill a whole record until the next call, so  that
+ * the  records  are the same however the bytes are split  up.  A  decoder
+ * collects  the bytes loaded in the caller's buffer, padding any gaps with
+ * zeros,  and  can  also give back a listing of each  record  showing  if
+ * the checksum was correct.  Neither allocates any memory, and an encoder
+ * can  format  chunks  of  the same file on several threads  at  once  as
+ * long as they are written in order.
+ *
+ * This  program is free software: you can redistribute it and/or modify it
+ * under  the terms of the GNU General Public License as published  by  the
+ * Free  Software Foundation, either version 3 of the License, or (at  your
+ * option) any later version.
+ *
+ * This  program  is distributed in the hope that it will  be  useful,  but
+ * WITHOUT   ANY   WARRANTY;   without even   the   implied   warranty   of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You  should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * 18 Oct 26         - Initial version, using the code from 'load' and
+ *                     'unload' - MT
+ *                   - Only counts an address that goes backwards as an
+ *                     error for a data record - MT
+ *                   - Uses a wider end record for a start address that
+ *                     doesn't fit in the width of the data records - MT
+ *                   - Gives the array for an empty file a single element so
+ *                     that it is still valid C, its length is still zero - MT
+ *                   - Reads a single Intel Hex or 'S' record from a line,
+ *                     checking its length is right for its type - MT
+ *                   - Only reads a line as an 'S' record if the 'S' is
+ *                     followed by a digit and a hexadecimal digit - MT
+ *
+ */
+
+#define  false       0
+#define  true        !false
+
+#include <stdio.h>
+#include <string.h>
+
+#include "gcc-hex.h"
+
+#define  HEX_ROW(h)  h "0" h "1" h "2" h "3" h "4" h "5" h "6" h "7" h "8" h "9" h "A" h "B" h "C" h "D" h "E" h "F"
+#define  HEX_TABLE(r) r("0") r("1") r("2") r("3") r("4") r("5") r("6") r("7") r("8") r("9") r("A") r("B") r("C") r("D") r("E") r("F")
+#define  ELEMENT(h, l) "0x" h l ",   "
+#define  ELEMENT_ROW(h) ELEMENT(h, "0") ELEMENT(h, "1") ELEMENT(h, "2") ELEMENT(h, "3") ELEMENT(h, "4") ELEMENT(h, "5") ELEMENT(h, "6") ELEMENT(h, "7") \
+   ELEMENT(h, "8") ELEMENT(h, "9") ELEMENT(h, "A") ELEMENT(h, "B") ELEMENT(h, "C") ELEMENT(h, "D") ELEMENT(h, "E") ELEMENT(h, "F")
+
+static const char a_hex[] = HEX_TABLE(HEX_ROW); /* Hexadecimal digits for every byte value */
+static const char a_element[] = HEX_TABLE(ELEMENT_ROW); /* Elements of a C array for every byte value, padded to eight characters */
+
+static char *s_byte(char *s_output, unsigned int i_byte) /* Append the two hexadecimal digits for a byte */
+{
+   s_output[0] = a_hex[2 * (i_byte & 0xFF)];
+   s_output[1] = a_hex[2 * (i_byte & 0xFF) + 1];
+   return s_output + 2;
+}
+
+static inline char *s_data(char *s_output, const unsigned char *p_data, int i_bytes, unsigned int *i_checksum) /* Append the data bytes of a record */
+{
+   unsigned int i_sum = 0;
+   int i_count;
+
+   for (i_count = 0; i_count < i_bytes; i_count++)
+   {
+      s_output[2 * i_count] = a_hex[2 * p_data[i_count]];
+      s_output[2 * i_count + 1] = a_hex[2 * p_data[i_count] + 1];
+      i_sum += p_data[i_count];
+   }
+   *i_checksum += i_sum;
+   return s_output + 2 * i_bytes;
+}
+
+static char *s_bytes(char *s_output, const unsigned char *p_data, int i_bytes, unsigned int *i_checksum) /* Append the data bytes of a record */
+{
+   switch (i_bytes) /* Let the compiler unroll the loop for the most common record sizes */
+   {
+   case 16: return s_data(s_output, p_data, 16, i_checksum);
+   case 32: return s_data(s_output, p_data, 32, i_checksum);
+   case 64: return s_data(s_output, p_data, 64, i_checksum);
+   default: return s_data(s_output, p_data, i_bytes, i_checksum);
+   }
+}
+
+static unsigned long ul_run(const unsigned char *p_data, unsigned long ul_length, int i_byte) /* Count the number of leading bytes that match the fill byte */
+{
+   unsigned long ul_pattern = ~0UL / 0xFF * i_byte; /* Fill byte repeated in every byte of a word */
+   unsigned long a_words[4];
+   unsigned long ul_count = 0;
+
+   while (ul_count + sizeof(a_words) <= ul_length) /* Compare four words at a time */
+   {
+      memcpy(a_words, p_data + ul_count, sizeof(a_words));
+      if ((a_words[0] ^ ul_pattern) | (a_words[1] ^ ul_pattern) | (a_words[2] ^ ul_pattern) | (a_words[3] ^ ul_pattern)) break;
+      ul_count += sizeof(a_words);
+   }
+   while (ul_count < ul_length && p_data[ul_count] == i_byte) ul_count++;
+   return ul_count;
+}
+
+static char *s_motorola(char *s_output, int i_type, unsigned long ul_address, int i_size, const unsigned char *p_data, int i_bytes) /* Append an 'S' record */
+{
+   unsigned int i_checksum;
+   int i_count;
+
+   *s_output++ = 'S';
+   *s_output++ = '0' + i_type;
+   i_checksum = i_size + i_bytes + 1; /* Count includes the address, data and checksum */
+   s_output = s_byte(s_output, i_checksum);
+   for (i_count = 8 * (i_size - 1); i_count >= 0; i_count -= 8)
+   {
+      s_output = s_byte(s_output, ul_address >> i_count);
+      i_checksum += (ul_address >> i_count) & 0xFF;
+   }
+   s_output = s_bytes(s_output, p_data, i_bytes, &i_checksum);
+   s_output = s_byte(s_output, ~i_checksum & 0xFF); /* One's complement of the sum of all the bytes */
+   *s_output++ = '\n';
+   return s_output;
+}
+
+static char *s_record(char *s_output, int i_type, unsigned int i_address, const unsigned char *p_data, int i_bytes) /* Append a record */
+{
+   unsigned int i_checksum;
+
+   *s_output++ = ':';
+   s_output = s_byte(s_output, i_bytes); /* Record length, address and record type */
+   s_output = s_byte(s_output, i_address >> 8);
+   s_output = s_byte(s_output, i_address);
+   s_output = s_byte(s_output, i_type);
+   i_checksum = i_bytes + i_type + (i_address >> 8) + (i_address & 0xFF);
+   s_output = s_bytes(s_output, p_data, i_bytes, &i_checksum);
+   /* The checksum is the least significant byte of the the two's complement of the sum of all bytes values in the record */
+   s_output = s_byte(s_output, (~(i_checksum & 0xFF) + 1) & 0xFF);
+   *s_output++ = '\n';
+   return s_output;
+}
+
+static char *s_array(char *s_output, const unsigned char *p_data, int i_bytes) /* Append a line of a C array */
+{
+   int i_count;
+
+   *s_output++ = ' ';
+   *s_output++ = ' ';
+   for (i_count = 0; i_count < i_bytes; i_count++, s_output += 6)
+      memcpy(s_output, a_element + 8 * p_data[i_count], 8); /* Copying all eight characters is quicker, the last two get overwritten */
+   s_output[-1] = '\n'; /* Every element is followed by a comma */
+   return s_output;
+}
+
+static char *s_extended(const t_encoder *p_encoder, char *s_output, long l_value) /* Append an extended segment or linear address record */
+{
+   unsigned char a_address[2];
+
+   if (p_encoder->b_segment) l_value <<= 12; /* Segment address of a 64K block */
+   a_address[0] = (l_value >> 8) & 0xFF;
+   a_address[1] = l_value & 0xFF;
+   return s_record(s_output, p_encoder->b_segment ? 2 : 4, 0, a_address, 2);
+}
+
+static void v_symbol(t_encoder *p_encoder) /* Write the name of the array, made from the file name */
+{
+   char s_line[HEX_LINE];
+   const char *s_name = p_encoder->s_name;
+   int i_count = 0;
+
+   if (*s_name >= '0' && *s_name <= '9') s_line[i_count++] = '_'; /* Identifiers can't start with a digit */
+   for (; *s_name; s_name++)
+   {
+      if (i_count >= sizeof(s_line))
+      {
+         p_encoder->p_write(p_encoder->p_context, s_line, i_count);
+         i_count = 0;
+      }
+      s_line[i_count++] = ((*s_name >= '0' && *s_name <= '9') || (*s_name >= 'A' && *s_name <= 'Z') || (*s_name >= 'a' && *s_name <= 'z')) ? *s_name : '_';
+   }
+   p_encoder->p_write(p_encoder->p_context, s_line, i_count);
+}
+
+void v_hex_encoder(t_encoder *p_encoder, char *s_buffer, size_t i_buffer,
+   void (*p_write)(void *p_context, const char *s_text, size_t i_length), void *p_context) /* Set up an encoder with the default options */
+{
+   memset(p_encoder, 0, sizeof(t_encoder));
+   p_encoder->i_format = HEX_INTEL;
+   p_encoder->i_size = HEX_SIZE;
+   p_encoder->i_width = 4;
+   p_encoder->i_filler = -1;
+   p_encoder->ul_load = HEX_LOAD;
+   p_encoder->p_write = p_write;
+   p_encoder->p_context = p_context;
+   p_encoder->s_buffer = s_buffer; /* Only needed by i_hex_encode(), must hold at least HEX_BUFFER_MIN characters */
+   p_encoder->i_buffer = i_buffer;
+   p_encoder->s_name = "";
+}
+
+int i_hex_width(unsigned long ul_last) /* Number of address bytes needed for 'S' records up to an address */
+{
+   return (ul_last > 0xFFFFFFUL) ? 4 : (ul_last > 0xFFFFUL) ? 3 : 2;
+}
+
+unsigned long ul_hex_align(const t_encoder *p_encoder, unsigned long ul_address) /* Return the start of the record that contains an address */
+{
+   unsigned long ul_first = ul_address & ~0xFFFFUL; /* Intel hex records always start on a 64K boundary */
+
+   if (ul_first < p_encoder->ul_load || p_encoder->i_format != HEX_INTEL) ul_first = p_encoder->ul_load;
+   return ul_first + (ul_address - ul_first) / p_encoder->i_size * p_encoder->i_size;
+}
+
+size_t i_hex_capacity(const t_encoder *p_encoder, unsigned long ul_length) /* Size of buffer needed to hold the records for some bytes */
+{
+   if (p_encoder->i_format == HEX_SOURCE) return 6 * ul_length + (ul_length / p_encoder->i_size + 2) * 2; /* Six characters for each byte */
+   return 2 * ul_length + (ul_length / p_encoder->i_size + ul_length / 0x10000 + 4) * 28;
+}
+
+void v_hex_format(const t_encoder *p_encoder, t_chunk *p_chunk, const unsigned char *p_data, unsigned long ul_address, unsigned long ul_length) /* Format the records for a chunk, which must start at the beginning of a record */
+{
+   unsigned long ul_limit = p_encoder->b_segment ? 0xFFFFFUL : 0xFFFFFFFFUL; /* Highest address that can be used */
+   unsigned long ul_skip = 0; /* Number of fill bytes found ahead of the current record */
+   char *s_output = p_chunk->s_output;
+   int i_format = p_encoder->i_format;
+   int i_size = p_encoder->i_size;
+   int i_filler = p_encoder->i_filler;
+   int i_bytes; /* Number of bytes in the current record */
+
+   if (i_format == HEX_MOTOROLA) ul_limit = 0xFFFFFFFFUL >> (8 * (4 - p_encoder->i_width));
+   if (i_format == HEX_SOURCE) ul_limit = ~0UL; /* Addresses are not used */
+   p_chunk->l_first = -1;
+   p_chunk->ul_error = 0;
+   p_chunk->ul_records = 0;
+   for (; ul_length > 0; p_data += i_bytes, ul_length -= i_bytes, ul_address += i_bytes)
+   {
+      i_bytes = (i_format != HEX_INTEL) ? i_size : 0x10000 - (ul_address & 0xFFFF); /* Intel hex records must never cross a 64K boundary */
+      if (i_bytes > i_size) i_bytes = i_size;
+      if (i_bytes > ul_length) i_bytes = ul_length;
+      if (i_filler >= 0) /* Leave out records that only contain the fill byte */
+      {
+         if (ul_skip < i_bytes) ul_skip = ul_run(p_data, ul_length, i_filler);
+         if (ul_skip >= i_bytes)
+         {
+            ul_skip -= i_bytes;
+            continue;
+         }
+         ul_skip = 0;
+      }
+      if (ul_address + i_bytes - 1 > ul_limit)
+      {
+         p_chunk->ul_error = ul_address + i_bytes - 1;
+         break;
+      }
+      p_chunk->ul_records++;
+      if (i_format == HEX_SOURCE)
+      {
+         s_output = s_array(s_output, p_data, i_bytes);
+         continue;
+      }
+      if (i_format == HEX_MOTOROLA)
+      {
+         s_output = s_motorola(s_output, p_encoder->i_width - 1, ul_address, p_encoder->i_width, p_data, i_bytes); /* S1, S2 or S3 */
+         continue;
+      }
+      if (p_chunk->l_first < 0) /* The writer adds an extended address record before the first record if needed */
+         p_chunk->l_first = p_chunk->l_last = ul_address >> 16;
+      else if ((ul_address >> 16) != p_chunk->l_last) /* Upper address bits have changed */
+      {
+         p_chunk->l_last = ul_address >> 16;
+         s_output = s_extended(p_encoder, s_output, p_chunk->l_last);
+      }
+      s_output = s_record(s_output, 0, ul_address & 0xFFFF, p_data, i_bytes);
+   }
+   p_chunk->i_output = s_output - p_chunk->s_output;
+}
+
+void v_hex_begin(t_encoder *p_encoder, const char *s_name) /* Start a new file and write the header, the name must be kept until the end */
+{
+   char s_line[HEX_LINE];
+   int i_length = strlen(s_name);
+
+   p_encoder->s_name = s_name;
+   p_encoder->ul_address = p_encoder->ul_load;
+   p_encoder->l_upper = 0;
+   p_encoder->ul_records = 0;
+   p_encoder->ul_error = 0;
+   p_encoder->i_pending = 0;
+   if (p_encoder->i_format == HEX_SOURCE) /* Name the array after the file */
+   {
+      p_encoder->p_write(p_encoder->p_context, "const unsigned char ", 20);
+      v_symbol(p_encoder);
+      p_encoder->p_write(p_encoder->p_context, "[] = {\n", 7);
+      return;
+   }
+   if (p_encoder->i_format != HEX_MOTOROLA) return;
+   if (i_length > 64) i_length = 64; /* Header holds the file name */
+   p_encoder->p_write(p_encoder->p_context, s_line, s_motorola(s_line, 0, 0, 2, (const unsigned char *) s_name, i_length) - s_line);
+}
+
+int i_hex_write(t_encoder *p_encoder, t_chunk *p_chunk) /* Write the records for a chunk, returns false if an address was out of range */
+{
+   char s_line[HEX_LINE];
+
+   if (p_chunk->l_first >= 0 && p_chunk->l_first != p_encoder->l_upper) /* Upper address bits have changed */
+      p_encoder->p_write(p_encoder->p_context, s_line, s_extended(p_encoder, s_line, p_chunk->l_first) - s_line);
+   p_encoder->p_write(p_encoder->p_context, p_chunk->s_output, p_chunk->i_output);
+   if (p_chunk->l_first >= 0) p_encoder->l_upper = p_chunk->l_last;
+   p_encoder->ul_records += p_chunk->ul_records;
+   if (p_chunk->ul_error)
+   {
+      p_encoder->ul_error = p_chunk->ul_error;
+      return false;
+   }
+   return true;
+}
+
+static int i_encode(t_encoder *p_encoder, const unsigned char *p_data, size_t i_length) /* Format and write whole records that fit in the buffer */
+{
+   t_chunk t_chunk;
+
+   t_chunk.s_output = p_encoder->s_buffer;
+   v_hex_format(p_encoder, &t_chunk, p_data, p_encoder->ul_address, i_length);
+   p_encoder->ul_address += i_length;
+   return i_hex_write(p_encoder, &t_chunk);
+}
+
+int i_hex_encode(t_encoder *p_encoder, const unsigned char *p_data, size_t i_length) /* Write records for the next bytes, returns false if an address was out of range */
+{
+   size_t i_most = (p_encoder->i_buffer - HEX_LINE) / (32 + 6 * p_encoder->i_size) * p_encoder->i_size; /* Bytes that always fit in the buffer */
+   size_t i_record, i_count;
+
+   if (p_encoder->ul_error) return false;
+   while (i_length > 0)
+   {
+      i_record = ul_hex_align(p_encoder, p_encoder->ul_address + p_encoder->i_size) - p_encoder->ul_address; /* Bytes in the next record */
+      if (p_encoder->i_pending || i_length < i_record) /* Collect a record split between calls */
+      {
+         i_count = i_record - p_encoder->i_pending;
+         if (i_count > i_length) i_count = i_length;
+         memcpy(p_encoder->a_pending + p_encoder->i_pending, p_data, i_count);
+         p_encoder->i_pending += i_count;
+         p_data += i_count;
+         i_length -= i_count;
+         if (p_encoder->i_pending < i_record) break;
+         p_encoder->i_pending = 0;
+         if (!i_encode(p_encoder, p_encoder->a_pending, i_record)) return false;
+         continue;
+      }
+      i_count = ul_hex_align(p_encoder, p_encoder->ul_address + (i_length < i_most ? i_length : i_most)) - p_encoder->ul_address; /* Whole records only */
+      if (!i_encode(p_encoder, p_data, i_count)) return false;
+      p_data += i_count;
+      i_length -= i_count;
+   }
+   return true;
+}
+
+int i_hex_end(t_encoder *p_encoder) /* Write any bytes held back and the end of file records, returns false if an address was out of range */
+{
+   char s_line[2 * HEX_LINE];
+   char *s_output = s_line;
+   unsigned char a_address[4];
+   unsigned long ul_start;
+   int i_length;
+
+   if (p_encoder->i_pending && !p_encoder->ul_error)
+   {
+      i_length = p_encoder->i_pending;
+      p_encoder->i_pending = 0;
+      i_encode(p_encoder, p_encoder->a_pending, i_length);
+   }
+   if (p_encoder->i_format == HEX_SOURCE) /* Close the array and give its length */
+   {
+      if (p_encoder->ul_address == p_encoder->ul_load) /* An array needs at least one element */
+         p_encoder->p_write(p_encoder->p_context, "  0x00\n", 7);
+      p_encoder->p_write(p_encoder->p_context, "};\nconst unsigned int ", 22);
+      v_symbol(p_encoder);
+      p_encoder->p_write(p_encoder->p_context, s_line, sprintf(s_line, "_len = %lu;\n", p_encoder->ul_address - p_encoder->ul_load));
+      return !p_encoder->ul_error;
+   }
+   ul_start = p_encoder->b_start ? p_encoder->ul_start : p_encoder->ul_load;
+   if (p_encoder->i_format == HEX_MOTOROLA)
+   {
+      if (i_hex_width(ul_start) > p_encoder->i_width) p_encoder->i_width = i_hex_width(ul_start); /* The start address may be above the image */
+      if (p_encoder->ul_records <= 0xFFFFUL) /* Record count */
+         s_output = s_motorola(s_output, 5, p_encoder->ul_records, 2, NULL, 0);
+      else if (p_encoder->ul_records <= 0xFFFFFFUL)
+         s_output = s_motorola(s_output, 6, p_encoder->ul_records, 3, NULL, 0);
+      s_output = s_motorola(s_output, 11 - p_encoder->i_width, ul_start, p_encoder->i_width, NULL, 0); /* S9, S8 or S7 */
+      p_encoder->p_write(p_encoder->p_context, s_line, s_output - s_line);
+      return !p_encoder->ul_error;
+   }
+   if (p_encoder->b_start || p_encoder->l_upper) /* Needed for images above 64K */
+   {
+      if (p_encoder->b_segment) /* Start segment address is CS:IP */
+      {
+         a_address[0] = (ul_start >> 12) & 0xF0;
+         a_address[1] = 0;
+      }
+      else
+      {
+         a_address[0] = (ul_start >> 24) & 0xFF;
+         a_address[1] = (ul_start >> 16) & 0xFF;
+      }
+      a_address[2] = (ul_start >> 8) & 0xFF;
+      a_address[3] = ul_start & 0xFF;
+      s_output = s_record(s_output, p_encoder->b_segment ? 3 : 5, 0, a_address, 4);
+   }
+   s_output = s_record(s_output, 1, 0, NULL, 0); /* End of file record */
+   p_encoder->p_write(p_encoder->p_context, s_line, s_output - s_line);
+   return !p_encoder->ul_error;
+}
+
+static inline void v_list(t_decoder *p_decoder, const char *s_text, size_t i_length) /* Add to the listing of the current record */
+{
+   if (p_decoder->i_line + i_length > sizeof(p_decoder->s_line))
+   {
+      if (p_decoder->p_list != NULL) p_decoder->p_list(p_decoder->p_context, p_decoder->s_line, p_decoder->i_line);
+      p_decoder->i_line = 0;
+   }
+   memcpy(p_decoder->s_line + p_decoder->i_line, s_text, i_length);
+   p_decoder->i_line += i_length;
+}
+
+static inline void v_load(t_decoder *p_decoder, int i_byte) /* Add a byte to the bytes loaded */
+{
+   if (p_decoder->i_length >= p_decoder->i_buffer)
+   {
+      p_decoder->p_write(p_decoder->p_context, p_decoder->s_buffer, p_decoder->i_length);
+      p_decoder->i_length = 0;
+   }
+   p_decoder->s_buffer[p_decoder->i_length++] = i_byte;
+}
+
+static inline int i_digit(t_decoder *p_decoder, int i_value, int i_char) /* Add a hexadecimal digit to a value */
+{
+   i_value <<= 4;
+   if (i_char >= '0' && i_char <= '9') i_value |= ((i_char - '0') & 0x0F);
+   else if (i_char >= 'a' && i_char <= 'f') i_value |= ((i_char - 'a' + 10) & 0x0F);
+   else if (i_char >= 'A' && i_char <= 'F') i_value |= ((i_char - 'A' + 10) & 0x0F);
+   else p_decoder->ul_errors++;
+   return i_value;
+}
+
+void v_hex_decoder(t_decoder *p_decoder, char *s_buffer, size_t i_buffer,
+   void (*p_write)(void *p_context, const char *p_data, size_t i_length),
+   void (*p_list)(void *p_context, const char *s_text, size_t i_length), void *p_context) /* Set up a decoder, the first byte is loaded at HEX_LOAD */
+{
+   memset(p_decoder, 0, sizeof(t_decoder));
+   p_decoder->p_write = p_write;
+   p_decoder->p_list = p_list;
+   p_decoder->p_context = p_context;
+   p_decoder->s_buffer = s_buffer;
+   p_decoder->i_buffer = i_buffer;
+   p_decoder->ul_offset = HEX_LOAD;
+   p_decoder->i_last = '\n';
+}
+
+void v_hex_decode(t_decoder *p_decoder, const char *s_text, size_t i_length) /* Read the next part of the records */
+{
+   const char *s_end = s_text + i_length;
+   int i_char;
+
+   for (; s_text < s_end; s_text++)
+   {
+      i_char = (unsigned char) *s_text;
+      switch (p_decoder->i_count)
+      {
+         case 0: /* Check for start of record */
+            if (((p_decoder->i_last == '\n') || (p_decoder->i_last == '\r')) && (i_char == ':')) /* Start of record */
+            {
+               v_list(p_decoder, ":", 1);
+               p_decoder->i_bytes = 0; /* Reset values */
+               p_decoder->i_address = 0;
+               p_decoder->i_type = 0;
+               p_decoder->i_data = 0;
+               p_decoder->i_checksum = 0;
+               p_decoder->i_count++;
+            }
+            break;
+         case 1: /* Get number of bytes in record */
+         case 2:
+            p_decoder->i_bytes = i_digit(p_decoder, p_decoder->i_bytes, i_char);
+            if (p_decoder->i_count == 2) v_list(p_decoder, a_hex + 2 * p_decoder->i_bytes, 2);
+            p_decoder->i_count++;
+            break;
+         case 3: /* Get address of bytes in record */
+         case 4:
+         case 5:
+         case 6:
+            p_decoder->i_address = i_digit(p_decoder, p_decoder->i_address, i_char);
+            if (p_decoder->i_count == 6)
+            {
+               v_list(p_decoder, a_hex + 2 * (p_decoder->i_address >> 8), 2);
+               v_list(p_decoder, a_hex + 2 * (p_decoder->i_address & 0xFF), 2);
+               while (p_decoder->ul_offset < (unsigned long) p_decoder->i_address) /* If the address of the next record is greater than the current offset then pad output with NOPs */
+               {
+                  p_decoder->ul_offset++;
+                  v_load(p_decoder, 0x00);
+               }
+            }
+            p_decoder->i_count++;
+            break;
+         case 7: /* Get record type */
+         case 8:
+            p_decoder->i_type = i_digit(p_decoder, p_decoder->i_type, i_char);
+            if (p_decoder->i_count == 8)
+            {
+               v_list(p_decoder, a_hex + 2 * p_decoder->i_type, 2);
+               if (!p_decoder->i_type && (unsigned long) p_decoder->i_address < p_decoder->ul_offset) p_decoder->ul_errors++; /* Data can't go backwards! */
+            }
+            p_decoder->i_checksum = p_decoder->i_bytes + p_decoder->i_type + (p_decoder->i_address / 256) + (p_decoder->i_address % 256);
+            p_decoder->i_count++;
+            break;
+         default:
+            if (i_char == '\r' || i_char == '\n')
+            {
+               p_decoder->i_count = 0; /* Read next record */
+               p_decoder->ul_records++;
+               if (p_decoder->i_bytes >= 0)
+               {
+                  p_decoder->ul_errors++;
+                  v_list(p_decoder, " - Error", 8);
+               }
+               v_list(p_decoder, "\n", 1);
+               if (p_decoder->p_list != NULL) p_decoder->p_list(p_decoder->p_context, p_decoder->s_line, p_decoder->i_line);
+               p_decoder->i_line = 0;
+            }
+            else
+            {
+               p_decoder->i_data = i_digit(p_decoder, p_decoder->i_data, i_char);
+               p_decoder->i_count++;
+               if (p_decoder->i_count % 2)
+               {
+                  v_list(p_decoder, a_hex + 2 * p_decoder->i_data, 2);
+                  if (p_decoder->i_bytes)
+                  {
+                     v_load(p_decoder, p_decoder->i_data);
+                     p_decoder->ul_offset++;
+                     p_decoder->i_checksum += p_decoder->i_data;
+                  }
+                  else
+                  {
+                     p_decoder->i_checksum = (~(p_decoder->i_checksum & 0xFF) + 1) & 0xFF;
+                     if (p_decoder->i_checksum != p_decoder->i_data)
+                     {
+                        p_decoder->ul_errors++;
+                        v_list(p_decoder, " - Error", 8);
+                     }
+                     else
+                        v_list(p_decoder, " - Ok", 5);
+                  }
+                  p_decoder->i_bytes--;
+                  p_decoder->i_data = 0; /* Reset value before reading next byte */
+               }
+            }
+      }
+      if (p_decoder->i_last != '\n' || i_char != '\0') p_decoder->i_last = i_char; /* Ignore any leading NULL chracters at the start of each record */
+   }
+}
+
+unsigned long ul_hex_flush(t_decoder *p_decoder) /* Pass on everything collected, returns the number of errors */
+{
+   if (p_decoder->i_length) p_decoder->p_write(p_decoder->p_context, p_decoder->s_buffer, p_decoder->i_length);
+   if (p_decoder->i_line && p_decoder->p_list != NULL) p_decoder->p_list(p_decoder->p_context, p_decoder->s_line, p_decoder->i_line);
+   p_decoder->i_length = 0;
+   p_decoder->i_line = 0;
+   return p_decoder->ul_errors;
+}
+
+static int i_nibble(int i_char) /* Return the value of a hexadecimal digit or -1 */
+{
+   if (i_char >= '0' && i_char <= '9') return (i_char - '0');
+   if (i_char >= 'a' && i_char <= 'f') return (i_char - 'a' + 10);
+   if (i_char >= 'A' && i_char <= 'F') return (i_char - 'A' + 10);
+   return -1;
+}
+
+int i_hex_record(const char *s_line, t_record *p_record) /* Read a single Intel Hex or 'S' record from a line, returns HEX_VALID or why it can't be used */
+{
+   static const int a_intel[] = {-1, 0, 2, 4, 2, 4}; /* Data bytes needed by each type of Intel Hex record, or -1 for any number */
+   static const int a_width[] = {2, 2, 3, 4, 0, 2, 3, 4, 3, 2}; /* Address bytes in each type of 'S' record, or 0 if unknown */
+   unsigned char a_bytes[HEX_RECORD_MAX + 6]; /* Length, address, type, data and checksum */
+   unsigned int i_checksum = 0;
+   int i_bytes, i_high, i_low, i_width;
+
+   while (*s_line == ' ' || *s_line == '\t') s_line++; /* Skip leading blanks */
+   if (*s_line != ':' && ((*s_line != 'S' && *s_line != 's') || s_line[1] < '0' || s_line[1] > '9' || i_nibble(s_line[2]) < 0))
+      return HEX_SKIP; /* Ignore anything that isn't a record, including text that starts with an 'S' */
+   p_record->b_motorola = (*s_line++ != ':');
+   if (p_record->b_motorola) p_record->i_type = *s_line++ - '0';
+   for (i_bytes = 0; (i_high = i_nibble(s_line[0])) >= 0 && (i_low = i_nibble(s_line[1])) >= 0; i_bytes++, s_line += 2)
+   {
+      if (i_bytes >= sizeof(a_bytes)) return HEX_LENGTH;
+      a_bytes[i_bytes] = (i_high << 4) | i_low;
+      i_checksum += a_bytes[i_bytes];
+   }
+   while (*s_line == ' ' || *s_line == '\t' || *s_line == '\r' || *s_line == '\n') s_line++;
+   if (*s_line) return HEX_CHARACTER;
+   if (!p_record->b_motorola) /* Intel Hex */
+   {
+      if (i_bytes < 5 || a_bytes[0] != i_bytes - 5) return HEX_LENGTH;
+      if (i_checksum & 0xFF) return HEX_CHECKSUM;
+      p_record->i_type = a_bytes[3];
+      if (p_record->i_type > 5) return HEX_TYPE;
+      if (a_intel[p_record->i_type] >= 0 && a_bytes[0] != a_intel[p_record->i_type]) return HEX_LENGTH; /* Can't read beyond the data */
+      p_record->ul_address = (a_bytes[1] << 8) | a_bytes[2];
+      p_record->i_bytes = a_bytes[0];
+      memcpy(p_record->a_data, a_bytes + 4, p_record->i_bytes);
+      return HEX_VALID;
+   }
+   if (i_bytes < 3 || a_bytes[0] != i_bytes - 1) return HEX_LENGTH; /* Motorola 'S' record */
+   if ((i_checksum & 0xFF) != 0xFF) return HEX_CHECKSUM;
+   if (p_record->i_type < 0 || p_record->i_type > 9 || !(i_width = a_width[p_record->i_type])) return HEX_TYPE;
+   if (a_bytes[0] < i_width + 1 || (p_record->i_type > 3 && a_bytes[0] != i_width + 1)) return HEX_LENGTH; /* Only S0 to S3 hold data */
+   for (p_record->ul_address = 0, i_high = 1; i_high <= i_width; i_high++)
+      p_record->ul_address = (p_record->ul_address << 8) | a_bytes[i_high];
+   p_record->i_bytes = a_bytes[0] - i_width - 1;
+   memcpy(p_record->a_data, a_bytes + 1 + i_width, p_record->i_bytes);
+   return HEX_VALID;
+}
@@ -0,0 +1,134 @@
+/*
+ * gcc-hex.h
+ *
+ * Copyright(C) 2026   MT
+ *
+ * Reads and writes Intel Hex records, and writes Motorola 'S' records and
+ * C arrays, for use by other programs as well as 'load' and 'unload'.
+ *
+ * Nothing  is  allocated  and  no files are used.  The  caller  passes  in
+ * whatever  it has read in blocks of any size, and text or bytes are given
+ * back  to  the caller through a function it  supplies,  using  buffers  it
+ * supplies, as soon as they are ready.
+ *
+ * This  program is free software: you can redistribute it and/or modify it
+ * under  the terms of the GNU General Public License as published  by  the
+ * Free  Software Foundation, either version 3 of the License, or (at  your
+ * option) any later version.
+ *
+ * This  program  is distributed in the hope that it will  be  useful,  but
+ * WITHOUT   ANY   WARRANTY;   without even   the   implied   warranty   of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You  should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * 18 Oct 26         - Initial version - MT
+ *                   - Reads a single Intel Hex or 'S' record from a line,
+ *                     checking its length is right for its type - MT
+ *
+ */
+
+#if !defined(GCC_HEX_H) /* Only include once */
+#define GCC_HEX_H
+
+#include <stddef.h>
+
+#define  HEX_INTEL     0                      /* Intel Hex records */
+#define  HEX_MOTOROLA  1                      /* Motorola 'S' records */
+#define  HEX_SOURCE    2                      /* An array in C source code */
+
+#define  HEX_LOAD      0x0100                 /* Default load address (CP/M-80) */
+#define  HEX_SIZE      16                     /* Default number of data bytes in each record */
+#define  HEX_RECORD_MAX 255                   /* Largest number of data bytes in a record */
+#define  HEX_MOTOROLA_MAX 250                 /* Largest number of data bytes in an 'S' record with a four byte address */
+#define  HEX_LINE      (2 * HEX_RECORD_MAX + 24) /* Longest record including the newline */
+#define  HEX_BUFFER_MIN 4096                  /* Smallest buffer that can be given to an encoder */
+
+#define  HEX_VALID     0                      /* Results of reading a single record */
+#define  HEX_SKIP      1                      /* Not a record */
+#define  HEX_CHARACTER 2                      /* Invalid character in the record */
+#define  HEX_LENGTH    3                      /* Length is wrong for the record or its type */
+#define  HEX_CHECKSUM  4                      /* Checksum error */
+#define  HEX_TYPE      5                      /* Unknown record type */
+
+typedef struct
+{
+   char *s_output; /* Formatted records */
+   size_t i_output; /* Number of characters in the buffer */
+   long l_first; /* Upper address bits of the first data record, or -1 if there are no records */
+   long l_last; /* Upper address bits of the last data record */
+   unsigned long ul_error; /* Address that was out of range, or zero */
+   unsigned long ul_records; /* Number of data records */
+} t_chunk;
+
+typedef struct
+{
+   int i_format; /* HEX_INTEL, HEX_MOTOROLA or HEX_SOURCE */
+   int i_size; /* Number of data bytes in each record */
+   int i_width; /* Number of address bytes in each 'S' record (2-4) */
+   int i_filler; /* Leave out records that only contain this byte, or -1 */
+   char b_segment; /* Use extended segment addresses instead of extended linear addresses */
+   char b_start; /* Write a start address record */
+   unsigned long ul_load; /* Address of the first byte */
+   unsigned long ul_start; /* Start address */
+   void (*p_write)(void *p_context, const char *s_text, size_t i_length); /* Called with the formatted text */
+   void *p_context; /* Passed to p_write */
+   char *s_buffer; /* Caller's buffer used to format records */
+   size_t i_buffer; /* Size of the buffer */
+   const char *s_name; /* File name used for the header or the name of the array */
+   unsigned long ul_address; /* Address of the next byte */
+   long l_upper; /* Upper address bits of the last data record written */
+   unsigned long ul_records; /* Number of data records written */
+   unsigned long ul_error; /* Address that was out of range, or zero */
+   int i_pending; /* Number of bytes held back until a record is complete */
+   unsigned char a_pending[HEX_RECORD_MAX];
+} t_encoder;
+
+typedef struct
+{
+   void (*p_write)(void *p_context, const char *p_data, size_t i_length); /* Called with the bytes loaded */
+   void (*p_list)(void *p_context, const char *s_text, size_t i_length); /* Called with a listing of each record, or NULL */
+   void *p_context; /* Passed to p_write and p_list */
+   char *s_buffer; /* Caller's buffer used to collect the bytes loaded */
+   size_t i_buffer; /* Size of the buffer */
+   size_t i_length; /* Number of bytes in the buffer */
+   unsigned long ul_offset; /* Address of the next byte */
+   unsigned long ul_records; /* Number of records read */
+   unsigned long ul_errors; /* Number of errors found */
+   int i_last, i_count; /* Last character and position in the record */
+   int i_bytes, i_address, i_type, i_data, i_checksum; /* Fields of the current record */
+   size_t i_line; /* Number of characters in the listing */
+   char s_line[HEX_LINE]; /* Listing of the current record */
+} t_decoder;
+
+typedef struct
+{
+   char b_motorola; /* An 'S' record rather than an Intel Hex record */
+   int i_type; /* Record type, 0-5 for Intel Hex or 0-9 for an 'S' record */
+   unsigned long ul_address; /* Address, or the count for an S5 or S6 record */
+   int i_bytes; /* Number of data bytes */
+   unsigned char a_data[HEX_RECORD_MAX];
+} t_record;
+
+void v_hex_encoder(t_encoder *p_encoder, char *s_buffer, size_t i_buffer,
+   void (*p_write)(void *p_context, const char *s_text, size_t i_length), void *p_context); /* Set up an encoder with the default options */
+int i_hex_width(unsigned long ul_last); /* Number of address bytes needed for 'S' records up to an address */
+unsigned long ul_hex_align(const t_encoder *p_encoder, unsigned long ul_address); /* Return the start of the record that contains an address */
+size_t i_hex_capacity(const t_encoder *p_encoder, unsigned long ul_length); /* Size of buffer needed to hold the records for some bytes */
+void v_hex_format(const t_encoder *p_encoder, t_chunk *p_chunk, const unsigned char *p_data, unsigned long ul_address, unsigned long ul_length); /* Format the records for a chunk */
+void v_hex_begin(t_encoder *p_encoder, const char *s_name); /* Start a new file and write the header */
+int i_hex_write(t_encoder *p_encoder, t_chunk *p_chunk); /* Write the records for a chunk */
+int i_hex_encode(t_encoder *p_encoder, const unsigned char *p_data, size_t i_length); /* Write records for the next bytes */
+int i_hex_end(t_encoder *p_encoder); /* Write any bytes held back and the end of file records */
+
+void v_hex_decoder(t_decoder *p_decoder, char *s_buffer, size_t i_buffer,
+   void (*p_write)(void *p_context, const char *p_data, size_t i_length),
+   void (*p_list)(void *p_context, const char *s_text, size_t i_length), void *p_context); /* Set up a decoder */
+void v_hex_decode(t_decoder *p_decoder, const char *s_text, size_t i_length); /* Read the next part of the records */
+unsigned long ul_hex_flush(t_decoder *p_decoder); /* Pass on everything collected, returns the number of errors */
+
+int i_hex_record(const char *s_line, t_record *p_record); /* Read a single Intel Hex or 'S' record from a line */
+
+#endif
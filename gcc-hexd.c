@@ -0,0 +1,692 @@
+/*
+ * hexd.c
+ *
+ * Copyright(C) 2026   MT
+ *
+ * Converts  files  to and from Intel Hex for other programs, listening  on
+ * a  Unix  domain  socket so that a build only has to start  one  program
+ * however many files it converts.
+ *
+ * Each  request  is a single packet holding a line of text with the  files
+ * to  read  and write passed as open file descriptors, so the  server  never
+ * opens  a  path  itself  and the data never passes  through  the  socket.
+ * Requests on each connection are answered in order by one of a fixed number
+ * of  threads that keep their buffers from one request to the  next.   A
+ * connection  only  goes  to a thread when a request  has  arrived,  and
+ * goes back to wait for the next one afterwards, so idle clients never hold
+ * a thread.
+ *
+ *   convert [NAME]...            read Intel Hex and write the bytes loaded
+ *   verify [NAME]...             read Intel Hex and only check it
+ *   dump [OPTION]... [NAME]...   write records for a file, the options are
+ *                                the same as for 'gcc-unload' and the first
+ *                                NAME is used for the header or array name
+ *
+ * Each reply is a single packet holding either 'ok RECORDS ERRORS BYTES' or
+ * 'error MESSAGE'.  The same program can be used as a client, reading the
+ * requests  from a file with the names of the files to use at the end  of
+ * each line.
+ *
+ * Deliberatly avoids using 'getopt' or 'argparse' to maximize portability.
+ *
+ * This  program is free software: you can redistribute it and/or modify it
+ * under  the terms of the GNU General Public License as published  by  the
+ * Free  Software Foundation, either version 3 of the License, or (at  your
+ * option) any later version.
+ *
+ * This  program  is distributed in the hope that it will  be  useful,  but
+ * WITHOUT   ANY   WARRANTY;   without even   the   implied   warranty   of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You  should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * 18 Oct 26   0.1   - Initial version - MT
+ *                   - Added '--stats' to print what was done - MT
+ *                   - Checks the record size and fill byte for a dump
+ *                     before they are narrowed to an int - MT
+ *                   - Only removes a socket that no server is listening
+ *                     on before binding to the name - MT
+ *                   - Uses the option helpers in the shared module, and
+ *                     checks the number of jobs before it is narrowed - MT
+ *                   - Rejects a request if the files passed with it were
+ *                     lost, and only gives a thread a connection with a
+ *                     request waiting, taking it back after each one - MT
+ *
+ */
+
+#define  NAME        "gcc-hexd"
+#define  VERSION     "0.1"
+#define  BUILD       "0006"
+#define  AUTHOR      "MT"
+#define  COPYRIGHT   (__DATE__ + 7) /* Extract copyright year from date */
+
+#define  JOBS_MAX    64                       /* Largest number of threads */
+#define  QUEUE_SIZE  256                      /* Connections waiting for a thread */
+#define  REQUEST_SIZE 1024                    /* Longest request or reply */
+#define  ARGS_MAX    64                       /* Largest number of words in a request */
+#define  FILES_MAX   2                        /* Files passed with a request */
+#define  WINDOW      16                       /* Requests a client sends before waiting for a reply */
+#define  SOURCE_SIZE 12                       /* Default number of bytes on each line of a C array */
+
+#define  false       0
+#define  true        !false
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+
+#if defined(VMS) || defined(MSDOS) || defined (WIN32)
+#undef   SERVER
+#else
+#define  SERVER /* Needs Unix domain sockets that can pass file descriptors and POSIX threads */
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+#include "gcc-io.h"
+#include "gcc-hex.h"
+
+char s_program[] = NAME;
+
+void v_version() /* Display version information */
+{
+   fprintf(stderr, "%s: Version %s\n", NAME, VERSION);
+   fprintf(stdout, "Copyright(C) %s %s\n", COPYRIGHT, AUTHOR);
+   fprintf(stdout, "License GPLv3+: GNU GPL version 3 or later <http://gnu.org/licenses/gpl.html>.\n");
+   fprintf(stdout, "This is free software: you are free to change and redistribute it.\n");
+   fprintf(stdout, "There is NO WARRANTY, to the extent permitted by law.\n");
+   exit(0);
+}
+
+void v_about() /* Display help text */
+{
+   fprintf(stdout, "Usage: %s [OPTION]... SOCKET\n", NAME);
+   fprintf(stdout, "  or:  %s --client SOCKET [FILE]\n", NAME);
+   fprintf(stdout, "Converts files to and from intel hexadecimal for programs connected to SOCKET.\n\n");
+   fprintf(stdout, "  -c, --client             send each line of FILE as a request and print the replies\n");
+   fprintf(stdout, "  -j, --jobs N             use N threads to serve connections (default 4)\n");
+   fprintf(stdout, "      --stats              print what was done on exit\n");
+   fprintf(stdout, "      --stats-json         print what was done on exit in JSON\n");
+   fprintf(stdout, "  -?, --help               display this help and exit\n");
+   fprintf(stdout, "      --version            output version information and exit\n");
+   fprintf(stdout, "\nRequests:\n");
+   fprintf(stdout, "  convert [IN OUT]         load intel hexadecimal from IN and write the bytes to OUT\n");
+   fprintf(stdout, "  verify [IN]              check the records in IN\n");
+   fprintf(stdout, "  dump [OPTION]... [IN OUT]  write the records for IN to OUT, using the same\n");
+   fprintf(stdout, "                           options as gcc-unload (-a -f -i -r -s -t -x)\n");
+   fprintf(stdout, "\nThe server is passed the open files, a client names them at the end of each line.\n");
+   fprintf(stdout, "With no FILE read standard input.\n");
+   exit(0);
+}
+
+#if defined(SERVER)
+typedef struct
+{
+   pthread_t t_thread;
+   char *s_input; /* Block read from the input file */
+   char *s_text; /* Records being formatted or bytes being loaded */
+   char *s_output; /* Output waiting to be written */
+} t_worker;
+
+t_worker a_workers[JOBS_MAX];
+int a_queue[QUEUE_SIZE]; /* Connections with a request waiting for a thread */
+int i_first, i_waiting; /* Oldest connection in the queue and the number waiting */
+pthread_mutex_t t_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t t_changed = PTHREAD_COND_INITIALIZER;
+int a_returned[2]; /* Pipe the threads use to hand connections back to wait for their next request */
+volatile sig_atomic_t b_stop = false; /* Set when the server is asked to stop */
+
+long l_word(char *s_arg) /* Convert a decimal, octal or hexadecimal value in a request, returns -1 if it is not valid */
+{
+   char *s_end;
+   long l_value;
+
+   if (s_arg == NULL) return -1;
+   errno = 0;
+   l_value = strtol(s_arg, &s_end, 0);
+   if (errno || s_end == s_arg || *s_end != 0 || l_value < 0) return -1;
+   return l_value;
+}
+
+ssize_t i_block(int h_file, char *s_buffer, size_t i_size) /* Read the next block, returns -1 if there was an error */
+{
+   ssize_t i_read;
+
+   stats_enter(STATS_READ);
+   do
+   {
+      stats_count(ul_read, 1);
+      i_read = read(h_file, s_buffer, i_size);
+   } while (i_read < 0 && errno == EINTR);
+   stats_leave();
+   if (i_read > 0) stats_count(ull_in, i_read);
+   return i_read;
+}
+
+int i_reply(int h_socket, const char *s_fmt, ...) /* Send a reply, returns false if the client has gone */
+{
+   char s_reply[REQUEST_SIZE];
+   va_list t_args;
+   int i_length;
+
+   va_start(t_args, s_fmt);
+   i_length = vsnprintf(s_reply, sizeof(s_reply), s_fmt, t_args);
+   va_end(t_args);
+   if (i_length >= sizeof(s_reply)) i_length = sizeof(s_reply) - 1;
+   return (send(h_socket, s_reply, i_length, MSG_NOSIGNAL) == i_length);
+}
+
+int i_receive(int h_socket, char *s_request, int *a_files) /* Receive a request and the files passed with it, returns the number of files, -1 if the connection was closed or -2 if some files were lost */
+{
+   union { struct cmsghdr t_header; char a_space[CMSG_SPACE(FILES_MAX * sizeof(int))]; } t_control; /* Aligned for the header */
+   struct msghdr t_message;
+   struct cmsghdr *p_header;
+   struct iovec t_part;
+   ssize_t i_length;
+   int i_files = 0, i_count, i_passed, h_file;
+
+   memset(&t_message, 0, sizeof(t_message));
+   t_part.iov_base = s_request;
+   t_part.iov_len = REQUEST_SIZE - 1;
+   t_message.msg_iov = &t_part;
+   t_message.msg_iovlen = 1;
+   t_message.msg_control = t_control.a_space;
+   t_message.msg_controllen = sizeof(t_control.a_space);
+   while ((i_length = recvmsg(h_socket, &t_message, 0)) < 0 && errno == EINTR);
+   if (i_length <= 0) return -1; /* Connection closed */
+   s_request[i_length] = 0;
+   for (p_header = CMSG_FIRSTHDR(&t_message); p_header != NULL; p_header = CMSG_NXTHDR(&t_message, p_header))
+   {
+      if (p_header->cmsg_level != SOL_SOCKET || p_header->cmsg_type != SCM_RIGHTS) continue;
+      i_passed = (p_header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      for (i_count = 0; i_count < i_passed; i_count++)
+      {
+         memcpy(&h_file, CMSG_DATA(p_header) + i_count * sizeof(int), sizeof(int));
+         if (i_files < FILES_MAX)
+            a_files[i_files++] = h_file;
+         else
+            close(h_file); /* Too many, don't keep them open */
+      }
+   }
+   if (t_message.msg_flags & MSG_CTRUNC) /* More files than there was room for, or no descriptors left */
+   {
+      while (i_files > 0) close(a_files[--i_files]);
+      return -2;
+   }
+   return i_files;
+}
+
+void v_sink(void *p_context, const char *s_text, size_t i_length) /* Append to an output file */
+{
+   v_write((t_output *) p_context, s_text, i_length);
+   ((t_output *) p_context)->ul_count += i_length;
+}
+
+void v_discard(void *p_context, const char *s_text, size_t i_length) /* Throw away the bytes loaded when only checking the records */
+{
+}
+
+int i_options(t_encoder *p_encoder, char **a_args, int i_args, char **s_name, char *s_error) /* Set the options for a dump, returns false if they are not valid */
+{
+   char *s_option;
+   long l_value = 0;
+   int i_count;
+
+   *s_name = "";
+   p_encoder->i_size = 0;
+   for (i_count = 1; i_count < i_args; i_count++)
+   {
+      s_option = a_args[i_count];
+      if (s_option[0] != '-' || s_option[1] == 0 || s_option[2] != 0)
+      {
+         if (!**s_name) *s_name = s_option; /* First file name */
+         continue;
+      }
+      if (strchr("afrt", s_option[1]) != NULL && ((l_value = l_word(i_count + 1 < i_args ? a_args[++i_count] : NULL)) < 0 ||
+         (strchr("fr", s_option[1]) != NULL && l_value > 0xFF))) /* Check a size or a byte before it is narrowed */
+      {
+         sprintf(s_error, "invalid value for option %s", s_option);
+         return false;
+      }
+      switch (s_option[1])
+      {
+      case 'a': p_encoder->ul_load = l_value; break;
+      case 'f': p_encoder->i_filler = l_value; break;
+      case 'i': p_encoder->i_format = HEX_SOURCE; break;
+      case 'r': p_encoder->i_size = l_value; break;
+      case 's': p_encoder->i_format = HEX_MOTOROLA; break;
+      case 't': p_encoder->ul_start = l_value; p_encoder->b_start = true; break;
+      case 'x': p_encoder->b_segment = true; break;
+      default:
+         sprintf(s_error, "unknown option %s", s_option);
+         return false;
+      }
+   }
+   if (p_encoder->i_size == 0) p_encoder->i_size = (p_encoder->i_format == HEX_SOURCE) ? SOURCE_SIZE : HEX_SIZE;
+   if (p_encoder->i_format == HEX_SOURCE) p_encoder->i_filler = -1; /* Every byte must be in the array */
+   if (p_encoder->i_size < 1 || p_encoder->i_size > (p_encoder->i_format == HEX_MOTOROLA ? HEX_MOTOROLA_MAX : HEX_RECORD_MAX))
+   {
+      sprintf(s_error, "invalid record size %d", p_encoder->i_size);
+      return false;
+   }
+   if (p_encoder->i_filler > 0xFF)
+   {
+      sprintf(s_error, "invalid fill byte %d", p_encoder->i_filler);
+      return false;
+   }
+   return true;
+}
+
+void v_request(t_worker *p_worker, int h_socket, char *s_request, int *a_files, int i_files) /* Carry out a request and send the reply */
+{
+   char *a_args[ARGS_MAX + 1];
+   char s_error[REQUEST_SIZE];
+   t_output t_output = {p_worker->s_output, 0, IO_OUTPUT, -1, 0, 0};
+   t_decoder t_decoder;
+   t_encoder t_encoder;
+   struct stat t_file_d;
+   char *s_name;
+   ssize_t i_length = 0;
+   int i_args, i_needed;
+
+   for (i_args = 0, a_args[0] = strtok(s_request, " \t\r\n"); a_args[i_args] != NULL && i_args < ARGS_MAX; )
+      a_args[++i_args] = strtok(NULL, " \t\r\n");
+   if (!i_args)
+   {
+      i_reply(h_socket, "error empty request\n");
+      return;
+   }
+   i_needed = !strcmp(a_args[0], "verify") ? 1 : (!strcmp(a_args[0], "convert") || !strcmp(a_args[0], "dump")) ? 2 : 0;
+   if (!i_needed)
+   {
+      i_reply(h_socket, "error unknown request %s\n", a_args[0]);
+      return;
+   }
+   if (i_files != i_needed)
+   {
+      i_reply(h_socket, "error %s needs %d file%s, %d passed\n", a_args[0], i_needed, i_needed > 1 ? "s" : "", i_files);
+      return;
+   }
+   if (i_needed > 1) t_output.h_file = a_files[1];
+   stats_count(ul_files, 1);
+   if (a_args[0][0] == 'd') /* Dump */
+   {
+      v_hex_encoder(&t_encoder, p_worker->s_text, IO_OUTPUT, v_sink, &t_output);
+      if (!i_options(&t_encoder, a_args, i_args, &s_name, s_error))
+      {
+         i_reply(h_socket, "error %s\n", s_error);
+         return;
+      }
+      if (!fstat(a_files[0], &t_file_d) && S_ISREG(t_file_d.st_mode))
+         t_encoder.i_width = i_hex_width(t_encoder.ul_load + (t_file_d.st_size ? t_file_d.st_size - 1 : 0));
+      stats_stage(STATS_FORMAT);
+      v_hex_begin(&t_encoder, s_name);
+      while ((i_length = i_block(a_files[0], p_worker->s_input, IO_BLOCK)) > 0)
+         if (!i_hex_encode(&t_encoder, (unsigned char *) p_worker->s_input, i_length)) break;
+      i_hex_end(&t_encoder);
+      stats_stage(STATS_OTHER);
+      stats_count(ull_records, t_encoder.ul_records);
+      if (i_length < 0)
+         i_reply(h_socket, "error Cannot read: %s\n", s_reason(errno));
+      else if (!i_flush(&t_output))
+         i_reply(h_socket, "error Cannot write: %s\n", s_reason(errno));
+      else if (t_encoder.ul_error)
+         i_reply(h_socket, "error Address %lX is out of range\n", t_encoder.ul_error);
+      else
+         i_reply(h_socket, "ok %lu 0 %lu\n", t_encoder.ul_records, t_output.ul_count);
+      return;
+   }
+   stats_stage(STATS_PARSE);
+   v_hex_decoder(&t_decoder, p_worker->s_text, IO_BLOCK, (i_needed > 1) ? v_sink : v_discard, NULL, &t_output);
+   while ((i_length = i_block(a_files[0], p_worker->s_input, IO_BLOCK)) > 0)
+      v_hex_decode(&t_decoder, p_worker->s_input, i_length);
+   ul_hex_flush(&t_decoder);
+   stats_stage(STATS_OTHER);
+   stats_count(ull_records, t_decoder.ul_records);
+   if (i_length < 0)
+      i_reply(h_socket, "error Cannot read: %s\n", s_reason(errno));
+   else if (!i_flush(&t_output))
+      i_reply(h_socket, "error Cannot write: %s\n", s_reason(errno));
+   else
+      i_reply(h_socket, "ok %lu %lu %lu\n", t_decoder.ul_records, t_decoder.ul_errors, t_output.ul_count);
+}
+
+void *p_serve(void *p_arg) /* Answer one request from each connection taken from the queue */
+{
+   t_worker *p_worker = (t_worker *) p_arg;
+   char s_request[REQUEST_SIZE];
+   int a_files[FILES_MAX];
+   int h_socket, i_files, i_count;
+
+   for (;;)
+   {
+      pthread_mutex_lock(&t_lock);
+      while (!i_waiting)
+         pthread_cond_wait(&t_changed, &t_lock);
+      h_socket = a_queue[i_first];
+      i_first = (i_first + 1) % QUEUE_SIZE;
+      i_waiting--;
+      pthread_cond_broadcast(&t_changed);
+      pthread_mutex_unlock(&t_lock);
+
+      if ((i_files = i_receive(h_socket, s_request, a_files)) == -1)
+      {
+         close(h_socket);
+         continue;
+      }
+      if (i_files < 0)
+         i_reply(h_socket, "error Cannot receive the files passed, at most %d\n", FILES_MAX);
+      else
+         v_request(p_worker, h_socket, s_request, a_files, i_files);
+      for (i_count = 0; i_count < i_files; i_count++) close(a_files[i_count]);
+      while (write(a_returned[1], &h_socket, sizeof(h_socket)) < 0 && errno == EINTR); /* Wait for the next request */
+   }
+   return NULL;
+}
+
+int i_stale(struct sockaddr_un *p_address) /* Check for a socket left behind by a server that was killed, returns true if it was removed */
+{
+   struct stat t_file_d;
+   int h_probe, i_refused = false, i_error = errno; /* Keep the reason the name is in use */
+
+   if (!lstat(p_address->sun_path, &t_file_d) && S_ISSOCK(t_file_d.st_mode) && (h_probe = socket(AF_UNIX, SOCK_SEQPACKET, 0)) >= 0)
+   {
+      i_refused = (connect(h_probe, (struct sockaddr *) p_address, sizeof(*p_address)) && errno == ECONNREFUSED); /* Nothing listening */
+      close(h_probe);
+   }
+   if (i_refused && !unlink(p_address->sun_path)) return true;
+   errno = i_error;
+   return false;
+}
+
+void v_queue(int h_socket) /* Give a connection with a request waiting to the threads */
+{
+   pthread_mutex_lock(&t_lock);
+   while (i_waiting >= QUEUE_SIZE)
+      pthread_cond_wait(&t_changed, &t_lock);
+   a_queue[(i_first + i_waiting++) % QUEUE_SIZE] = h_socket;
+   pthread_cond_broadcast(&t_changed);
+   pthread_mutex_unlock(&t_lock);
+}
+
+void v_idle(struct pollfd **a_polls, int *i_polls, int *i_size, int h_socket) /* Add a connection to those waiting for a request */
+{
+   if (*i_polls >= *i_size && (*a_polls = realloc(*a_polls, (*i_size = 2 * *i_size + 64) * sizeof(struct pollfd))) == NULL)
+   {
+      v_error("Cannot allocate memory: %s\n", s_reason(errno));
+      exit(-1);
+   }
+   (*a_polls)[*i_polls].fd = h_socket;
+   (*a_polls)[*i_polls].events = POLLIN;
+   (*a_polls)[(*i_polls)++].revents = 0;
+}
+
+void v_stop(int i_signal) /* Stop accepting connections */
+{
+   b_stop = true;
+}
+
+int i_server(char *s_path, int i_jobs) /* Accept connections and queue them for the threads when a request arrives, returns when asked to stop */
+{
+   struct sockaddr_un t_address;
+   struct sigaction t_action;
+   struct pollfd *a_polls = NULL; /* Listening socket, returned connections and connections waiting for a request */
+   int h_listen, h_socket, i_count, i_error, i_polls = 0, i_size = 0;
+
+   if (strlen(s_path) >= sizeof(t_address.sun_path))
+   {
+      v_error("Cannot use %s: Name too long\n", s_path);
+      return false;
+   }
+   memset(&t_address, 0, sizeof(t_address));
+   t_address.sun_family = AF_UNIX;
+   strcpy(t_address.sun_path, s_path);
+   if ((h_listen = socket(AF_UNIX, SOCK_SEQPACKET, 0)) < 0)
+   {
+      v_error("Cannot create socket: %s\n", s_reason(errno));
+      return false;
+   }
+   if ((bind(h_listen, (struct sockaddr *) &t_address, sizeof(t_address)) && (errno != EADDRINUSE || !i_stale(&t_address) ||
+      bind(h_listen, (struct sockaddr *) &t_address, sizeof(t_address)))) || listen(h_listen, QUEUE_SIZE))
+   {
+      v_error("Cannot listen on %s: %s\n", s_path, s_reason(errno));
+      close(h_listen);
+      return false;
+   }
+   if (pipe(a_returned))
+   {
+      v_error("Cannot create pipe: %s\n", s_reason(errno));
+      exit(-1);
+   }
+   v_idle(&a_polls, &i_polls, &i_size, h_listen);
+   v_idle(&a_polls, &i_polls, &i_size, a_returned[0]);
+   for (i_count = 0; i_count < i_jobs; i_count++) /* Each thread keeps its buffers for every request */
+   {
+      a_workers[i_count].s_input = malloc(IO_BLOCK);
+      a_workers[i_count].s_text = malloc(IO_OUTPUT);
+      a_workers[i_count].s_output = malloc(IO_OUTPUT);
+      if (a_workers[i_count].s_input == NULL || a_workers[i_count].s_text == NULL || a_workers[i_count].s_output == NULL)
+      {
+         v_error("Cannot allocate memory: %s\n", s_reason(errno));
+         exit(-1);
+      }
+      if ((i_error = pthread_create(&a_workers[i_count].t_thread, NULL, p_serve, &a_workers[i_count])))
+      {
+         v_error("Cannot start thread: %s\n", s_reason(i_error));
+         exit(-1);
+      }
+   }
+   memset(&t_action, 0, sizeof(t_action));
+   t_action.sa_handler = v_stop; /* No SA_RESTART so accept() is interrupted */
+   sigaction(SIGINT, &t_action, NULL);
+   sigaction(SIGTERM, &t_action, NULL);
+   signal(SIGPIPE, SIG_IGN); /* Clients may go away while their files are being written */
+   while (!b_stop)
+   {
+      if (poll(a_polls, i_polls, -1) < 0)
+      {
+         if (errno != EINTR) v_error("Cannot wait for requests: %s\n", s_reason(errno));
+         continue;
+      }
+      for (i_count = i_polls - 1; i_count >= 2; i_count--) /* A connection with a request, or closed, goes to a thread */
+         if (a_polls[i_count].revents)
+         {
+            v_queue(a_polls[i_count].fd);
+            a_polls[i_count] = a_polls[--i_polls];
+         }
+      if (a_polls[1].revents && read(a_returned[0], &h_socket, sizeof(h_socket)) == sizeof(h_socket)) /* One at a time, any more are still there */
+         v_idle(&a_polls, &i_polls, &i_size, h_socket);
+      if (a_polls[0].revents)
+      {
+         if ((h_socket = accept(h_listen, NULL, NULL)) >= 0)
+            v_idle(&a_polls, &i_polls, &i_size, h_socket);
+         else if (errno != EINTR && errno != ECONNABORTED)
+            v_error("Cannot accept connection: %s\n", s_reason(errno));
+      }
+   }
+   free(a_polls);
+   close(h_listen);
+   unlink(s_path);
+   return true;
+}
+
+int i_send(int h_socket, char *s_request, int *a_files, int i_files) /* Send a request and the files that go with it, returns false if there was an error */
+{
+   union { struct cmsghdr t_header; char a_space[CMSG_SPACE(FILES_MAX * sizeof(int))]; } t_control;
+   struct msghdr t_message;
+   struct cmsghdr *p_header;
+   struct iovec t_part;
+
+   memset(&t_message, 0, sizeof(t_message));
+   memset(&t_control, 0, sizeof(t_control));
+   t_part.iov_base = s_request;
+   t_part.iov_len = strlen(s_request);
+   t_message.msg_iov = &t_part;
+   t_message.msg_iovlen = 1;
+   if (i_files)
+   {
+      t_message.msg_control = t_control.a_space;
+      t_message.msg_controllen = CMSG_SPACE(i_files * sizeof(int));
+      p_header = CMSG_FIRSTHDR(&t_message);
+      p_header->cmsg_level = SOL_SOCKET;
+      p_header->cmsg_type = SCM_RIGHTS;
+      p_header->cmsg_len = CMSG_LEN(i_files * sizeof(int));
+      memcpy(CMSG_DATA(p_header), a_files, i_files * sizeof(int));
+   }
+   return (sendmsg(h_socket, &t_message, MSG_NOSIGNAL) >= 0);
+}
+
+int i_answer(int h_socket, char *s_name) /* Print the reply to the oldest request, returns false if it failed */
+{
+   char s_reply[REQUEST_SIZE];
+   unsigned long ul_records, ul_errors;
+   ssize_t i_length;
+
+   while ((i_length = recv(h_socket, s_reply, sizeof(s_reply) - 1, 0)) < 0 && errno == EINTR);
+   if (i_length <= 0)
+   {
+      v_error("%s: No reply from server\n", s_name);
+      return false;
+   }
+   s_reply[i_length] = 0;
+   fprintf(stdout, "%s: %s", s_name, s_reply);
+   return (sscanf(s_reply, "ok %lu %lu", &ul_records, &ul_errors) == 2 && !ul_errors);
+}
+
+int i_client(char *s_path, char *s_file) /* Send each line of a file as a request, returns the number that failed */
+{
+   char s_line[REQUEST_SIZE], s_request[REQUEST_SIZE];
+   char a_names[WINDOW][REQUEST_SIZE]; /* Input files for the requests waiting for a reply */
+   char *a_args[ARGS_MAX + 1];
+   struct sockaddr_un t_address;
+   t_input t_input;
+   int a_files[FILES_MAX];
+   int h_socket, i_args, i_files, i_count, i_sent = 0, i_done = 0, i_failed = 0;
+
+   if (!i_open(&t_input, s_file, false))
+   {
+      v_error("Cannot open %s: %s\n", s_file, s_reason(errno));
+      exit(-1);
+   }
+   memset(&t_address, 0, sizeof(t_address));
+   t_address.sun_family = AF_UNIX;
+   strncpy(t_address.sun_path, s_path, sizeof(t_address.sun_path) - 1);
+   if ((h_socket = socket(AF_UNIX, SOCK_SEQPACKET, 0)) < 0 || connect(h_socket, (struct sockaddr *) &t_address, sizeof(t_address)))
+   {
+      v_error("Cannot connect to %s: %s\n", s_path, s_reason(errno));
+      exit(-1);
+   }
+   while (s_gets(s_line, sizeof(s_line), &t_input) != NULL)
+   {
+      strcpy(s_request, s_line);
+      for (i_args = 0, a_args[0] = strtok(s_line, " \t\r\n"); a_args[i_args] != NULL && i_args < ARGS_MAX; )
+         a_args[++i_args] = strtok(NULL, " \t\r\n");
+      if (!i_args || a_args[0][0] == '#') continue; /* Ignore blank lines and comments */
+      i_files = !strcmp(a_args[0], "verify") ? 1 : 2;
+      if (i_args <= i_files)
+      {
+         v_error("%s needs %d file name%s\n", a_args[0], i_files, i_files > 1 ? "s" : "");
+         i_failed++;
+         continue;
+      }
+      if ((a_files[0] = open(a_args[i_args - i_files], O_RDONLY)) < 0 ||
+         (i_files > 1 && (a_files[1] = open(a_args[i_args - 1], O_WRONLY | O_CREAT | O_TRUNC, 0666)) < 0))
+      {
+         v_error("Cannot open %s: %s\n", a_args[a_files[0] < 0 ? i_args - i_files : i_args - 1], s_reason(errno));
+         if (a_files[0] >= 0) close(a_files[0]);
+         i_failed++;
+         continue;
+      }
+      if (i_sent - i_done >= WINDOW) /* Wait for the oldest reply before sending any more */
+         if (!i_answer(h_socket, a_names[i_done++ % WINDOW])) i_failed++;
+      if (!i_send(h_socket, s_request, a_files, i_files))
+      {
+         v_error("Cannot send request: %s\n", s_reason(errno));
+         exit(-1);
+      }
+      strcpy(a_names[i_sent++ % WINDOW], a_args[i_args - i_files]);
+      for (i_count = 0; i_count < i_files; i_count++) close(a_files[i_count]); /* The server has its own copies */
+   }
+   while (i_done < i_sent)
+      if (!i_answer(h_socket, a_names[i_done++ % WINDOW])) i_failed++;
+   close(h_socket);
+   v_close(&t_input);
+   return i_failed;
+}
+#endif
+
+int main(int argc, char **argv)
+{
+#if defined(SERVER)
+   char *s_socket = NULL, *s_file = NULL;
+   char b_client = false;
+   long l_jobs = 4; /* Checked before it is narrowed */
+   int i_count, i_index;
+
+   for (i_count = 1; i_count < argc; i_count++)
+   {
+      if (argv[i_count][0] == '-' && argv[i_count][1] != 0)
+      {
+         i_index = strlen(argv[i_count]);
+         if (!strcmp(argv[i_count], "-c") || (i_index > 2 && !strncmp(argv[i_count], "--client", i_index)))
+            b_client = true;
+         else if (!strcmp(argv[i_count], "-j") || (i_index > 2 && !strncmp(argv[i_count], "--jobs", i_index)))
+         {
+            l_jobs = l_number(i_count + 1 < argc ? argv[i_count + 1] : NULL, argv[i_count]);
+            i_count++;
+         }
+         else if (i_index > 2 && !strncmp(argv[i_count], "--stats", i_index))
+            v_stats(false, "records");
+         else if (i_index > 2 && !strncmp(argv[i_count], "--stats-json", i_index))
+            v_stats(true, "records");
+         else if (!strcmp(argv[i_count], "-?") || (i_index > 2 && !strncmp(argv[i_count], "--help", i_index)))
+            v_about();
+         else if (i_index > 2 && !strncmp(argv[i_count], "--version", i_index))
+            v_version();
+         else
+         {
+            v_error("invalid option %s\nTry '%s --help' for more information.\n", argv[i_count], NAME);
+            exit(-1);
+         }
+      }
+      else if (s_socket == NULL)
+         s_socket = argv[i_count];
+      else if (b_client && s_file == NULL)
+         s_file = argv[i_count];
+      else
+      {
+         v_error("too many arguments\nTry '%s --help' for more information.\n", NAME);
+         exit(-1);
+      }
+   }
+   if (s_socket == NULL)
+   {
+      v_error("missing socket name\nTry '%s --help' for more information.\n", NAME);
+      exit(-1);
+   }
+   if (l_jobs < 1 || l_jobs > JOBS_MAX)
+   {
+      v_error("invalid number of jobs %ld, must be between 1 and %d\n", l_jobs, JOBS_MAX);
+      exit(-1);
+   }
+   if (b_client)
+   {
+      i_count = i_client(s_socket, s_file);
+      fflush(stdout);
+      exit(i_count ? 1 : 0);
+   }
+   exit(i_server(s_socket, l_jobs) ? 0 : -1);
+#else
+   v_error("Not supported on this system\n");
+   exit(-1);
+#endif
+}
@@ -0,0 +1,876 @@
+/*
+ * gcc-io.c
+ *
+ * Copyright(C) 2026   MT
+ *
+ * Input and output shared by all the programs.
+ *
+ * Files are read in large blocks, choosing how to read each file when  it
+ * is  opened.  Large regular files are mapped into memory, other  regular
+ * files  are read at a known offset so that any part of the file  can  be
+ * fetched  again, and pipes and devices are simply read in order.  Output
+ * is  collected in a buffer and written together with any text too  large
+ * to be worth copying using a single system call.
+ *
+ * A  list of files can be opened and read ahead together, which on  Linux
+ * uses  io_uring  to queue the opens, statx() calls and  first  reads  for
+ * many  files  at once, and anywhere else simply opens each file  when  it
+ * is needed.
+ *
+ * This  program is free software: you can redistribute it and/or modify it
+ * under  the terms of the GNU General Public License as published  by  the
+ * Free  Software Foundation, either version 3 of the License, or (at  your
+ * option) any later version.
+ *
+ * This  program  is distributed in the hope that it will  be  useful,  but
+ * WITHOUT   ANY   WARRANTY;   without even   the   implied   warranty   of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You  should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * 18 Oct 26         - Initial version - MT
+ *                   - Counts  the bytes read and written and  the  system
+ *                     calls  used,  and times each stage  of  the  work,
+ *                     printing them on exit when asked to - MT
+ *                   - Added  a batch reader that opens and reads a  list
+ *                     of files ahead using io_uring where available - MT
+ *                   - Moved the helpers that read option values here from
+ *                     each program - MT
+ *                   - Never takes a submission entry while the queue is
+ *                     full, and looks at each file with statx() on the
+ *                     descriptor once it is open instead of the name - MT
+ *
+ */
+
+#define  false       0
+#define  true        !false
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <time.h>
+
+#if defined(VMS)
+#include <stat.h>
+#include <unixio.h>
+#include <file.h>
+#else
+#include <sys/stat.h>
+#include <fcntl.h>
+#endif
+#if defined(MSDOS) || defined (WIN32)
+#include <io.h>
+#elif !defined(VMS)
+#define  IO_POSIX /* Memory mapping, pread() and writev() are available */
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#endif
+#if !defined(O_BINARY)
+#define  O_BINARY    0
+#endif
+#if defined(__linux__) && defined(__GNUC__)
+#include <linux/version.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5,6,0)
+#define  IO_URING /* Opening, statx() and reading can be queued together */
+#include <sys/syscall.h>
+#include <linux/stat.h>
+#include <linux/io_uring.h>
+#if !defined(AT_EMPTY_PATH) /* Only declared for _GNU_SOURCE */
+#define  AT_EMPTY_PATH 0x1000
+#endif
+#endif
+#endif
+
+#include "gcc-io.h"
+
+#if defined(__GNUC__)
+#define  LOCAL       __thread                 /* Each thread times its own stages */
+#else
+#define  LOCAL
+#endif
+
+char a_stdout[IO_OUTPUT];
+t_output t_stdout = {a_stdout, 0, IO_OUTPUT, 1, 0, 0}; /* Standard output */
+t_stats t_counters = {false, false, "records"}; /* Work done by the program */
+
+#if defined(STATS)
+LOCAL int i_current; /* Stage being timed by this thread */
+LOCAL int a_outer[STATS_STAGES], i_depth; /* Stages to go back to */
+LOCAL unsigned long long ull_since; /* When this thread started the current stage, or zero */
+#endif
+
+void v_error(const char *s_fmt, ...) /* Print formatted error message */
+{
+   va_list t_args;
+   va_start(t_args, s_fmt);
+   fprintf(stderr, "%s: ", s_program);
+   vfprintf(stderr, s_fmt, t_args);
+   va_end(t_args);
+}
+
+char *s_reason(int i_error) /* Describe an error number */
+{
+#if defined(VMS) /* Use VAX-C extension (avoids potential ACCVIO) */
+   return strerror(i_error, vaxc$errno);
+#else
+   return strerror(i_error);
+#endif
+}
+
+char *s_value(int *i_argc, char **argv, int i_count) /* Remove and return the argument following an option */
+{
+   char *s_arg;
+   int i_index;
+
+   if (i_count + 1 >= *i_argc) return NULL;
+   s_arg = argv[i_count + 1];
+   for (i_index = i_count + 1; i_index < *i_argc - 1; i_index++) argv[i_index] = argv[i_index + 1];
+   (*i_argc)--;
+   return s_arg;
+}
+
+long l_number(char *s_arg, char *s_option) /* Convert a decimal, octal or hexadecimal option value */
+{
+   char *s_end;
+   long l_value;
+
+   if (s_arg == NULL)
+   {
+      v_error("option requires an argument -- %s\n", s_option);
+      exit(-1);
+   }
+   errno = 0;
+   l_value = strtol(s_arg, &s_end, 0);
+   if (errno || s_end == s_arg || *s_end != 0)
+   {
+      v_error("invalid value '%s' for option %s\n", s_arg, s_option);
+      exit(-1);
+   }
+   return l_value;
+}
+
+int i_isfile(char *s_name) /* Return true if path is a file */
+{
+   struct stat t_file_d;
+   stats_count(ul_stat, 1);
+   if (stat(s_name, &t_file_d)) return false;
+#if defined(VMS)
+   return ((t_file_d.st_mode & S_IFMT) == S_IFREG);
+#else
+   return (S_ISREG(t_file_d.st_mode));
+#endif
+}
+
+int i_isdir(char *s_name) /* Return true if path is a directory */
+{
+   struct stat t_file_d;
+   stats_count(ul_stat, 1);
+   if (stat(s_name, &t_file_d)) return false;
+#if defined(VMS)
+   return ((t_file_d.st_mode & S_IFMT) == S_IFDIR);
+#else
+   return (S_ISDIR(t_file_d.st_mode));
+#endif
+}
+
+#if defined(STATS)
+unsigned long long ull_clock() /* Return a time in nanoseconds that never goes backwards */
+{
+#if defined(CLOCK_MONOTONIC)
+   struct timespec t_now;
+
+   clock_gettime(CLOCK_MONOTONIC, &t_now);
+   return (unsigned long long) t_now.tv_sec * 1000000000ULL + t_now.tv_nsec;
+#else
+   return (unsigned long long) clock() * (1000000000ULL / CLOCKS_PER_SEC);
+#endif
+}
+
+void v_stats_stage(int i_stage) /* Charge the time so far to the current stage and start timing another */
+{
+   unsigned long long ull_now = ull_clock();
+
+   if (ull_since) STATS_ADD(&t_counters.a_time[i_current], ull_now - ull_since); /* A new thread starts here */
+   ull_since = ull_now;
+   i_current = i_stage;
+}
+
+void v_stats_enter(int i_stage) /* Start timing a stage inside the current one */
+{
+   if (i_depth < STATS_STAGES) a_outer[i_depth] = i_current;
+   i_depth++;
+   v_stats_stage(i_stage);
+}
+
+void v_stats_leave() /* Go back to the stage that was being timed before */
+{
+   if (i_depth > 0 && --i_depth < STATS_STAGES) v_stats_stage(a_outer[i_depth]);
+}
+
+void v_stats_print() /* Print the counters and times, called on exit */
+{
+   const char *a_stages[STATS_STAGES] = {"other", "read", "parse", "format", "write"};
+   unsigned long long ull_elapsed;
+   int i_stage;
+
+   v_stats_stage(i_current); /* Finish timing this thread */
+   ull_elapsed = ull_clock() - t_counters.ull_start;
+   if (t_counters.b_json)
+   {
+      fprintf(stderr, "{\"program\": \"%s\", \"bytes_in\": %llu, \"bytes_out\": %llu, \"records\": %llu, \"records_are\": \"%s\", \"files\": %lu, ",
+         s_program, t_counters.ull_in, t_counters.ull_out, t_counters.ull_records, t_counters.s_records, t_counters.ul_files);
+      fprintf(stderr, "\"calls\": {\"open\": %lu, \"stat\": %lu, \"read\": %lu, \"mmap\": %lu, \"write\": %lu, \"close\": %lu}, \"seconds\": {",
+         t_counters.ul_open, t_counters.ul_stat, t_counters.ul_read, t_counters.ul_mmap, t_counters.ul_write, t_counters.ul_close);
+      for (i_stage = 0; i_stage < STATS_STAGES; i_stage++)
+         fprintf(stderr, "\"%s\": %.6f, ", a_stages[i_stage], t_counters.a_time[i_stage] / 1e9);
+      fprintf(stderr, "\"elapsed\": %.6f}}\n", ull_elapsed / 1e9);
+      return;
+   }
+   fprintf(stderr, "%s: %llu bytes read from %lu file%s, %llu bytes written, %llu %s\n", s_program, t_counters.ull_in,
+      t_counters.ul_files, t_counters.ul_files == 1 ? "" : "s", t_counters.ull_out, t_counters.ull_records, t_counters.s_records);
+   fprintf(stderr, "%s: calls: %lu open, %lu stat, %lu read, %lu mmap, %lu write, %lu close\n", s_program,
+      t_counters.ul_open, t_counters.ul_stat, t_counters.ul_read, t_counters.ul_mmap, t_counters.ul_write, t_counters.ul_close);
+   fprintf(stderr, "%s: seconds:", s_program);
+   for (i_stage = 0; i_stage < STATS_STAGES; i_stage++)
+      fprintf(stderr, " %.6f %s,", t_counters.a_time[i_stage] / 1e9, a_stages[i_stage]);
+   fprintf(stderr, " %.6f elapsed\n", ull_elapsed / 1e9);
+}
+#endif
+
+void v_stats(char b_json, const char *s_records) /* Start timing each stage and print the counters on exit */
+{
+#if defined(STATS)
+   if (!t_counters.b_enabled) /* Only count what is done from now on, a copy of another program may have been counting */
+   {
+      memset(&t_counters, 0, sizeof(t_counters));
+      t_counters.b_enabled = true;
+      t_counters.ull_start = ull_clock();
+      v_stats_stage(STATS_OTHER);
+      atexit(v_stats_print);
+   }
+   t_counters.b_json = b_json;
+   t_counters.s_records = s_records;
+#else
+   v_error("statistics were left out when this program was built\n");
+   exit(-1);
+#endif
+}
+
+void *p_allocate(void *p_memory, size_t i_size) /* Resize a buffer, there is nothing sensible to do if there isn't enough memory */
+{
+   if ((p_memory = realloc(p_memory, i_size)) == NULL)
+   {
+      v_error("Cannot allocate memory: %s\n", s_reason(errno));
+      exit(-1);
+   }
+   return p_memory;
+}
+
+void v_method(t_input *p_input, char b_regular, unsigned long ul_size);
+
+int i_open(t_input *p_input, char *s_name, char b_binary) /* Open a file and choose how to read it, returns false if there was an error */
+{
+   struct stat t_file_d;
+
+   memset(p_input, 0, sizeof(*p_input));
+   if (s_name == NULL)
+      p_input->h_file = 0; /* Standard input */
+   else
+   {
+      stats_count(ul_open, 1);
+      if ((p_input->h_file = open(s_name, O_RDONLY | (b_binary ? O_BINARY : 0))) < 0) return false;
+   }
+   stats_count(ul_files, 1);
+   stats_count(ul_stat, 1);
+   if (fstat(p_input->h_file, &t_file_d))
+   {
+      p_input->i_error = errno;
+      v_close(p_input);
+      errno = p_input->i_error;
+      return false;
+   }
+#if defined(VMS)
+   v_method(p_input, ((t_file_d.st_mode & S_IFMT) == S_IFREG) && s_name != NULL, t_file_d.st_size);
+#else
+   v_method(p_input, S_ISREG(t_file_d.st_mode) && s_name != NULL, t_file_d.st_size); /* Standard input may not start at the beginning */
+#endif
+   return true;
+}
+
+void v_method(t_input *p_input, char b_regular, unsigned long ul_size) /* Choose how to read a file that has been opened */
+{
+   if ((p_input->b_regular = b_regular))
+   {
+      p_input->ul_size = ul_size;
+#if defined(IO_POSIX)
+      p_input->i_method = IO_PREAD;
+      if (p_input->ul_size >= IO_MAP) stats_count(ul_mmap, 1);
+      if (p_input->ul_size >= IO_MAP && (p_input->s_image = mmap(NULL, p_input->ul_size, PROT_READ, MAP_PRIVATE, p_input->h_file, 0)) != MAP_FAILED)
+      {
+         madvise((void *) p_input->s_image, p_input->ul_size, MADV_SEQUENTIAL);
+         p_input->i_method = IO_MMAP;
+      }
+      else
+         p_input->s_image = NULL;
+#endif
+   }
+}
+
+size_t i_read(t_input *p_input, char *s_buffer, size_t i_length, unsigned long ul_offset) /* Read a block from a file, returns the number of characters read */
+{
+   ssize_t i_read;
+
+   stats_enter(STATS_READ);
+   do
+   {
+      stats_count(ul_read, 1);
+#if defined(IO_POSIX)
+      if (p_input->i_method == IO_PREAD)
+         i_read = pread(p_input->h_file, s_buffer, i_length, ul_offset);
+      else
+#endif
+         i_read = read(p_input->h_file, s_buffer, i_length);
+   } while (i_read < 0 && errno == EINTR);
+   stats_leave();
+   if (i_read < 0)
+   {
+      p_input->i_error = errno;
+      return 0;
+   }
+   stats_count(ull_in, i_read);
+   return i_read;
+}
+
+size_t i_fill(t_input *p_input, size_t i_keep) /* Read the next block keeping the last characters of the current one in front of it, returns the number of characters read */
+{
+   size_t i_length;
+
+   if (i_keep > p_input->i_length) i_keep = p_input->i_length;
+   p_input->i_next = 0;
+   if (p_input->i_ahead) /* The first block was read with the file */
+   {
+      p_input->s_data = p_input->s_buffer;
+      p_input->i_length = i_length = p_input->i_ahead;
+      p_input->i_ahead = 0;
+      return i_length;
+   }
+   if (p_input->i_method == IO_MMAP) /* The rest of the file is already in memory */
+   {
+      i_length = p_input->ul_size - p_input->ul_offset;
+      p_input->s_data = p_input->s_image + p_input->ul_offset - i_keep;
+      p_input->i_length = i_keep + i_length;
+      p_input->ul_offset = p_input->ul_size;
+      stats_count(ull_in, i_length);
+      return i_length;
+   }
+   if (i_keep >= p_input->i_buffer || p_input->s_buffer == NULL)
+   {
+      p_input->i_buffer = i_keep + IO_BLOCK;
+      p_input->s_buffer = p_allocate(p_input->s_buffer, p_input->i_buffer);
+   }
+   if (i_keep) memmove(p_input->s_buffer, p_input->s_data + p_input->i_length - i_keep, i_keep);
+   if (p_input->i_method == IO_PREAD && p_input->ul_offset >= p_input->ul_size)
+      i_length = 0; /* Don't read again just to find the end of a small file */
+   else
+      i_length = i_read(p_input, p_input->s_buffer + i_keep, p_input->i_buffer - i_keep, p_input->ul_offset);
+   p_input->ul_offset += i_length;
+   p_input->s_data = p_input->s_buffer;
+   p_input->i_length = i_keep + i_length;
+   return i_length;
+}
+
+size_t i_fetch(t_input *p_input, unsigned long ul_offset, size_t i_length, const char **p_data) /* Return part of a file without copying it if possible, returns the number of characters found */
+{
+   size_t i_count, i_total = 0;
+
+   if (p_input->b_regular)
+   {
+      if (ul_offset >= p_input->ul_size) return 0;
+      if (i_length > p_input->ul_size - ul_offset) i_length = p_input->ul_size - ul_offset;
+   }
+   if (p_input->i_method == IO_MMAP)
+   {
+      *p_data = p_input->s_image + ul_offset;
+      stats_count(ull_in, i_length);
+      return i_length;
+   }
+   if (p_input->i_ahead && ul_offset + i_length <= p_input->i_ahead) /* Already read with the file */
+   {
+      *p_data = p_input->s_buffer + ul_offset;
+      return i_length;
+   }
+   if (p_input->i_method == IO_READ && ul_offset != p_input->ul_offset) /* A pipe can only be read in order */
+   {
+      p_input->i_error = ESPIPE;
+      return 0;
+   }
+   if (i_length > p_input->i_buffer)
+   {
+      p_input->i_buffer = i_length;
+      p_input->s_buffer = p_allocate(p_input->s_buffer, p_input->i_buffer);
+   }
+   p_input->i_ahead = 0; /* Overwritten */
+   while (i_total < i_length && (i_count = i_read(p_input, p_input->s_buffer + i_total, i_length - i_total, ul_offset + i_total)) > 0)
+      i_total += i_count;
+   if (p_input->i_method == IO_READ) p_input->ul_offset += i_total;
+   p_input->s_data = NULL; /* The buffer no longer holds the current block */
+   p_input->i_length = p_input->i_next = 0;
+   *p_data = p_input->s_buffer;
+   return i_total;
+}
+
+char *s_gets(char *s_line, int i_size, t_input *p_input) /* Read a line like fgets() */
+{
+   const char *p_break = NULL;
+   size_t i_count = 0, i_length;
+
+   while (p_break == NULL && i_count + 1 < i_size)
+   {
+      if (p_input->i_next >= p_input->i_length && !i_fill(p_input, 0)) break;
+      i_length = p_input->i_length - p_input->i_next;
+      if (i_length > i_size - 1 - i_count) i_length = i_size - 1 - i_count;
+      if ((p_break = memchr(p_input->s_data + p_input->i_next, '\n', i_length)) != NULL)
+         i_length = p_break - (p_input->s_data + p_input->i_next) + 1;
+      memcpy(s_line + i_count, p_input->s_data + p_input->i_next, i_length);
+      p_input->i_next += i_length;
+      i_count += i_length;
+   }
+   if (!i_count) return NULL;
+   s_line[i_count] = 0;
+   return s_line;
+}
+
+int i_eof(t_input *p_input) /* Return true if there is nothing left to read */
+{
+   return (p_input->i_next >= p_input->i_length && !i_fill(p_input, 0));
+}
+
+void v_close(t_input *p_input) /* Close a file and free the buffer */
+{
+#if defined(IO_POSIX)
+   if (p_input->s_image != NULL) munmap((void *) p_input->s_image, p_input->ul_size);
+#endif
+   if (p_input->h_file > 0)
+   {
+      stats_count(ul_close, 1);
+      close(p_input->h_file);
+   }
+   free(p_input->s_buffer);
+   memset(p_input, 0, sizeof(*p_input));
+   p_input->h_file = -1;
+}
+
+#if defined(IO_URING)
+#define  URING_OPEN  0                        /* Requests for each file, kept in the low bits of the user data */
+#define  URING_STAT  1
+#define  URING_READ  2
+
+typedef struct
+{
+   int h_file; /* Descriptor, or minus the error when the file couldn't be opened */
+   int i_stat; /* Zero, or minus the error when statx() failed */
+   int i_read; /* Number of characters read, or minus the error */
+   int i_waiting; /* Number of requests not complete */
+   char b_read; /* The first block has been requested */
+   char *s_buffer; /* First block of a small regular file */
+   struct statx t_statx;
+} t_ahead;
+
+typedef struct
+{
+   int h_ring; /* File descriptor of the ring */
+   void *p_rings; /* Submission and completion queues shared with the kernel */
+   size_t i_rings;
+   struct io_uring_sqe *a_sqes; /* Requests */
+   size_t i_sqes;
+   unsigned *p_sq_head, *p_sq_tail, *p_sq_array, u_sq_mask, u_sq_entries;
+   unsigned *p_cq_head, *p_cq_tail, u_cq_mask;
+   struct io_uring_cqe *a_cqes; /* Results */
+   unsigned u_queued; /* Requests added since the queue was last submitted */
+   int i_pending; /* Requests not complete */
+   int i_started; /* Files up to this one have been requested */
+   t_ahead a_ahead[IO_AHEAD]; /* Files being opened or read, by position in the list */
+} t_ring;
+
+t_ring *p_ring_setup() /* Set up a ring that can open, statx() and read files, returns NULL if the system doesn't have one */
+{
+   static const int a_needed[] = {IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ};
+   struct io_uring_params t_params;
+   struct io_uring_probe *p_probe;
+   t_ring *p_ring;
+   int h_ring, i_count;
+
+   memset(&t_params, 0, sizeof(t_params));
+   if ((h_ring = syscall(__NR_io_uring_setup, 2 * IO_AHEAD, &t_params)) < 0) return NULL; /* Not available or not allowed */
+   p_probe = p_allocate(NULL, sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op));
+   memset(p_probe, 0, sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op));
+   i_count = (syscall(__NR_io_uring_register, h_ring, IORING_REGISTER_PROBE, p_probe, 256) < 0) ? 0 : sizeof(a_needed) / sizeof(a_needed[0]);
+   while (i_count > 0 && a_needed[i_count - 1] < p_probe->ops_len && (p_probe->ops[a_needed[i_count - 1]].flags & IO_URING_OP_SUPPORTED)) i_count--;
+   free(p_probe);
+   if (i_count > 0 || !(t_params.features & IORING_FEAT_SINGLE_MMAP)) /* Too old to be worth using */
+   {
+      close(h_ring);
+      return NULL;
+   }
+   p_ring = p_allocate(NULL, sizeof(t_ring));
+   memset(p_ring, 0, sizeof(t_ring));
+   p_ring->h_ring = h_ring;
+   p_ring->i_rings = t_params.sq_off.array + t_params.sq_entries * sizeof(unsigned);
+   if (p_ring->i_rings < t_params.cq_off.cqes + t_params.cq_entries * sizeof(struct io_uring_cqe))
+      p_ring->i_rings = t_params.cq_off.cqes + t_params.cq_entries * sizeof(struct io_uring_cqe);
+   p_ring->i_sqes = t_params.sq_entries * sizeof(struct io_uring_sqe);
+   p_ring->p_rings = mmap(NULL, p_ring->i_rings, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, h_ring, IORING_OFF_SQ_RING);
+   p_ring->a_sqes = mmap(NULL, p_ring->i_sqes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, h_ring, IORING_OFF_SQES);
+   if (p_ring->p_rings == MAP_FAILED || p_ring->a_sqes == MAP_FAILED)
+   {
+      if (p_ring->p_rings != MAP_FAILED) munmap(p_ring->p_rings, p_ring->i_rings);
+      if (p_ring->a_sqes != MAP_FAILED) munmap(p_ring->a_sqes, p_ring->i_sqes);
+      close(h_ring);
+      free(p_ring);
+      return NULL;
+   }
+   p_ring->p_sq_head = (unsigned *) ((char *) p_ring->p_rings + t_params.sq_off.head);
+   p_ring->p_sq_tail = (unsigned *) ((char *) p_ring->p_rings + t_params.sq_off.tail);
+   p_ring->p_sq_array = (unsigned *) ((char *) p_ring->p_rings + t_params.sq_off.array);
+   p_ring->u_sq_mask = *(unsigned *) ((char *) p_ring->p_rings + t_params.sq_off.ring_mask);
+   p_ring->u_sq_entries = t_params.sq_entries;
+   p_ring->p_cq_head = (unsigned *) ((char *) p_ring->p_rings + t_params.cq_off.head);
+   p_ring->p_cq_tail = (unsigned *) ((char *) p_ring->p_rings + t_params.cq_off.tail);
+   p_ring->u_cq_mask = *(unsigned *) ((char *) p_ring->p_rings + t_params.cq_off.ring_mask);
+   p_ring->a_cqes = (struct io_uring_cqe *) ((char *) p_ring->p_rings + t_params.cq_off.cqes);
+   return p_ring;
+}
+
+void v_enter(t_ring *p_ring, unsigned u_wait) /* Submit the requests queued so far, waiting for a number of results */
+{
+   long l_result;
+
+   while ((l_result = syscall(__NR_io_uring_enter, p_ring->h_ring, p_ring->u_queued, u_wait, u_wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0)) < 0)
+   {
+      if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+      {
+         v_error("Cannot read files: %s\n", s_reason(errno));
+         exit(-1);
+      }
+   }
+   p_ring->u_queued -= l_result;
+}
+
+struct io_uring_sqe *p_request(t_ring *p_ring, int i_opcode, int h_file, int i_file, int i_request) /* Add a request to the submission queue */
+{
+   unsigned u_tail = *p_ring->p_sq_tail;
+   struct io_uring_sqe *p_sqe;
+
+   while (u_tail - __atomic_load_n(p_ring->p_sq_head, __ATOMIC_ACQUIRE) >= p_ring->u_sq_entries) /* Full, so hand what is there to the kernel first */
+      v_enter(p_ring, 0);
+   p_sqe = &p_ring->a_sqes[u_tail & p_ring->u_sq_mask];
+   memset(p_sqe, 0, sizeof(*p_sqe));
+   p_sqe->opcode = i_opcode;
+   p_sqe->fd = h_file;
+   p_sqe->user_data = ((unsigned long long) i_file << 2) | i_request;
+   p_ring->p_sq_array[u_tail & p_ring->u_sq_mask] = u_tail & p_ring->u_sq_mask;
+   __atomic_store_n(p_ring->p_sq_tail, u_tail + 1, __ATOMIC_RELEASE); /* The kernel must see the request before the new tail */
+   p_ring->u_queued++;
+   p_ring->i_pending++;
+   return p_sqe;
+}
+
+void v_complete(t_batch *p_batch, t_ring *p_ring, int i_file, int i_request, int i_result) /* Record the result of a request, then statx() a file once it is open and read it if it is small */
+{
+   t_ahead *p_ahead = &p_ring->a_ahead[i_file % IO_AHEAD];
+   struct io_uring_sqe *p_sqe;
+
+   if (i_request == URING_OPEN) p_ahead->h_file = i_result;
+   else if (i_request == URING_STAT) p_ahead->i_stat = i_result;
+   else p_ahead->i_read = i_result;
+   p_ahead->i_waiting--;
+   if (i_request == URING_OPEN && i_result >= 0) /* Look at the file that was opened rather than the name, which may have changed */
+   {
+      p_sqe = p_request(p_ring, IORING_OP_STATX, i_result, i_file, URING_STAT);
+      p_sqe->addr = (unsigned long) "";
+      p_sqe->statx_flags = AT_EMPTY_PATH;
+      p_sqe->len = STATX_TYPE | STATX_SIZE;
+      p_sqe->off = (unsigned long) &p_ahead->t_statx;
+      p_ahead->i_waiting = 1;
+   }
+   else if (i_request == URING_STAT && !i_result && S_ISREG(p_ahead->t_statx.stx_mode) &&
+      p_ahead->t_statx.stx_size > 0 && p_ahead->t_statx.stx_size < IO_MAP && p_ahead->t_statx.stx_size <= IO_BLOCK) /* Larger files are mapped */
+   {
+      p_ahead->s_buffer = p_allocate(NULL, IO_BLOCK);
+      p_sqe = p_request(p_ring, IORING_OP_READ, p_ahead->h_file, i_file, URING_READ);
+      p_sqe->addr = (unsigned long) p_ahead->s_buffer;
+      p_sqe->len = p_ahead->t_statx.stx_size;
+      p_ahead->b_read = true;
+      p_ahead->i_waiting = 1;
+   }
+}
+
+void v_collect(t_batch *p_batch, t_ring *p_ring, char b_wait) /* Submit any new requests and collect the results, waiting for at least one if asked */
+{
+   unsigned u_head, u_tail;
+
+   if (p_ring->u_queued || b_wait) v_enter(p_ring, b_wait ? 1 : 0); /* Results that are already there can be collected without a system call */
+   u_head = *p_ring->p_cq_head;
+   u_tail = __atomic_load_n(p_ring->p_cq_tail, __ATOMIC_ACQUIRE); /* Results written before the tail are complete */
+   for (; u_head != u_tail; u_head++)
+   {
+      p_ring->i_pending--;
+      v_complete(p_batch, p_ring, p_ring->a_cqes[u_head & p_ring->u_cq_mask].user_data >> 2,
+         p_ring->a_cqes[u_head & p_ring->u_cq_mask].user_data & 3, p_ring->a_cqes[u_head & p_ring->u_cq_mask].res);
+   }
+   __atomic_store_n(p_ring->p_cq_head, u_head, __ATOMIC_RELEASE);
+}
+
+void v_start(t_batch *p_batch, t_ring *p_ring) /* Open the files that fit in the window after the next one, once half of it is free */
+{
+   struct io_uring_sqe *p_sqe;
+   t_ahead *p_ahead;
+
+   if (p_ring->i_started - p_batch->i_next > IO_AHEAD / 2) return;
+   for (; p_ring->i_started < p_batch->i_names && p_ring->i_started < p_batch->i_next + IO_AHEAD; p_ring->i_started++)
+   {
+      p_ahead = &p_ring->a_ahead[p_ring->i_started % IO_AHEAD];
+      memset(p_ahead, 0, sizeof(*p_ahead));
+      p_ahead->i_waiting = 1; /* Each file only has one request at a time, so no more than IO_AHEAD are ever waiting */
+      p_sqe = p_request(p_ring, IORING_OP_OPENAT, AT_FDCWD, p_ring->i_started, URING_OPEN);
+      p_sqe->addr = (unsigned long) p_batch->a_names[p_ring->i_started];
+      p_sqe->open_flags = O_RDONLY | (p_batch->b_binary ? O_BINARY : 0);
+   }
+}
+#endif
+
+void v_batch(t_batch *p_batch, char **a_names, int i_names, char b_binary) /* Start opening and reading a list of files, the files are returned in order by i_batch_open() */
+{
+   memset(p_batch, 0, sizeof(*p_batch));
+   p_batch->a_names = a_names;
+   p_batch->i_names = i_names;
+   p_batch->b_binary = b_binary;
+#if defined(IO_URING)
+   if (i_names > 1) p_batch->p_ring = p_ring_setup(); /* Not worth it for a single file */
+#endif
+}
+
+int i_batch_open(t_batch *p_batch, t_input *p_input) /* Open the next file in the list and choose how to read it, returns false with errno set to EISDIR for a directory or the reason it couldn't be opened */
+{
+#if defined(IO_URING)
+   t_ring *p_ring = p_batch->p_ring;
+   t_ahead *p_ahead;
+
+   if (p_ring != NULL && p_batch->i_next < p_batch->i_names)
+   {
+      v_start(p_batch, p_ring);
+      p_ahead = &p_ring->a_ahead[p_batch->i_next % IO_AHEAD];
+      stats_enter(STATS_READ);
+      do
+         v_collect(p_batch, p_ring, (p_ahead->i_waiting > 0));
+      while (p_ahead->i_waiting > 0);
+      stats_leave();
+      p_batch->i_next++;
+      memset(p_input, 0, sizeof(*p_input));
+      p_input->h_file = -1;
+      stats_count(ul_open, 1);
+      stats_count(ul_stat, 1);
+      if (!p_ahead->i_stat && S_ISDIR(p_ahead->t_statx.stx_mode)) /* Reading a directory makes no sense */
+      {
+         if (p_ahead->h_file >= 0) close(p_ahead->h_file);
+         errno = EISDIR;
+         return false;
+      }
+      if (p_ahead->h_file < 0)
+      {
+         errno = -p_ahead->h_file;
+         return false;
+      }
+      if (p_ahead->i_stat) /* Look at the file again the usual way */
+      {
+         close(p_ahead->h_file);
+         return i_open(p_input, p_batch->a_names[p_batch->i_next - 1], p_batch->b_binary);
+      }
+      p_input->h_file = p_ahead->h_file;
+      stats_count(ul_files, 1);
+      v_method(p_input, S_ISREG(p_ahead->t_statx.stx_mode), p_ahead->t_statx.stx_size);
+      if (p_ahead->b_read)
+      {
+         stats_count(ul_read, 1);
+         p_input->s_buffer = p_ahead->s_buffer; /* The first block becomes the buffer */
+         p_input->i_buffer = IO_BLOCK;
+         if (p_ahead->i_read < 0)
+            p_input->i_error = -p_ahead->i_read;
+         else
+         {
+            p_input->i_ahead = p_input->ul_offset = p_ahead->i_read;
+            stats_count(ull_in, p_ahead->i_read);
+         }
+      }
+      return true;
+   }
+#endif
+   if (p_batch->i_next >= p_batch->i_names)
+   {
+      errno = ENOENT;
+      return false;
+   }
+   if (i_isdir(p_batch->a_names[p_batch->i_next++]))
+   {
+      errno = EISDIR;
+      return false;
+   }
+   return i_open(p_input, p_batch->a_names[p_batch->i_next - 1], p_batch->b_binary);
+}
+
+void v_batch_close(t_batch *p_batch) /* Close any files that were opened ahead but not used and free everything */
+{
+#if defined(IO_URING)
+   t_ring *p_ring = p_batch->p_ring;
+   t_ahead *p_ahead;
+
+   if (p_ring != NULL)
+   {
+      while (p_ring->i_pending > 0) v_collect(p_batch, p_ring, true); /* The kernel may still write to the buffers */
+      for (; p_batch->i_next < p_ring->i_started; p_batch->i_next++)
+      {
+         p_ahead = &p_ring->a_ahead[p_batch->i_next % IO_AHEAD];
+         if (p_ahead->h_file >= 0) close(p_ahead->h_file);
+         free(p_ahead->s_buffer);
+      }
+      munmap(p_ring->a_sqes, p_ring->i_sqes);
+      munmap(p_ring->p_rings, p_ring->i_rings);
+      close(p_ring->h_ring);
+      free(p_ring);
+   }
+#endif
+   memset(p_batch, 0, sizeof(*p_batch));
+}
+
+int i_create(t_output *p_output, char *s_name, char b_binary) /* Create a file to write, returns false if there was an error */
+{
+   memset(p_output, 0, sizeof(*p_output));
+   stats_count(ul_open, 1);
+   if ((p_output->h_file = open(s_name, O_WRONLY | O_CREAT | O_TRUNC | (b_binary ? O_BINARY : 0), 0666)) < 0) return false;
+   p_output->i_size = IO_OUTPUT;
+   p_output->s_buffer = p_allocate(NULL, p_output->i_size);
+   return true;
+}
+
+void v_send(t_output *p_output, const char *p_data, size_t i_length) /* Write the buffer followed by some more text using as few system calls as possible */
+{
+#if defined(IO_POSIX)
+   struct iovec a_parts[2];
+   int i_count;
+#endif
+   const char *a_base[2];
+   size_t a_length[2];
+   ssize_t i_done;
+   int i_parts = 0, i_part = 0;
+
+   if (p_output->h_file < 0) /* Keep everything in memory */
+   {
+      i_room(p_output, i_length);
+      memcpy(p_output->s_buffer + p_output->i_length, p_data, i_length);
+      p_output->i_length += i_length;
+      return;
+   }
+   if (p_output->i_length)
+   {
+      a_base[i_parts] = p_output->s_buffer;
+      a_length[i_parts++] = p_output->i_length;
+   }
+   if (i_length)
+   {
+      a_base[i_parts] = p_data;
+      a_length[i_parts++] = i_length;
+   }
+   stats_enter(STATS_WRITE);
+   while (i_part < i_parts && !p_output->i_error) /* Carry on after a partial write */
+   {
+      stats_count(ul_write, 1);
+#if defined(IO_POSIX)
+      for (i_count = i_part; i_count < i_parts; i_count++)
+      {
+         a_parts[i_count].iov_base = (void *) a_base[i_count];
+         a_parts[i_count].iov_len = a_length[i_count];
+      }
+      i_done = writev(p_output->h_file, a_parts + i_part, i_parts - i_part);
+#else
+      i_done = write(p_output->h_file, a_base[i_part], a_length[i_part]);
+#endif
+      if (i_done < 0)
+      {
+         if (errno != EINTR) p_output->i_error = errno;
+         continue;
+      }
+      stats_count(ull_out, i_done);
+      for (; i_part < i_parts && (size_t) i_done >= a_length[i_part]; i_part++) i_done -= a_length[i_part];
+      if (i_part < i_parts)
+      {
+         a_base[i_part] += i_done;
+         a_length[i_part] -= i_done;
+      }
+   }
+   stats_leave();
+   p_output->i_length = 0; /* After an error the rest of the output is thrown away */
+}
+
+int i_room(t_output *p_output, size_t i_length) /* Make room in an output buffer, returns false if the text should be written directly */
+{
+   if (p_output->h_file >= 0)
+   {
+      v_send(p_output, NULL, 0);
+      return (i_length <= p_output->i_size); /* Too big to be worth buffering */
+   }
+   if (p_output->i_length + i_length <= p_output->i_size) return true;
+   p_output->i_size = (2 * p_output->i_size > p_output->i_length + i_length) ? 2 * p_output->i_size : p_output->i_length + i_length + IO_OUTPUT;
+   p_output->s_buffer = p_allocate(p_output->s_buffer, p_output->i_size);
+   return true;
+}
+
+int i_flush(t_output *p_output) /* Write the contents of an output buffer, returns false if there was an error */
+{
+   if (p_output->h_file >= 0) v_send(p_output, NULL, 0);
+   errno = p_output->i_error;
+   return (!p_output->i_error);
+}
+
+int i_finish(t_output *p_output) /* Write any remaining text, close the file and free the buffer, returns false if there was an error */
+{
+   i_flush(p_output);
+   stats_count(ul_close, 1);
+   if (close(p_output->h_file) && !p_output->i_error) p_output->i_error = errno;
+   free(p_output->s_buffer);
+   p_output->s_buffer = NULL;
+   p_output->h_file = -1;
+   errno = p_output->i_error;
+   return (!p_output->i_error);
+}
+
+int i_printf(t_output *p_output, const char *s_fmt, ...) /* Append formatted text to an output buffer, returns the number of characters */
+{
+   va_list t_args;
+   char *s_text;
+   int i_length;
+
+   va_start(t_args, s_fmt);
+   i_length = vsnprintf(p_output->s_buffer + p_output->i_length, p_output->i_size - p_output->i_length, s_fmt, t_args);
+   va_end(t_args);
+   if (i_length < 0) return 0;
+   if (i_length >= p_output->i_size - p_output->i_length) /* Didn't fit so try again */
+   {
+      s_text = i_room(p_output, i_length + 1) ? p_output->s_buffer + p_output->i_length : p_allocate(NULL, i_length + 1);
+      va_start(t_args, s_fmt);
+      vsnprintf(s_text, i_length + 1, s_fmt, t_args);
+      va_end(t_args);
+      if (s_text != p_output->s_buffer + p_output->i_length)
+      {
+         v_send(p_output, s_text, i_length);
+         free(s_text);
+         return i_length;
+      }
+   }
+   p_output->i_length += i_length;
+   return i_length;
+}
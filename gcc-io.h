@@ -0,0 +1,178 @@
+/*
+ * gcc-io.h
+ *
+ * Copyright(C) 2026   MT
+ *
+ * Input and output shared by all the programs.
+ *
+ * This  program is free software: you can redistribute it and/or modify it
+ * under  the terms of the GNU General Public License as published  by  the
+ * Free  Software Foundation, either version 3 of the License, or (at  your
+ * option) any later version.
+ *
+ * This  program  is distributed in the hope that it will  be  useful,  but
+ * WITHOUT   ANY   WARRANTY;   without even   the   implied   warranty   of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You  should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * 18 Oct 26         - Initial version - MT
+ *                   - Added counters and timers for '--stats' - MT
+ *                   - Don't copy from a null pointer when writing nothing - MT
+ *                   - Added a batch reader to open and read a list of files
+ *                     ahead - MT
+ *                   - Added the helpers that read option values - MT
+ *
+ */
+
+#if !defined(GCC_IO_H) /* Only include once */
+#define GCC_IO_H
+
+#include <stdio.h>
+#include <string.h>
+#include "gcc-debug.h"
+
+#if defined(__GNUC__) /* Small functions called for every character or block must be inlined */
+#define  INLINE      static inline __attribute__((always_inline))
+#else
+#define  INLINE      static inline
+#endif
+
+#define  IO_BLOCK    65536                    /* Number of characters read from a file at once */
+#define  IO_MAP      65536                    /* Regular files at least this big are memory mapped */
+#define  IO_OUTPUT   131072                   /* Size of an output buffer */
+#define  IO_AHEAD    32                       /* Number of files in a list opened and read ahead */
+
+#define  IO_READ     0                        /* Read the file in order, for pipes and devices */
+#define  IO_PREAD    1                        /* Read blocks at a given offset, for regular files */
+#define  IO_MMAP     2                        /* The whole file is mapped into memory */
+
+#define  STATS_OTHER 0                        /* Anything else, such as starting up */
+#define  STATS_READ  1                        /* Reading files */
+#define  STATS_PARSE 2                        /* Decoding what was read */
+#define  STATS_FORMAT 3                       /* Converting to the output format */
+#define  STATS_WRITE 4                        /* Writing files */
+#define  STATS_STAGES 5
+
+typedef struct
+{
+   int h_file; /* File descriptor */
+   int i_method; /* How the file is read */
+   int i_error; /* First error when reading the file, or zero */
+   char b_regular; /* The size of the file is known */
+   unsigned long ul_size; /* Size of a regular file */
+   unsigned long ul_offset; /* Offset in the file of the end of the current block */
+   const char *s_image; /* Whole file when it is memory mapped */
+   char *s_buffer; /* Buffer used when the file is not mapped */
+   size_t i_buffer; /* Size of the buffer */
+   const char *s_data; /* Current block */
+   size_t i_length; /* Number of characters in the current block */
+   size_t i_next; /* Next character in the current block */
+   size_t i_ahead; /* Number of characters read with the file still to be returned as the first block */
+} t_input;
+
+typedef struct
+{
+   char **a_names; /* Files to read in order */
+   int i_names; /* Number of files */
+   int i_next; /* Next file to open */
+   char b_binary; /* Open the files in binary mode */
+   void *p_ring; /* Requests queued with the system, or NULL to open each file when it is needed */
+} t_batch;
+
+typedef struct
+{
+   char *s_buffer; /* Characters waiting to be written */
+   size_t i_length; /* Number of characters in the buffer */
+   size_t i_size; /* Size of the buffer */
+   int h_file; /* File descriptor written when the buffer is full, or -1 to keep everything in memory */
+   int i_error; /* First error when writing the file, or zero */
+   unsigned long ul_count; /* Kept by the program, for example the number of tabs written */
+} t_output;
+
+typedef struct
+{
+   char b_enabled; /* Time each stage and print everything on exit */
+   char b_json; /* Print everything as a JSON object */
+   const char *s_records; /* What the program counts as a record */
+   unsigned long long ull_in; /* Bytes read */
+   unsigned long long ull_out; /* Bytes written */
+   unsigned long long ull_records; /* Records, lines or characters processed */
+   unsigned long ul_files; /* Files read */
+   unsigned long ul_open, ul_stat, ul_read, ul_mmap, ul_write, ul_close; /* System calls */
+   unsigned long long ull_start; /* When the program started, in nanoseconds */
+   unsigned long long a_time[STATS_STAGES]; /* Nanoseconds spent in each stage by all the threads */
+} t_stats;
+
+extern char s_program[]; /* Name used in error messages, each program defines it */
+extern t_output t_stdout; /* Standard output */
+extern t_stats t_counters; /* Work done by the program */
+
+#if defined(__GNUC__) /* Counters may be updated by more than one thread */
+#define  STATS_ADD(p_total, ul_count) __sync_fetch_and_add(p_total, ul_count)
+#else
+#define  STATS_ADD(p_total, ul_count) (*(p_total) += (ul_count))
+#endif
+
+/* Counting and timing can be left out by building without STATS */
+#define  stats_count(field, ul_count) stats(STATS_ADD(&t_counters.field, (ul_count)))
+#define  stats_stage(i_stage) stats(if (t_counters.b_enabled) v_stats_stage(i_stage)) /* Start timing another stage */
+#define  stats_enter(i_stage) stats(if (t_counters.b_enabled) v_stats_enter(i_stage)) /* Time a stage inside another one */
+#define  stats_leave() stats(if (t_counters.b_enabled) v_stats_leave()) /* Go back to timing the outer stage */
+
+void v_error(const char *s_fmt, ...); /* Print formatted error message */
+char *s_reason(int i_error); /* Describe an error number */
+char *s_value(int *i_argc, char **argv, int i_count); /* Remove and return the argument following an option */
+long l_number(char *s_arg, char *s_option); /* Convert a decimal, octal or hexadecimal option value */
+int i_isfile(char *s_name); /* Return true if path is a file */
+int i_isdir(char *s_name); /* Return true if path is a directory */
+
+void v_stats(char b_json, const char *s_records); /* Start timing each stage and print the counters on exit */
+void v_stats_stage(int i_stage); /* Charge the time so far to the current stage and start timing another */
+void v_stats_enter(int i_stage); /* Start timing a stage inside the current one */
+void v_stats_leave(void); /* Go back to the stage that was being timed before */
+
+int i_open(t_input *p_input, char *s_name, char b_binary); /* Open a file, or standard input if the name is NULL */
+size_t i_fill(t_input *p_input, size_t i_keep); /* Read the next block */
+size_t i_fetch(t_input *p_input, unsigned long ul_offset, size_t i_length, const char **p_data); /* Return part of a file */
+char *s_gets(char *s_line, int i_size, t_input *p_input); /* Read a line */
+int i_eof(t_input *p_input); /* Return true at the end of the file */
+void v_close(t_input *p_input); /* Close a file */
+
+void v_batch(t_batch *p_batch, char **a_names, int i_names, char b_binary); /* Start opening and reading a list of files */
+int i_batch_open(t_batch *p_batch, t_input *p_input); /* Open the next file in the list */
+void v_batch_close(t_batch *p_batch); /* Finish with a list of files */
+
+int i_create(t_output *p_output, char *s_name, char b_binary); /* Create a file to write */
+int i_room(t_output *p_output, size_t i_length); /* Make room in an output buffer */
+void v_send(t_output *p_output, const char *p_data, size_t i_length); /* Write the buffer and some more text */
+int i_flush(t_output *p_output); /* Write the contents of an output buffer */
+int i_finish(t_output *p_output); /* Write any remaining text and close a file */
+int i_printf(t_output *p_output, const char *s_fmt, ...); /* Append formatted text */
+
+INLINE int i_getc(t_input *p_input) /* Return the next character like fgetc() */
+{
+   if (p_input->i_next >= p_input->i_length && !i_fill(p_input, 0)) return EOF;
+   return (unsigned char) p_input->s_data[p_input->i_next++];
+}
+
+INLINE void v_write(t_output *p_output, const char *p_data, size_t i_length) /* Append text to an output buffer */
+{
+   if (p_output->i_length + i_length > p_output->i_size && !i_room(p_output, i_length))
+      v_send(p_output, p_data, i_length); /* Too big to be worth copying */
+   else if (i_length > 0) /* An empty buffer may not have been allocated */
+   {
+      memcpy(p_output->s_buffer + p_output->i_length, p_data, i_length);
+      p_output->i_length += i_length;
+   }
+}
+
+INLINE void v_putc(t_output *p_output, int i_char) /* Append a character to an output buffer */
+{
+   if (p_output->i_length >= p_output->i_size) i_room(p_output, 1);
+   p_output->s_buffer[p_output->i_length++] = i_char;
+}
+
+#endif
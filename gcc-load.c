@@ -36,6 +36,12 @@
  * 08 Aug 23         - If  the address of the next record is  greater  than
  *                     the current offset then pad output with NOPs - MT
  * 10 Aug 23         - Fixed very silly error with true/false values! - MT
+ * 18 Oct 26         - Uses  the shared input and output module to  read
+ *                     the file in large blocks and buffer the output, and
+ *                     reports errors writing the binary file - MT
+ *                   - Moved the parser into a library that other programs
+ *                     can use without running this one - MT
+ *                   - Added '--stats' to print what was done - MT
  * 
  * ToDo:             - Check if the output file exists.
  *                   - Add support for Motorola 'S' format.
@@ -62,7 +68,7 @@
 
 #define  NAME        "gcc-load"
 #define  VERSION     "0.1"
-#define  BUILD       "0007"
+#define  BUILD       "0010"
 #define  AUTHOR      "MT"
 #define  COPYRIGHT   (__DATE__ + 7) /* Extract copyright year from date */
 
@@ -83,6 +89,10 @@
 #include <sys/stat.h>
 #endif
 #include "gcc-debug.h"
+#include "gcc-io.h"
+#include "gcc-hex.h"
+
+char s_program[] = NAME;
 
 void v_version() /* Display version information */
 {
@@ -99,6 +109,7 @@ void v_about() /* Display help text */
 {
    fprintf(stdout, "Usage: %s [OPTION]... [FILE]...\n", NAME);
    fprintf(stdout, "Loads intel hexadecimal FILE(s) to binary FILE(s).\n\n");
+   fprintf(stdout, "  /statistics              print what was done on exit\n");
    fprintf(stdout, "  /version                 output version information and exit\n");
    fprintf(stdout, "  /?, /help                display this help and exit\n");
    exit(0);
@@ -108,163 +119,47 @@ void v_about() /* Display help text */
 {
    fprintf(stdout, "Usage: %s [OPTION]... [FILE]...\n", NAME);
    fprintf(stdout, "Loads intel hexadecimal FILE(s) to binary FILE(s).\n\n");
+   fprintf(stdout, "      --stats              print what was done on exit\n");
+   fprintf(stdout, "      --stats-json         print what was done on exit in JSON\n");
    fprintf(stdout, "  -?, --help               display this help and exit\n");
    fprintf(stdout, "      --version            output version information and exit\n");
    exit(0);
 }
 #endif
  
-void v_error(const char *s_fmt, ...) /* Print formatted error message */
+void v_list(void *p_context, const char *s_text, size_t i_length) /* Print the listing of each record */
 {
-   va_list t_args;
-   va_start(t_args, s_fmt);
-   fprintf(stderr, "%s: ", NAME);
-   vfprintf(stderr, s_fmt, t_args);
-   va_end(t_args);
-}
-
-int i_isfile(char *s_name) /* Return true if path is a file */
-{
-   struct stat t_file_d;
-   stat(s_name, &t_file_d);
-#if defined(VMS)
-   return ((t_file_d.st_mode & S_IFMT) == S_IFREG);
-#else
-   return (S_ISREG(t_file_d.st_mode));
-#endif
+   v_write(&t_stdout, s_text, i_length);
 }
 
-int i_isdir(char *s_name) /* Return true if path is a directory */
+void v_load(void *p_context, const char *p_data, size_t i_length) /* Write the bytes loaded */
 {
-   struct stat t_file_d;
-   stat(s_name, &t_file_d);
-#if defined(VMS)
-   return ((t_file_d.st_mode & S_IFMT) == S_IFDIR);
-#else
-   return (S_ISDIR(t_file_d.st_mode));
-#endif
+   v_write((t_output *) p_context, p_data, i_length);
 }
 
-int i_read_hex(FILE *h_input, FILE *h_output,int i_offset) /* Read intel hexadecimal and print bytes */
+unsigned long ul_read_hex(t_input *p_input, t_output *p_output) /* Read intel hexadecimal and print bytes, returns the number of errors */
 {
-   int i_last = '\n';
-   int i_char;
-   int i_bytes;
-   int i_address;
-   int i_type;
-   int i_data;
-   int i_checksum;
-   int i_error = 0;
-   int i_count = 0;
+   char a_buffer[IO_BLOCK];
+   t_decoder t_decoder;
+   unsigned long ul_errors;
 
-   while ((i_char = fgetc(h_input)) != EOF)
+   stats_stage(STATS_PARSE);
+   v_hex_decoder(&t_decoder, a_buffer, sizeof(a_buffer), v_load, v_list, p_output);
+   while (p_input->i_next < p_input->i_length || i_fill(p_input, 0))
    {
-      switch (i_count)
-      {
-         case 0: /* Check for start of record */
-            if (((i_last == '\n') || (i_last == '\r')) && (i_char == ':')) /* Start of record */
-            {
-               fprintf (stdout, "%c", i_char);
-               i_bytes = 0; /* Reset values */
-               i_address = 0;
-               i_type = 0;
-               i_data = 0;
-               i_checksum = 0;
-               i_count++;
-            }
-            break;
-         case 1: /* Get number of bytes in record */
-         case 2:
-            i_bytes <<= 4;
-            if (i_char >= '0' && i_char <= '9') i_bytes |= ((i_char - '0') & 0x0F);
-            else if (i_char >= 'a' && i_char <= 'f') i_bytes |= ((i_char - 'a' + 10) & 0x0F);
-            else if (i_char >= 'A' && i_char <= 'F') i_bytes |= ((i_char - 'A' + 10) & 0x0F);
-            else i_error++;
-            if (i_count == 2) fprintf (stdout, "%02X", i_bytes);
-            i_count++;
-            break;
-         case 3: /* Get address of bytes in record */
-         case 4:
-         case 5:
-         case 6:
-            i_address <<= 4;
-            if (i_char >= '0' && i_char <= '9') i_address |= ((i_char - '0') & 0x0F);
-            else if (i_char >= 'a' && i_char <= 'f') i_address |= ((i_char - 'a' + 10) & 0x0F);
-            else if (i_char >= 'A' && i_char <= 'F') i_address |= ((i_char - 'A' + 10) & 0x0F);
-            else i_error++;
-            if (i_count == 6) fprintf (stdout, "%04X", i_address);
-            if (i_address < i_offset) i_error++; /* Can't go backwards! */
-            while (i_offset < i_address) /* If the address of the next record is greater than the current offset then pad output with NOPs */
-            {
-               i_offset++;
-               fputc(0x00, h_output);
-            }
-            i_count++;
-            break;
-         case 7: /* Get record type */
-         case 8:
-            i_type <<= 4;
-            if (i_char >= '0' && i_char <= '9') i_type |= ((i_char - '0') & 0x0F);
-            else if (i_char >= 'a' && i_char <= 'f') i_type |= ((i_char - 'a' + 10) & 0x0F);
-            else if (i_char >= 'A' && i_char <= 'F') i_type |= ((i_char - 'A' + 10) & 0x0F);
-            else i_error++;
-            if (i_count == 8) fprintf (stdout, "%02X", i_type);
-            i_checksum = i_bytes + i_type + (i_address / 256) + (i_address % 256);
-            i_count++;
-            break;
-         default:
-            if (i_char == '\r' || i_char == '\n')
-            {
-               i_count = 0; /* Read next record */
-               if (i_bytes >= 0)
-               {
-                  i_error++;
-                  fprintf (stdout, " - Error");
-               }
-               fprintf (stdout, "\n");
-            }
-            else
-            {
-               i_data <<= 4;
-               if (i_char >= '0' && i_char <= '9') i_data |= ((i_char - '0') & 0x0F);
-               else if (i_char >= 'a' && i_char <= 'f') i_data |= ((i_char - 'a' + 10) & 0x0F);
-               else if (i_char >= 'A' && i_char <= 'F') i_data |= ((i_char - 'A' + 10) & 0x0F);
-               else i_error++;
-               i_count++;
-               if (i_count % 2) 
-               {
-                  fprintf (stdout, "%02X", i_data);
-                  if (i_bytes) 
-                  {
-                     fputc(i_data, h_output);
-                     i_offset++;
-                     i_checksum += i_data;
-                  }
-                  else 
-                  {
-                     i_checksum = (~(i_checksum & 0xFF) + 1) & 0xFF;
-                     if (i_checksum != i_data) 
-                     {
-                        i_error++;
-                        fprintf (stdout, " - Error");
-                     }
-                     else
-                        fprintf (stdout, " - Ok");
-                  }
-                  i_bytes--;
-                  i_data = 0; /* Reset value before reading next byte */
-               }
-            }
-
-      }
-      if (i_last != '\n' || i_char != '\0') i_last= i_char; /* Ignore any leading NULL chracters at the start of each record */
+      v_hex_decode(&t_decoder, p_input->s_data + p_input->i_next, p_input->i_length - p_input->i_next);
+      p_input->i_next = p_input->i_length;
    }
-   return (i_char);
+   ul_errors = ul_hex_flush(&t_decoder);
+   stats_stage(STATS_OTHER);
+   stats_count(ull_records, t_decoder.ul_records);
+   return ul_errors;
 }
 
 int main(int argc, char **argv)
 {
-   FILE *h_input, *h_output;
+   t_input t_input;
+   t_output t_output;
    int i_count, i_index;
 
 #if defined(VMS) || defined(MSDOS) || defined (WIN32) /* Parse DEC/Microsoft style command line options */
@@ -277,6 +172,8 @@ int main(int argc, char **argv)
                argv[i_count][i_index] = argv[i_count][i_index] - 32;
          if (!strncmp(argv[i_count], "/VERSION", i_index))
             v_version(); /* Display version information */
+         else if (!strncmp(argv[i_count], "/STATISTICS", i_index))
+            v_stats(false, "records");
          else if (!strncmp(argv[i_count], "/HELP", i_index))
             v_about();
          else if (!strncmp(argv[i_count], "/?", i_index))
@@ -312,6 +209,10 @@ int main(int argc, char **argv)
                else
                   if (!strncmp(argv[i_count], "--version", i_index))
                      v_version(); /* Display version information */
+                  else if (!strncmp(argv[i_count], "--stats", i_index))
+                     v_stats(false, "records");
+                  else if (!strncmp(argv[i_count], "--stats-json", i_index))
+                     v_stats(true, "records");
                   else if (!strncmp(argv[i_count], "--help", i_index))
                      v_about();
                   else
@@ -341,33 +242,22 @@ int main(int argc, char **argv)
       {
          if ((strlen(argv[i_count]) > 4)  && (!strcmp(argv[i_count] + strlen(argv[i_count]) - 4, ".hex"))) /* Check the filename ends in '.hex' */
          {
-            if ((h_input = fopen(argv[i_count], "r")) != NULL) /* Open input file, do not use binary mode as it makes a difference on non unix systems! */
+            if (i_open(&t_input, argv[i_count], false)) /* Open input file, do not use binary mode as it makes a difference on non unix systems! */
             {
-               if (argc > 2) fprintf(stdout, "%s\n", argv[i_count]); /* Print the files name if multiple files are being processed */
+               if (argc > 2) i_printf(&t_stdout, "%s\n", argv[i_count]); /* Print the files name if multiple files are being processed */
                strcpy(argv[i_count] + strlen(argv[i_count]) - 4, ".com"); /* Substitute '.com' for '.hex' in the file name */
-               if ((h_output = fopen(argv[i_count], "wb")) != NULL) /* oOpen the output file */
+               if (i_create(&t_output, argv[i_count], true)) /* Open the output file */
                {
-                  i_read_hex(h_input, h_output, 0x0100);
-                  fclose(h_output);
+                  ul_read_hex(&t_input, &t_output);
+                  if (t_input.i_error) v_error("Cannot read %s: %s\n", argv[i_count], s_reason(t_input.i_error));
+                  if (!i_finish(&t_output)) v_error("Cannot write %s: %s\n", argv[i_count], s_reason(errno));
                }
                else /* Can't open output file */
-               {
-#if defined(VMS) /* Use VAX-C extension (avoids potential ACCVIO) */
-                  v_error("Cannot open %s: %s\n", argv[i_count], strerror(errno, vaxc$errno)); 
-#else
-                  v_error("Cannot open %s: %s\n", argv[i_count], strerror(errno));
-#endif
-               }
-               fclose(h_input);
+                  v_error("Cannot open %s: %s\n", argv[i_count], s_reason(errno));
+               v_close(&t_input);
             }
             else /* Can't open input file */
-            {
-#if defined(VMS) /* Use VAX-C extension (avoids potential ACCVIO) */
-               v_error("Cannot open %s: %s\n", argv[i_count], strerror(errno, vaxc$errno)); 
-#else
-               v_error("Cannot open %s: %s\n", argv[i_count], strerror(errno));
-#endif
-            }
+               v_error("Cannot open %s: %s\n", argv[i_count], s_reason(errno));
          }
          else
             v_error("Cannot open %s: Invalid filetype \n", argv[i_count], argv[i_count]);
@@ -375,5 +265,10 @@ int main(int argc, char **argv)
       else
          v_error("Cannot open %s: Can't read from a directory\n", argv[i_count], argv[i_count]);
    }
+   if (!i_flush(&t_stdout))
+   {
+      v_error("Cannot write standard output: %s\n", s_reason(errno));
+      exit(-1);
+   }
    exit (0);
 }
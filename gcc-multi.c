@@ -0,0 +1,223 @@
+/*
+ * multi.c
+ *
+ * Copyright(C) 2026   MT
+ *
+ * Runs  any of the other programs depending on the name it was called by,
+ * so  that  they  can  all be built as a  single  statically  linked  file
+ * without  any  shared libraries to load each time a program  starts,  and
+ * runs lists of commands without starting a new program for each one.
+ *
+ * Deliberatly avoids using 'getopt' or 'argparse' to maximize portability.
+ *
+ * This  program is free software: you can redistribute it and/or modify it
+ * under  the terms of the GNU General Public License as published  by  the
+ * Free  Software Foundation, either version 3 of the License, or (at  your
+ * option) any later version.
+ *
+ * This  program  is distributed in the hope that it will  be  useful,  but
+ * WITHOUT   ANY   WARRANTY;   without even   the   implied   warranty   of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You  should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * 18 Oct 26   0.1   - Initial version - MT
+ *                   - Added gcc-hexd - MT
+ *
+ */
+
+#define  NAME        "gcc-multi"
+#define  VERSION     "0.1"
+#define  BUILD       "0002"
+#define  AUTHOR      "MT"
+#define  COPYRIGHT   (__DATE__ + 7) /* Extract copyright year from date */
+
+#define  LINE_SIZE   4096                     /* Longest command in a list */
+#define  ARGS_MAX    256                      /* Largest number of words in a command */
+#define  PROGRAM_MAX 32                       /* Longest program name */
+
+#define  false       0
+#define  true        !false
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined(VMS) || defined(MSDOS) || defined (WIN32)
+#undef   BATCH
+#else
+#define  BATCH /* Each command in a list runs in a copy of this process */
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+#include "gcc-debug.h"
+#include "gcc-io.h"
+
+int main_gcc_detab(int argc, char **argv);
+int main_gcc_dump(int argc, char **argv);
+int main_gcc_entab(int argc, char **argv);
+int main_gcc_hexd(int argc, char **argv);
+int main_gcc_load(int argc, char **argv);
+int main_gcc_rehex(int argc, char **argv);
+int main_gcc_unload(int argc, char **argv);
+
+typedef struct
+{
+   char *s_name;
+   int (*p_main)(int argc, char **argv);
+} t_program;
+
+t_program a_programs[] = {
+   {"gcc-detab", main_gcc_detab},
+   {"gcc-dump", main_gcc_dump},
+   {"gcc-entab", main_gcc_entab},
+   {"gcc-hexd", main_gcc_hexd},
+   {"gcc-load", main_gcc_load},
+   {"gcc-rehex", main_gcc_rehex},
+   {"gcc-unload", main_gcc_unload},
+   {NULL, NULL}
+};
+
+char s_program[PROGRAM_MAX] = NAME; /* Name used in error messages, changed to the program being run */
+
+void v_version() /* Display version information */
+{
+   fprintf(stderr, "%s: Version %s\n", NAME, VERSION);
+   fprintf(stdout, "Copyright(C) %s %s\n", COPYRIGHT, AUTHOR);
+   fprintf(stdout, "License GPLv3+: GNU GPL version 3 or later <http://gnu.org/licenses/gpl.html>.\n");
+   fprintf(stdout, "This is free software: you are free to change and redistribute it.\n");
+   fprintf(stdout, "There is NO WARRANTY, to the extent permitted by law.\n");
+   exit(0);
+}
+
+void v_about() /* Display help text */
+{
+   t_program *p_program;
+
+   fprintf(stdout, "Usage: %s PROGRAM [OPTION]... [FILE]...\n", NAME);
+   fprintf(stdout, "  or:  %s --batch [FILE]\n", NAME);
+   fprintf(stdout, "  or:  PROGRAM [OPTION]... [FILE]...\n");
+   fprintf(stdout, "Runs PROGRAM, or runs it when called by its name through a link.\n\n");
+#if defined(BATCH)
+   fprintf(stdout, "  --batch [FILE]           run each line of FILE as a command\n");
+#endif
+   fprintf(stdout, "  --help                   display this help and exit\n");
+   fprintf(stdout, "  --version                output version information and exit\n");
+   fprintf(stdout, "\nPrograms:");
+   for (p_program = a_programs; p_program->s_name != NULL; p_program++)
+      fprintf(stdout, " %s", p_program->s_name);
+#if defined(BATCH)
+   fprintf(stdout, "\n\nWords in a command are separated by blanks, there is no quoting.\n");
+   fprintf(stdout, "With no FILE read standard input.\n");
+#else
+   fprintf(stdout, "\n");
+#endif
+   exit(0);
+}
+
+t_program *p_find(char *s_path) /* Return the program with the name at the end of a path, or NULL */
+{
+   t_program *p_program;
+   char *s_name;
+   size_t i_length;
+
+   for (s_name = s_path + strlen(s_path); s_name > s_path && s_name[-1] != '/' && s_name[-1] != '\\' && s_name[-1] != ']'; s_name--);
+   i_length = strcspn(s_name, ".;"); /* Ignore any file type or version */
+   for (p_program = a_programs; p_program->s_name != NULL; p_program++)
+      if (strlen(p_program->s_name) == i_length && !strncmp(p_program->s_name, s_name, i_length)) return p_program;
+   return NULL;
+}
+
+int i_run(t_program *p_program, int argc, char **argv) /* Run a program in this process */
+{
+   strcpy(s_program, p_program->s_name);
+   return p_program->p_main(argc, argv);
+}
+
+#if defined(BATCH)
+int i_batch(t_input *p_input, char *s_name) /* Run each line as a command in a copy of this process, returns the number of commands that failed */
+{
+   char s_line[LINE_SIZE];
+   char *a_args[ARGS_MAX + 1];
+   t_program *p_program;
+   pid_t t_child;
+   int i_line = 0, i_failed = 0, i_args, i_status;
+
+   while (s_gets(s_line, sizeof(s_line), p_input) != NULL)
+   {
+      i_line++;
+      if (strchr(s_line, '\n') == NULL && !i_eof(p_input))
+      {
+         v_error("%s: line %d: command too long\n", s_name, i_line);
+         while ((i_status = i_getc(p_input)) != EOF && i_status != '\n'); /* Skip the rest of the line */
+         i_failed++;
+         continue;
+      }
+      for (i_args = 0, a_args[0] = strtok(s_line, " \t\r\n"); a_args[i_args] != NULL && i_args < ARGS_MAX; )
+         a_args[++i_args] = strtok(NULL, " \t\r\n");
+      if (!i_args || a_args[0][0] == '#') continue; /* Ignore blank lines and comments */
+      if (a_args[i_args] != NULL)
+      {
+         v_error("%s: line %d: too many arguments\n", s_name, i_line);
+         i_failed++;
+         continue;
+      }
+      if ((p_program = p_find(a_args[0])) == NULL)
+      {
+         v_error("%s: line %d: unknown program %s\n", s_name, i_line, a_args[0]);
+         i_failed++;
+         continue;
+      }
+      fflush(stdout);
+      if ((t_child = fork()) < 0)
+      {
+         v_error("Cannot run %s: %s\n", a_args[0], s_reason(errno));
+         i_failed++;
+         continue;
+      }
+      if (t_child == 0) /* Nothing needs to be loaded again, the program is already here */
+         exit(i_run(p_program, i_args, a_args));
+      while (waitpid(t_child, &i_status, 0) < 0 && errno == EINTR);
+      if (!WIFEXITED(i_status) || WEXITSTATUS(i_status)) i_failed++;
+   }
+   return i_failed;
+}
+#endif
+
+int main(int argc, char **argv)
+{
+   t_program *p_program;
+#if defined(BATCH)
+   t_input t_input;
+   int i_failed;
+#endif
+
+   if ((p_program = p_find(argv[0])) != NULL) /* Called through a link */
+      return i_run(p_program, argc, argv);
+   if (argc < 2 || !strcmp(argv[1], "--help") || !strcmp(argv[1], "-?"))
+      v_about();
+   if (!strcmp(argv[1], "--version"))
+      v_version();
+#if defined(BATCH)
+   if (!strcmp(argv[1], "--batch"))
+   {
+      if (!i_open(&t_input, argc > 2 ? argv[2] : NULL, false))
+      {
+         v_error("Cannot open %s: %s\n", argv[2], s_reason(errno));
+         exit(-1);
+      }
+      i_failed = i_batch(&t_input, argc > 2 ? argv[2] : "-");
+      v_close(&t_input);
+      exit(i_failed ? 1 : 0);
+   }
+#endif
+   if ((p_program = p_find(argv[1])) == NULL)
+   {
+      v_error("unknown program %s\nTry '%s --help' for more information.\n", argv[1], NAME);
+      exit(-1);
+   }
+   return i_run(p_program, argc - 1, argv + 1);
+}
@@ -0,0 +1,426 @@
+/*
+ * rehex.c
+ *
+ * Copyright(C) 2026 - MT
+ *
+ * Reads  one  or more Intel Hex or Motorola 'S' record files and  rewrites
+ * them  as a single stream of records,  optionally changing the length  of
+ * each record, relocating the data by an offset or converting between  the
+ * two formats.
+ *
+ * Records  are processed one line at a time,  so the memory used does  not
+ * depend  on the size of the image and no intermediate binary file has  to
+ * be created.  Each record is read, and the new records are written, by the
+ * same library that 'load' and 'unload' use.
+ *
+ * Deliberatly avoids using 'getopt' or 'argparse' to maximize portability.
+ *
+ * This  program is free software: you can redistribute it and/or modify it
+ * under  the terms of the GNU General Public License as published  by  the
+ * Free  Software Foundation, either version 3 of the License, or (at  your
+ * option) any later version.
+ *
+ * This  program  is distributed in the hope that it will  be  useful,  but
+ * WITHOUT   ANY   WARRANTY;   without even   the   implied   warranty   of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You  should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * 18 Oct 26   0.1   - Initial version - MT
+ *                   - Uses  the shared input and output module to  read
+ *                     the file in large blocks and buffer the output - MT
+ *                   - Added '--stats' to print what was done - MT
+ *                   - Rejects a record whose length is wrong for its type,
+ *                     and uses the library to read and write records - MT
+ *                   - Checks the record length before it is narrowed to an
+ *                     int - MT
+ *                   - Uses the option helpers in the shared module - MT
+ *
+ */
+
+#define  NAME        "gcc-rehex"
+#define  VERSION     "0.1"
+#define  BUILD       "0006"
+#define  AUTHOR      "MT"
+#define  COPYRIGHT   (__DATE__ + 7) /* Extract copyright year from date */
+
+#define  RECORD_SIZE 16   /* Default number of data bytes in each record */
+#define  LINE_SIZE   600  /* Longest input line, a 255 byte record takes 521 characters */
+
+#define  false       0
+#define  true        !false
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+
+#if defined(VMS)
+#include <stat.h>
+#else
+#include <sys/stat.h>
+#endif
+#include "gcc-debug.h"
+#include "gcc-io.h"
+#include "gcc-hex.h"
+
+char s_program[] = NAME;
+const char *a_reasons[] = {"", "", "invalid character in record", "invalid record length", "checksum error", "unknown record type"}; /* Why a record can't be used */
+
+t_encoder t_hex; /* Output format, start address and the records written so far */
+long l_length = RECORD_SIZE; /* Maximum number of data bytes in each output record, checked before it is narrowed */
+long l_offset = 0; /* Added to the address of every record */
+
+unsigned char a_record[HEX_RECORD_MAX]; /* Data bytes waiting to be written */
+char s_records[2 * HEX_LINE]; /* Formatted records */
+unsigned long ul_record; /* Address of the first byte waiting to be written */
+int i_pending = 0; /* Number of bytes waiting to be written */
+unsigned long ul_lines = 0; /* Number of lines read from all the files */
+
+void v_version() /* Display version information */
+{
+   fprintf(stderr, "%s: Version %s\n", NAME, VERSION);
+   fprintf(stdout, "Copyright(C) %s %s\n", COPYRIGHT, AUTHOR);
+   fprintf(stdout, "License GPLv3+: GNU GPL version 3 or later <http://gnu.org/licenses/gpl.html>.\n");
+   fprintf(stdout, "This is free software: you are free to change and redistribute it.\n");
+   fprintf(stdout, "There is NO WARRANTY, to the extent permitted by law.\n");
+   exit(0);
+}
+
+#if defined(VMS) || defined(MSDOS) || defined (WIN32) /* Use DEC/Microsoft command line options */
+void v_about() /* Display help text */
+{
+   fprintf(stdout, "Usage: %s [OPTION]... [FILE]...\n", NAME);
+   fprintf(stdout, "Rewrite intel hexadecimal or motorola FILE(s) as a single stream of records.\n\n");
+   fprintf(stdout, "  /intel                   write intel hexadecimal records (default)\n");
+   fprintf(stdout, "  /length=N                write at most N data bytes in each record\n");
+   fprintf(stdout, "  /motorola                write motorola 'S' records\n");
+   fprintf(stdout, "  /offset=N                add N to the address of every record\n");
+   fprintf(stdout, "  /statistics              print what was done on exit\n");
+   fprintf(stdout, "  /version                 output version information and exit\n");
+   fprintf(stdout, "  /?, /help                display this help and exit\n");
+   exit(0);
+}
+#else
+void v_about() /* Display help text */
+{
+   fprintf(stdout, "Usage: %s [OPTION]... [FILE]...\n", NAME);
+   fprintf(stdout, "Rewrite intel hexadecimal or motorola FILE(s) as a single stream of records.\n\n");
+   fprintf(stdout, "  -i, --intel              write intel hexadecimal records (default)\n");
+   fprintf(stdout, "  -l, --length N           write at most N data bytes in each record\n");
+   fprintf(stdout, "  -o, --offset N           add N to the address of every record\n");
+   fprintf(stdout, "  -s, --motorola           write motorola 'S' records\n");
+   fprintf(stdout, "      --stats              print what was done on exit\n");
+   fprintf(stdout, "      --stats-json         print what was done on exit in JSON\n");
+   fprintf(stdout, "  -?, --help               display this help and exit\n");
+   fprintf(stdout, "      --version            output version information and exit\n");
+   fprintf(stdout, "\nWith no FILE read standard input.\n");
+   exit(0);
+}
+#endif
+
+void v_output(void *p_context, const char *s_text, size_t i_length) /* Write the records */
+{
+   v_write(&t_stdout, s_text, i_length);
+}
+
+void v_flush() /* Write any data bytes waiting to be written as a single record */
+{
+   t_chunk t_chunk;
+
+   if (!i_pending) return;
+   stats_enter(STATS_FORMAT);
+   if (t_hex.i_format == HEX_MOTOROLA && i_hex_width(ul_record + i_pending - 1) > t_hex.i_width)
+      t_hex.i_width = i_hex_width(ul_record + i_pending - 1); /* Never reduce the address size */
+   t_chunk.s_output = s_records;
+   v_hex_format(&t_hex, &t_chunk, a_record, ul_record, i_pending);
+   i_hex_write(&t_hex, &t_chunk); /* Addresses have already been checked */
+   i_pending = 0;
+   stats_leave();
+}
+
+void v_data(unsigned long ul_address, unsigned char *a_data, int i_bytes) /* Add data bytes to the output */
+{
+   while (i_bytes-- > 0)
+   {
+      if (i_pending && ((ul_address != ul_record + i_pending) || (i_pending >= t_hex.i_size) ||
+         ((t_hex.i_format == HEX_INTEL) && !(ul_address & 0xFFFF)))) /* Intel Hex records may not cross a 64K boundary */
+         v_flush();
+      if (!i_pending) ul_record = ul_address;
+      a_record[i_pending++] = *a_data++;
+      ul_address++;
+   }
+}
+
+void v_end() /* Write any remaining data and the trailing records */
+{
+   v_flush();
+   if (!t_hex.b_start) t_hex.l_upper = 0; /* Only write a start address if one was read */
+   i_hex_end(&t_hex);
+}
+
+int i_relocate(unsigned long *ul_address) /* Add the offset to an address, returning false if out of range */
+{
+   if (l_offset < 0 && *ul_address < (unsigned long) -l_offset) return false;
+   *ul_address += l_offset;
+   return (*ul_address <= 0xFFFFFFFFUL);
+}
+
+int i_rehex(t_input *p_input, char *s_name) /* Read records and write them out again, returns the number of errors */
+{
+   char s_line[LINE_SIZE];
+   t_record t_record;
+   unsigned long ul_base = 0; /* Extended segment or linear address */
+   unsigned long ul_address;
+   unsigned char *p_data;
+   int i_line = 0;
+   int i_errors = 0;
+   int i_result, i_char;
+
+   stats_stage(STATS_PARSE);
+   while (s_gets(s_line, sizeof(s_line), p_input) != NULL)
+   {
+      i_line++;
+      stats(ul_lines++);
+      if (strchr(s_line, '\n') == NULL && !i_eof(p_input))
+      {
+         v_error("%s: line %d: record too long\n", s_name, i_line);
+         i_errors++;
+         while ((i_char = i_getc(p_input)) != EOF && i_char != '\n'); /* Skip the rest of the line */
+         continue;
+      }
+      if ((i_result = i_hex_record(s_line, &t_record)) == HEX_SKIP) continue; /* Ignore anything that isn't a record */
+      if (i_result == HEX_TYPE && t_record.b_motorola)
+      {
+         v_error("%s: line %d: unknown record type S%c\n", s_name, i_line, '0' + t_record.i_type);
+         i_errors++;
+      }
+      else if (i_result == HEX_TYPE)
+      {
+         v_error("%s: line %d: unknown record type %02X\n", s_name, i_line, t_record.i_type);
+         i_errors++;
+      }
+      else if (i_result != HEX_VALID)
+      {
+         v_error("%s: line %d: %s\n", s_name, i_line, a_reasons[i_result]);
+         i_errors++;
+      }
+      else if (!t_record.b_motorola) /* Intel Hex */
+      {
+         ul_address = t_record.ul_address;
+         p_data = t_record.a_data;
+         switch (t_record.i_type)
+         {
+         case 0: /* Data */
+            ul_address += ul_base;
+            if (!i_relocate(&ul_address))
+            {
+               v_error("%s: line %d: address out of range\n", s_name, i_line);
+               i_errors++;
+            }
+            else
+               v_data(ul_address, p_data, t_record.i_bytes);
+            break;
+         case 1: /* End of file */
+            return i_errors;
+         case 2: /* Extended segment address */
+            ul_base = ((p_data[0] << 8) | p_data[1]) << 4;
+            break;
+         case 3: /* Start segment address */
+            t_hex.ul_start = (((p_data[0] << 8) | p_data[1]) << 4) + ((p_data[2] << 8) | p_data[3]);
+            t_hex.b_start = i_relocate(&t_hex.ul_start);
+            break;
+         case 4: /* Extended linear address */
+            ul_base = (unsigned long) ((p_data[0] << 8) | p_data[1]) << 16;
+            break;
+         case 5: /* Start linear address */
+            t_hex.ul_start = ((unsigned long) p_data[0] << 24) | (p_data[1] << 16) | (p_data[2] << 8) | p_data[3];
+            t_hex.b_start = i_relocate(&t_hex.ul_start);
+            break;
+         }
+      }
+      else if (t_record.i_type == 0 || t_record.i_type == 5 || t_record.i_type == 6) /* Ignore header and count records */
+         continue;
+      else /* Motorola 'S' record */
+      {
+         ul_address = t_record.ul_address;
+         if (t_record.i_type > 3 && !ul_address) /* A termination record with a zero address has no start address */
+            return i_errors;
+         if (!i_relocate(&ul_address))
+         {
+            v_error("%s: line %d: address out of range\n", s_name, i_line);
+            i_errors++;
+         }
+         else if (t_record.i_type <= 3) /* S1, S2 or S3 data record */
+            v_data(ul_address, t_record.a_data, t_record.i_bytes);
+         else /* S7, S8 or S9 termination record */
+         {
+            t_hex.ul_start = ul_address;
+            t_hex.b_start = true;
+            return i_errors;
+         }
+      }
+   }
+   return i_errors;
+}
+
+int main(int argc, char **argv)
+{
+   t_input t_input;
+   int i_count, i_index;
+   int i_errors = 0;
+
+   v_hex_encoder(&t_hex, NULL, 0, v_output, NULL); /* Records are formatted here, so no buffer is needed */
+
+#if defined(VMS) || defined(MSDOS) || defined (WIN32) /* Parse DEC/Microsoft style command line options */
+   for (i_count = 1; i_count < argc; i_count++)
+   {
+      if (argv[i_count][0] == '/')
+      {
+         for (i_index = 0; argv[i_count][i_index] && argv[i_count][i_index] != '='; i_index++) /* Convert option to uppercase */
+            if (argv[i_count][i_index] >= 'a' && argv[i_count][i_index] <= 'z')
+               argv[i_count][i_index] = argv[i_count][i_index] - 32;
+         if (!strncmp(argv[i_count], "/VERSION", i_index))
+            v_version(); /* Display version information */
+         else if (!strncmp(argv[i_count], "/INTEL", i_index))
+            t_hex.i_format = HEX_INTEL;
+         else if (!strncmp(argv[i_count], "/LENGTH", i_index))
+            l_length = l_number(argv[i_count][i_index] ? argv[i_count] + i_index + 1 : NULL, "/LENGTH");
+         else if (!strncmp(argv[i_count], "/MOTOROLA", i_index))
+            t_hex.i_format = HEX_MOTOROLA;
+         else if (!strncmp(argv[i_count], "/OFFSET", i_index))
+            l_offset = l_number(argv[i_count][i_index] ? argv[i_count] + i_index + 1 : NULL, "/OFFSET");
+         else if (!strncmp(argv[i_count], "/STATISTICS", i_index))
+            v_stats(false, "lines");
+         else if (!strncmp(argv[i_count], "/HELP", i_index))
+            v_about();
+         else if (!strncmp(argv[i_count], "/?", i_index))
+            v_about();
+         else
+         { /* If we get here then the we have an invalid option */
+            v_error("invalid option %s\nTry '%s /help' for more information.\n", argv[i_count] , NAME);
+            exit(-1);
+         }
+         if (argv[i_count][1] != 0) {
+            for (i_index = i_count; i_index < argc - 1; i_index++) argv[i_index] = argv[i_index + 1];
+            argc--; i_count--;
+         }
+      }
+   }
+#else /* Parse UNIX style command line options */
+   char b_abort = false; /* Stop processing command line */
+   for (i_count = 1; i_count < argc && (b_abort != true); i_count++)
+   {
+      if (argv[i_count][0] == '-')
+      {
+         i_index = 1;
+         while (argv[i_count][i_index] != 0)
+         {
+            switch (argv[i_count][i_index])
+            {
+            case 'i': /* Write Intel Hex records */
+               t_hex.i_format = HEX_INTEL; break;
+            case 'l': /* Maximum record length */
+               l_length = l_number(s_value(&argc, argv, i_count), "-l"); break;
+            case 'o': /* Address offset */
+               l_offset = l_number(s_value(&argc, argv, i_count), "-o"); break;
+            case 's': /* Write Motorola 'S' records */
+               t_hex.i_format = HEX_MOTOROLA; break;
+            case '?': /* Display help */
+               v_about();
+            case '-': /* '--' terminates command line processing */
+               i_index = strlen(argv[i_count]);
+               if (i_index == 2)
+                 b_abort = true; /* '--' terminates command line processing */
+               else
+                  if (!strncmp(argv[i_count], "--version", i_index))
+                     v_version(); /* Display version information */
+                  else if (!strncmp(argv[i_count], "--intel", i_index))
+                     t_hex.i_format = HEX_INTEL;
+                  else if (!strncmp(argv[i_count], "--length", i_index))
+                     l_length = l_number(s_value(&argc, argv, i_count), "--length");
+                  else if (!strncmp(argv[i_count], "--motorola", i_index))
+                     t_hex.i_format = HEX_MOTOROLA;
+                  else if (!strncmp(argv[i_count], "--offset", i_index))
+                     l_offset = l_number(s_value(&argc, argv, i_count), "--offset");
+                  else if (!strncmp(argv[i_count], "--stats", i_index))
+                     v_stats(false, "lines");
+                  else if (!strncmp(argv[i_count], "--stats-json", i_index))
+                     v_stats(true, "lines");
+                  else if (!strncmp(argv[i_count], "--help", i_index))
+                     v_about();
+                  else
+                  { /* If we get here then the we have an invalid long option */
+                     v_error("invalid option %s\nTry '%s --help' for more information.\n", argv[i_count], NAME);
+                     exit(-1);
+                  }
+               i_index--; /* Leave index pointing at end of string (so argv[i_count][i_index] = 0) */
+               break;
+            default: /* If we get here the single letter option is unknown */
+               v_error("unknown option -- %c\nTry '%s --help' for more information.\n", argv[i_count][i_index] , NAME);
+               exit(-1);
+            }
+            i_index++; /* Parse next letter in options */
+         }
+         if (argv[i_count][1] != 0) {
+            for (i_index = i_count; i_index < argc - 1; i_index++) argv[i_index] = argv[i_index + 1];
+            argc--; i_count--;
+         }
+      }
+   }
+#endif
+
+   if (l_length < 1 || l_length > HEX_RECORD_MAX)
+   {
+      v_error("invalid record length %ld, must be between 1 and %d\n", l_length, HEX_RECORD_MAX);
+      exit(-1);
+   }
+   t_hex.i_size = (t_hex.i_format == HEX_MOTOROLA && l_length > HEX_MOTOROLA_MAX) ? HEX_MOTOROLA_MAX : l_length; /* Leave room for a four byte address */
+   t_hex.i_width = 2; /* Widened as needed by the addresses that are read */
+   t_hex.ul_load = 0; /* Start address if none is read */
+
+   v_hex_begin(&t_hex, "");
+   if (argc < 2 && i_open(&t_input, NULL, false)) /* Read standard input if no files were specified */
+   {
+      i_errors += i_rehex(&t_input, "-");
+      v_close(&t_input);
+   }
+   for (i_count = 1; i_count < argc; i_count++) /* Process files */
+   {
+      if (!i_isdir(argv[i_count])) /* Check that input files isn't a directory! */
+      {
+         if (i_open(&t_input, argv[i_count], false)) /* Open input file, do not use binary mode as it makes a difference on non unix systems! */
+         {
+            i_errors += i_rehex(&t_input, argv[i_count]);
+            if (t_input.i_error)
+            {
+               v_error("Cannot read %s: %s\n", argv[i_count], s_reason(t_input.i_error));
+               i_errors++;
+            }
+            v_close(&t_input);
+         }
+         else
+         {
+            v_error("Cannot open %s: %s\n", argv[i_count], s_reason(errno));
+            i_errors++;
+         }
+      }
+      else
+      {
+         v_error("Cannot open %s: Can't read from a directory\n", argv[i_count]);
+         i_errors++;
+      }
+   }
+   stats_stage(STATS_OTHER);
+   stats_count(ull_records, ul_lines);
+   v_end();
+   if (!i_flush(&t_stdout))
+   {
+      v_error("Cannot write standard output: %s\n", s_reason(errno));
+      exit(-1);
+   }
+   exit (i_errors ? 1 : 0);
+}
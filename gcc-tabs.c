@@ -0,0 +1,604 @@
+/*
+ * gcc-tabs.c
+ *
+ * Copyright(C) 2026   MT
+ *
+ * Tab stops, UTF-8 character widths and the pool of threads shared by the
+ * programs that replace tabs and spaces.
+ *
+ * The  files named on the command line, and those found in directories,
+ * are  listed  in order, large files are split at line breaks  and  small
+ * files  are batched together.  Each thread starts with an equal share  of
+ * the  work, steals from the thread with the most left when it runs  out,
+ * and  helps  with the oldest work when too much output is  waiting  to  be
+ * written.  Each program supplies the functions that convert and check the
+ * text.
+ *
+ * This  program is free software: you can redistribute it and/or modify it
+ * under  the terms of the GNU General Public License as published  by  the
+ * Free  Software Foundation, either version 3 of the License, or (at  your
+ * option) any later version.
+ *
+ * This  program  is distributed in the hope that it will  be  useful,  but
+ * WITHOUT   ANY   WARRANTY;   without even   the   implied   warranty   of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You  should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * 18 Oct 26         - Initial version, moved from 'detab' and 'entab' - MT
+ *                   - Reports a file named on the command line that is not
+ *                     a regular file or a directory - MT
+ *
+ */
+
+#define  STOPS_MAX   256                      /* Largest number of tab stops in a list */
+#define  COLUMN_MAX  65535                    /* Highest column for a tab stop */
+#define  PIECE_SIZE  4194304                  /* Files larger than this are split between threads at line breaks */
+#define  BATCH_SIZE  262144                   /* Small files are given to a thread in batches of about this size */
+#define  HELD_MAX    67108864                 /* Output that may be held waiting to be written before threads have to help with the oldest work */
+
+#define  false       0
+#define  true        !false
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined(VMS)
+#include <stat.h>
+#else
+#include <sys/stat.h>
+#endif
+#include "gcc-debug.h"
+#include "gcc-io.h"
+#include "gcc-tabs.h"
+#if defined(THREADS)
+#include <pthread.h>
+#include <dirent.h>
+#include <fnmatch.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+char b_hflag = false;
+char b_recursive = false; /* Process the files in directories */
+char *s_pattern; /* Only process files in directories with names that match */
+int i_jobs = 1; /* Number of threads */
+char b_inplace = false; /* Replace the contents of each file */
+char b_sync = false; /* Make sure replaced files are on the disk */
+char b_check = false; /* Only report the first line that would change */
+char b_utf8 = false; /* Count the columns used by UTF-8 characters */
+int i_width = TAB_WIDTH; /* Number of columns between tab stops, or zero to use a list */
+unsigned long *a_next; /* Next tab stop for each column when using a list */
+unsigned long ul_stops; /* Number of columns in the table */
+
+void v_stops(char *s_arg, char *s_option) /* Set the distance between tab stops or a list of tab stops */
+{
+   unsigned long a_list[STOPS_MAX];
+   unsigned long ul_column;
+   char *s_next = s_arg, *s_end;
+   long l_value;
+   int i_stops = 0, i_count = 0;
+
+   if (s_arg == NULL)
+   {
+      v_error("option requires an argument -- %s\n", s_option);
+      exit(-1);
+   }
+   do /* Read the comma separated list of columns */
+   {
+      errno = 0;
+      l_value = strtol(s_next, &s_end, 10);
+      if (errno || s_end == s_next || (*s_end && *s_end != ',') || l_value < 1 || l_value > COLUMN_MAX ||
+         i_stops >= STOPS_MAX || (i_stops && l_value <= a_list[i_stops - 1]))
+      {
+         v_error("invalid tab stops '%s' for option %s\n", s_arg, s_option);
+         exit(-1);
+      }
+      a_list[i_stops++] = l_value;
+      s_next = s_end + 1;
+   } while (*s_end == ',');
+   if (i_stops == 1) /* A single value gives the distance between tab stops */
+   {
+      i_width = a_list[0];
+      return;
+   }
+   i_width = 0;
+   ul_stops = a_list[i_stops - 1] + 1;
+   if ((a_next = realloc(a_next, ul_stops * sizeof(*a_next))) == NULL) /* Reuse the table if '-t' is given again */
+   {
+      v_error("Cannot allocate memory: %s\n", s_reason(errno));
+      exit(-1);
+   }
+   for (ul_column = 0; ul_column < ul_stops; ul_column++) /* Look up the next tab stop for every column */
+   {
+      if (ul_column > a_list[i_count]) i_count++;
+      a_next[ul_column] = a_list[i_count];
+   }
+}
+
+int i_ascii(const char *p_data, size_t i_length) /* Return true if some text has no UTF-8 characters */
+{
+   const unsigned long ul_high = ~0UL / 0xFF * 0x80; /* Top bit of every byte in a word */
+   unsigned long a_word[4], ul_bits = 0;
+   size_t i_count = 0;
+
+   for (; i_count + sizeof(a_word) <= i_length; i_count += sizeof(a_word)) /* Check four words at a time */
+   {
+      memcpy(a_word, p_data + i_count, sizeof(a_word));
+      ul_bits |= a_word[0] | a_word[1] | a_word[2] | a_word[3];
+   }
+   for (; i_count < i_length; i_count++) ul_bits |= (unsigned char) p_data[i_count];
+   return !(ul_bits & ul_high);
+}
+
+int i_decode(const char *p_data, const char *p_end, unsigned long *ul_code) /* Decode a UTF-8 character, returns the number of bytes used */
+{
+   const unsigned char *p_byte = (const unsigned char *) p_data;
+   int i_length, i_count;
+
+   i_length = (*p_byte >= 0xF0) ? 4 : (*p_byte >= 0xE0) ? 3 : (*p_byte >= 0xC0) ? 2 : 1;
+   *ul_code = (i_length == 1) ? *p_byte : *p_byte & (0x7F >> i_length);
+   if (i_length == 1 && *p_byte >= 0x80) *ul_code = 0xFFFD; /* A continuation byte on its own */
+   if (i_length > p_end - p_data) i_length = 0;
+   for (i_count = 1; i_count < i_length; i_count++)
+   {
+      if ((p_byte[i_count] & 0xC0) != 0x80) break;
+      *ul_code = (*ul_code << 6) | (p_byte[i_count] & 0x3F);
+   }
+   if (i_count < i_length || !i_length) /* Invalid or incomplete characters use one column each byte */
+   {
+      *ul_code = 0xFFFD;
+      return 1;
+   }
+   return i_length;
+}
+
+int i_wide(unsigned long ul_code) /* Return the number of columns used to display a character */
+{
+   static const unsigned long a_zero[][2] = {{0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x0610, 0x061A},
+      {0x064B, 0x065F}, {0x0E31, 0x0E31}, {0x0E34, 0x0E3A}, {0x1AB0, 0x1AFF}, {0x1DC0, 0x1DFF}, {0x200B, 0x200F},
+      {0x20D0, 0x20FF}, {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F}}; /* Combining marks and other characters with no width */
+   static const unsigned long a_double[][2] = {{0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x2E80, 0x303E},
+      {0x3041, 0x33FF}, {0x3400, 0x4DBF}, {0x4E00, 0x9FFF}, {0xA000, 0xA4CF}, {0xAC00, 0xD7A3}, {0xF900, 0xFAFF},
+      {0xFE30, 0xFE4F}, {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6}, {0x1F300, 0x1F64F}, {0x1F900, 0x1F9FF}, {0x20000, 0x2FFFD},
+      {0x30000, 0x3FFFD}}; /* East Asian wide and full width characters */
+   int i_count;
+
+   if (ul_code < 0x0300) return 1;
+   for (i_count = 0; i_count < sizeof(a_zero) / sizeof(a_zero[0]); i_count++)
+      if (ul_code >= a_zero[i_count][0] && ul_code <= a_zero[i_count][1]) return 0;
+   for (i_count = 0; i_count < sizeof(a_double) / sizeof(a_double[0]); i_count++)
+      if (ul_code >= a_double[i_count][0] && ul_code <= a_double[i_count][1]) return 2;
+   return 1;
+}
+
+unsigned long ul_width(const char *p_data, const char *p_end) /* Return the number of columns used by some UTF-8 text */
+{
+   unsigned long ul_count = 0, ul_code;
+
+   while (p_data < p_end)
+      if (!(*p_data & 0x80))
+      {
+         ul_count++;
+         p_data++;
+      }
+      else
+      {
+         p_data += i_decode(p_data, p_end, &ul_code);
+         ul_count += i_wide(ul_code);
+      }
+   return ul_count;
+}
+
+size_t i_partial(const char *p_data, size_t i_length) /* Return the number of bytes in an incomplete UTF-8 character at the end of a block */
+{
+   const unsigned char *p_byte = (const unsigned char *) p_data;
+   size_t i_count;
+
+   for (i_count = 1; i_count <= 3 && i_count <= i_length; i_count++)
+   {
+      if ((p_byte[i_length - i_count] & 0xC0) == 0x80) continue; /* Continuation byte */
+      if (p_byte[i_length - i_count] < 0xC0) return 0;
+      return ((p_byte[i_length - i_count] >= 0xF0 ? 4 : p_byte[i_length - i_count] >= 0xE0 ? 3 : 2) > i_count) ? i_count : 0;
+   }
+   return 0;
+}
+
+unsigned long ul_lines(const char *p_data, const char *p_end) /* Count the line breaks */
+{
+   unsigned long ul_count = 0;
+
+   while (p_data < p_end && (p_data = memchr(p_data, '\n', p_end - p_data)) != NULL)
+   {
+      ul_count++;
+      p_data++;
+   }
+   return ul_count;
+}
+
+#if defined(THREADS)
+typedef struct
+{
+   char *s_name;
+   unsigned long ul_size; /* Size of the file when it was found */
+   unsigned long ul_read; /* Number of characters read */
+   unsigned long ul_written; /* Number of characters written */
+   unsigned long ul_tabs; /* Number of tabs replaced or written */
+   char b_changed; /* File was replaced, or would change */
+   unsigned long ul_line; /* First line that would change */
+} t_file;
+
+typedef struct
+{
+   int i_file; /* First file */
+   int i_files; /* Number of files, small files are processed together */
+   unsigned long ul_begin, ul_end; /* Part of a large file, moved to the next line break when it is read */
+   t_output t_output; /* Converted text */
+   char b_done; /* Text is ready to be written */
+} t_item;
+
+typedef struct
+{
+   int i_head, i_tail; /* Items that are still waiting */
+} t_deque;
+
+t_file *a_files; /* Files found */
+int i_files, i_allocated;
+t_item *a_items; /* Work to be done in the order it must be written */
+int i_items;
+t_deque a_deques[JOBS_MAX]; /* Work waiting for each thread, taken from the head by its owner and from the tail by others */
+unsigned long ul_held; /* Characters converted but not yet written */
+const t_tabs *p_program; /* How the program converts and checks the text */
+pthread_mutex_t t_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t t_changed = PTHREAD_COND_INITIALIZER;
+
+void v_add(char *s_name, unsigned long ul_size) /* Add a file to the list */
+{
+   if (i_files >= i_allocated && (a_files = realloc(a_files, (i_allocated = 2 * i_allocated + 256) * sizeof(t_file))) == NULL)
+   {
+      v_error("Cannot allocate memory: %s\n", s_reason(errno));
+      exit(-1);
+   }
+   if ((a_files[i_files].s_name = strdup(s_name)) == NULL)
+   {
+      v_error("Cannot allocate memory: %s\n", s_reason(errno));
+      exit(-1);
+   }
+   a_files[i_files].ul_size = ul_size;
+   a_files[i_files].ul_read = a_files[i_files].ul_written = a_files[i_files].ul_tabs = 0;
+   a_files[i_files].b_changed = false;
+   a_files[i_files].ul_line = 0;
+   i_files++;
+}
+
+int i_compare(const void *p_first, const void *p_second) /* Sort names into order */
+{
+   return strcmp(*(char **) p_first, *(char **) p_second);
+}
+
+void v_walk(char *s_path, char b_named) /* Find the files to process, b_named is true for paths given on the command line */
+{
+   struct stat t_file_d;
+   struct dirent *p_entry;
+   DIR *h_dir;
+   char **a_names = NULL;
+   char *s_name;
+   int i_names = 0, i_size = 0, i_count;
+
+   if ((b_named ? stat(s_path, &t_file_d) : lstat(s_path, &t_file_d)) != 0) /* Don't follow links found in directories */
+   {
+      v_error("Cannot open %s: %s\n", s_path, s_reason(errno));
+      return;
+   }
+   if (S_ISREG(t_file_d.st_mode))
+   {
+      if (b_named || s_pattern == NULL || !fnmatch(s_pattern, (s_name = strrchr(s_path, '/')) ? s_name + 1 : s_path, 0))
+         v_add(s_path, t_file_d.st_size);
+      return;
+   }
+   if (!S_ISDIR(t_file_d.st_mode)) /* Devices and pipes found in directories are left alone */
+   {
+      if (b_named) v_error("Cannot open %s: Not a regular file\n", s_path);
+      return;
+   }
+   if (!b_recursive)
+   {
+      v_error("Cannot open %s: Can't read from a directory\n", s_path);
+      return;
+   }
+   if ((h_dir = opendir(s_path)) == NULL)
+   {
+      v_error("Cannot open %s: %s\n", s_path, s_reason(errno));
+      return;
+   }
+   while ((p_entry = readdir(h_dir)) != NULL) /* Read the whole directory so the files can be processed in order */
+   {
+      if (!strcmp(p_entry->d_name, ".") || !strcmp(p_entry->d_name, "..")) continue;
+      if (i_names >= i_size && (a_names = realloc(a_names, (i_size = 2 * i_size + 64) * sizeof(char *))) == NULL)
+      {
+         v_error("Cannot allocate memory: %s\n", s_reason(errno));
+         exit(-1);
+      }
+      if ((s_name = malloc(strlen(s_path) + strlen(p_entry->d_name) + 2)) == NULL)
+      {
+         v_error("Cannot allocate memory: %s\n", s_reason(errno));
+         exit(-1);
+      }
+      sprintf(s_name, "%s%s%s", s_path, s_path[strlen(s_path) - 1] == '/' ? "" : "/", p_entry->d_name);
+      a_names[i_names++] = s_name;
+   }
+   closedir(h_dir);
+   qsort(a_names, i_names, sizeof(char *), i_compare);
+   for (i_count = 0; i_count < i_names; i_count++)
+   {
+      v_walk(a_names[i_count], false);
+      free(a_names[i_count]);
+   }
+   free(a_names);
+}
+
+void v_plan() /* Split large files and batch small files into items of work */
+{
+   unsigned long ul_batch = 0; /* Size of the current batch of small files */
+   unsigned long ul_piece;
+   char b_batch = false; /* The last item can take more small files */
+   int i_count, i_size = 0;
+   t_item *p_item;
+
+   for (i_count = 0; i_count < i_files; i_count++)
+   {
+      for (ul_piece = 0; ul_piece == 0 || (ul_piece < a_files[i_count].ul_size && !b_inplace && !b_check && !p_program->b_whole); ul_piece += PIECE_SIZE) /* Files being replaced or checked are never split, nor are files the program must convert from the beginning */
+      {
+         if (a_files[i_count].ul_size <= PIECE_SIZE && b_batch && ul_batch + a_files[i_count].ul_size <= BATCH_SIZE)
+         {
+            a_items[i_items - 1].i_files++; /* Add a small file to the current batch */
+            ul_batch += a_files[i_count].ul_size;
+            break;
+         }
+         if (i_items >= i_size && (a_items = realloc(a_items, (i_size = 2 * i_size + 256) * sizeof(t_item))) == NULL)
+         {
+            v_error("Cannot allocate memory: %s\n", s_reason(errno));
+            exit(-1);
+         }
+         p_item = &a_items[i_items++];
+         memset(p_item, 0, sizeof(t_item));
+         p_item->i_file = i_count;
+         p_item->i_files = 1;
+         p_item->t_output.h_file = -1; /* Keep the text in memory until it can be written in order */
+         p_item->ul_begin = ul_piece;
+         p_item->ul_end = (!b_inplace && !b_check && !p_program->b_whole && ul_piece + PIECE_SIZE < a_files[i_count].ul_size) ? ul_piece + PIECE_SIZE : ~0UL; /* The last piece runs to the end of the file */
+         ul_batch = a_files[i_count].ul_size;
+         b_batch = (a_files[i_count].ul_size <= PIECE_SIZE); /* Only small files start a batch */
+      }
+   }
+}
+
+unsigned long ul_line(const char *p_image, unsigned long ul_size, unsigned long ul_offset) /* Return the start of the first line at or after an offset */
+{
+   const char *p_break;
+
+   if (ul_offset == 0) return 0;
+   if (ul_offset >= ul_size) return ul_size;
+   if ((p_break = memchr(p_image + ul_offset - 1, '\n', ul_size - ul_offset + 1)) == NULL) return ul_size;
+   return p_break - p_image + 1;
+}
+
+int i_rewrite(char *s_name, struct stat *p_file_d, const char *s_buffer, size_t i_length) /* Replace the contents of a file, returns false if there was an error */
+{
+   char *s_temp, *s_base;
+   ssize_t i_done = 0;
+   int h_temp;
+
+   if ((s_temp = malloc(strlen(s_name) + 16)) == NULL)
+   {
+      v_error("Cannot allocate memory: %s\n", s_reason(errno));
+      exit(-1);
+   }
+   strcpy(s_temp, s_name);
+   s_base = (s_base = strrchr(s_temp, '/')) ? s_base + 1 : s_temp;
+   sprintf(s_base, ".%s.XXXXXX", (strrchr(s_name, '/')) ? strrchr(s_name, '/') + 1 : s_name); /* Must be in the same directory to be renamed */
+   if ((h_temp = mkstemp(s_temp)) < 0)
+   {
+      v_error("Cannot create %s: %s\n", s_temp, s_reason(errno));
+      free(s_temp);
+      return false;
+   }
+   stats_count(ul_open, 1);
+   stats_enter(STATS_WRITE);
+   while (i_length > 0 && (i_done = write(h_temp, s_buffer, i_length)) > 0)
+   {
+      stats_count(ul_write, 1);
+      stats_count(ull_out, i_done);
+      s_buffer += i_done;
+      i_length -= i_done;
+   }
+   stats_leave();
+   stats_count(ul_close, 1);
+   if (i_done < 0 || fchmod(h_temp, p_file_d->st_mode & 07777) || (b_sync && fsync(h_temp)) || close(h_temp) || rename(s_temp, s_name))
+   {
+      v_error("Cannot write %s: %s\n", s_name, s_reason(errno));
+      unlink(s_temp);
+      free(s_temp);
+      return false;
+   }
+   free(s_temp);
+   return true;
+}
+
+void v_process(t_item *p_item) /* Convert the files or the part of a file in an item */
+{
+   struct stat t_file_d;
+   unsigned long ul_begin, ul_end, ul_length;
+   size_t i_before; /* Characters already in the output */
+   t_file *p_file;
+   const char *p_change, *p_image;
+   t_input t_input;
+   int i_count;
+
+   for (i_count = p_item->i_file; i_count < p_item->i_file + p_item->i_files; i_count++)
+   {
+      p_file = &a_files[i_count];
+      if (b_hflag && p_item->ul_begin == 0)
+      {
+         v_write(&p_item->t_output, p_file->s_name, strlen(p_file->s_name));
+         v_write(&p_item->t_output, ":\n", 2);
+      }
+      if (b_inplace && !lstat(p_file->s_name, &t_file_d) && S_ISLNK(t_file_d.st_mode))
+      {
+         v_error("Cannot replace %s: Is a symbolic link\n", p_file->s_name);
+         continue;
+      }
+      if (!i_open(&t_input, p_file->s_name, false) || fstat(t_input.h_file, &t_file_d))
+      {
+         if (p_item->ul_begin == 0) v_error("Cannot open %s: %s\n", p_file->s_name, s_reason(errno));
+         v_close(&t_input);
+         continue;
+      }
+      p_image = NULL;
+      if (i_fetch(&t_input, 0, t_input.ul_size, &p_image) < t_input.ul_size) /* Mapped or read in one go */
+      {
+         if (p_item->ul_begin == 0) v_error("Cannot read %s: %s\n", p_file->s_name, s_reason(t_input.i_error));
+         v_close(&t_input);
+         continue;
+      }
+      ul_begin = ul_line(p_image, t_input.ul_size, p_item->ul_begin); /* Both ends move forward to the start of a line */
+      ul_end = ul_line(p_image, t_input.ul_size, p_item->ul_end);
+      ul_length = (ul_end > ul_begin) ? ul_end - ul_begin : 0;
+      p_item->t_output.ul_count = 0;
+      i_before = p_item->t_output.i_length;
+      stats_stage(STATS_FORMAT);
+      if (b_check) /* Stop at the first change */
+      {
+         if (ul_length > 0 && (p_change = p_program->p_check(p_image, ul_length)) != NULL)
+         {
+            p_file->ul_line = ul_lines(p_image, p_change) + 1;
+            p_file->b_changed = true;
+            ul_length = p_change - p_image;
+         }
+      }
+      else if (ul_length > 0) p_program->v_convert(&p_item->t_output, p_image + ul_begin, ul_length, (ul_begin == 0));
+      if (b_inplace) /* Only replace the file if the contents have changed */
+      {
+         if (p_item->t_output.i_length != ul_length || (ul_length > 0 && memcmp(p_item->t_output.s_buffer, p_image, ul_length)))
+            p_file->b_changed = i_rewrite(p_file->s_name, &t_file_d, p_item->t_output.s_buffer, p_item->t_output.i_length);
+         if (!p_file->b_changed) p_item->t_output.i_length = 0; /* Nothing was written */
+      }
+      stats_stage(STATS_OTHER);
+      stats_count(ull_records, p_item->t_output.ul_count);
+      v_close(&t_input);
+      pthread_mutex_lock(&t_lock);
+      p_file->ul_read += ul_length;
+      p_file->ul_written += p_item->t_output.i_length - i_before;
+      if (b_inplace) p_item->t_output.i_length = 0; /* Output has gone to the file */
+      p_file->ul_tabs += p_item->t_output.ul_count;
+      pthread_mutex_unlock(&t_lock);
+   }
+}
+
+int i_take(int i_worker) /* Return the next item for a thread to do, or -1 if there are none left */
+{
+   int i_count, i_best = -1;
+
+   if (ul_held > HELD_MAX) /* Help with the oldest work so the output can be written */
+   {
+      for (i_count = 0; i_count < i_jobs; i_count++)
+         if (a_deques[i_count].i_head < a_deques[i_count].i_tail) return a_deques[i_count].i_head++;
+      return -1;
+   }
+   if (a_deques[i_worker].i_head < a_deques[i_worker].i_tail) return a_deques[i_worker].i_head++;
+   for (i_count = 0; i_count < i_jobs; i_count++) /* Steal from the thread with the most work left */
+      if (a_deques[i_count].i_tail - a_deques[i_count].i_head > 0 &&
+         (i_best < 0 || a_deques[i_count].i_tail - a_deques[i_count].i_head > a_deques[i_best].i_tail - a_deques[i_best].i_head))
+         i_best = i_count;
+   return (i_best < 0) ? -1 : --a_deques[i_best].i_tail;
+}
+
+void *p_worker(void *p_arg) /* Process items until there are none left */
+{
+   int i_worker = (int) (long) p_arg;
+   int i_item;
+
+   pthread_mutex_lock(&t_lock);
+   while ((i_item = i_take(i_worker)) >= 0)
+   {
+      pthread_mutex_unlock(&t_lock);
+      v_process(&a_items[i_item]);
+      pthread_mutex_lock(&t_lock);
+      a_items[i_item].b_done = true;
+      ul_held += a_items[i_item].t_output.i_length;
+      pthread_cond_broadcast(&t_changed);
+   }
+   pthread_mutex_unlock(&t_lock);
+   return NULL;
+}
+
+void v_summary() /* Report what was done to each file */
+{
+   unsigned long ul_read = 0, ul_written = 0, ul_tabs = 0;
+   int i_count;
+
+   for (i_count = 0; i_count < i_files; i_count++)
+   {
+      fprintf(stderr, "%s: %lu bytes read, %lu bytes written, %lu %s%s\n", a_files[i_count].s_name,
+         a_files[i_count].ul_read, a_files[i_count].ul_written, a_files[i_count].ul_tabs, p_program->s_counted, a_files[i_count].b_changed ? ", rewritten" : "");
+      ul_read += a_files[i_count].ul_read;
+      ul_written += a_files[i_count].ul_written;
+      ul_tabs += a_files[i_count].ul_tabs;
+   }
+   fprintf(stderr, "%d files, %lu bytes read, %lu bytes written, %lu %s\n", i_files, ul_read, ul_written, ul_tabs, p_program->s_counted);
+}
+
+int i_pool(int argc, char **argv, const t_tabs *p_tabs) /* Process files and directories using a pool of threads, returns the number of files that would change */
+{
+   pthread_t a_threads[JOBS_MAX];
+   int i_count, i_threads, i_changed = 0;
+
+   p_program = p_tabs;
+   for (i_count = 1; i_count < argc; i_count++)
+      v_walk(argv[i_count], true);
+   v_plan();
+   for (i_count = 0; i_count < i_jobs; i_count++) /* Give each thread an equal share of the items to start with */
+   {
+      a_deques[i_count].i_head = (long) i_items * i_count / i_jobs;
+      a_deques[i_count].i_tail = (long) i_items * (i_count + 1) / i_jobs;
+   }
+   for (i_threads = 0; i_threads < i_jobs; i_threads++)
+      if (pthread_create(&a_threads[i_threads], NULL, p_worker, (void *) (long) i_threads)) break;
+   if (!i_threads) /* Do the work here if no threads could be started */
+   {
+      i_jobs = 1;
+      a_deques[0].i_tail = i_items;
+      p_worker(NULL);
+   }
+   for (i_count = 0; i_count < i_items; i_count++) /* Write the items in order */
+   {
+      pthread_mutex_lock(&t_lock);
+      while (!a_items[i_count].b_done)
+         pthread_cond_wait(&t_changed, &t_lock);
+      pthread_mutex_unlock(&t_lock);
+      v_write(&t_stdout, a_items[i_count].t_output.s_buffer, a_items[i_count].t_output.i_length);
+      free(a_items[i_count].t_output.s_buffer);
+      pthread_mutex_lock(&t_lock);
+      ul_held -= a_items[i_count].t_output.i_length;
+      pthread_mutex_unlock(&t_lock);
+   }
+   for (i_count = 0; i_count < i_threads; i_count++)
+      pthread_join(a_threads[i_count], NULL);
+   if (b_check) /* Report the files that would change in order */
+   {
+      for (i_count = 0; i_count < i_files; i_count++)
+         if (a_files[i_count].b_changed)
+         {
+            i_printf(&t_stdout, "%s:%lu: %s\n", a_files[i_count].s_name, a_files[i_count].ul_line, p_program->s_changed);
+            i_changed++;
+         }
+   }
+   else if (b_recursive || i_jobs > 1)
+      v_summary();
+   return i_changed;
+}
+#endif
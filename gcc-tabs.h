@@ -0,0 +1,73 @@
+/*
+ * gcc-tabs.h
+ *
+ * Copyright(C) 2026   MT
+ *
+ * Tab stops, UTF-8 character widths and the pool of threads shared by the
+ * programs that replace tabs and spaces.
+ *
+ * This  program is free software: you can redistribute it and/or modify it
+ * under  the terms of the GNU General Public License as published  by  the
+ * Free  Software Foundation, either version 3 of the License, or (at  your
+ * option) any later version.
+ *
+ * This  program  is distributed in the hope that it will  be  useful,  but
+ * WITHOUT   ANY   WARRANTY;   without even   the   implied   warranty   of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You  should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * 18 Oct 26         - Initial version - MT
+ *
+ */
+
+#if !defined(GCC_TABS_H) /* Only include once */
+#define GCC_TABS_H
+
+#include "gcc-io.h"
+
+#define  TAB_WIDTH   8                        /* Default number of columns between tab stops */
+#define  JOBS_MAX    64                       /* Largest number of threads */
+
+#if defined(VMS) || defined(MSDOS) || defined (WIN32)
+#undef   THREADS
+#else
+#define  THREADS /* Recursive processing needs POSIX threads and directories */
+#endif
+
+typedef struct
+{
+   void (*v_convert)(t_output *p_output, const char *p_data, size_t i_length, char b_start); /* Convert part of a file that starts on a new line */
+   const char *(*p_check)(const char *p_data, size_t i_length); /* Return the first character that would change, or NULL */
+   const char *s_counted; /* What the program counts, for example "tabs replaced" */
+   const char *s_changed; /* Reported for the first line that would change */
+   char b_whole; /* Files must be converted from the beginning, so are never split */
+} t_tabs;
+
+extern char b_hflag; /* Show where each file starts */
+extern char b_recursive; /* Process the files in directories */
+extern char *s_pattern; /* Only process files in directories with names that match */
+extern int i_jobs; /* Number of threads */
+extern char b_inplace; /* Replace the contents of each file */
+extern char b_sync; /* Make sure replaced files are on the disk */
+extern char b_check; /* Only report the first line that would change */
+extern char b_utf8; /* Count the columns used by UTF-8 characters */
+extern int i_width; /* Number of columns between tab stops, or zero to use a list */
+extern unsigned long *a_next; /* Next tab stop for each column when using a list */
+extern unsigned long ul_stops; /* Number of columns in the table */
+
+void v_stops(char *s_arg, char *s_option); /* Set the distance between tab stops or a list of tab stops */
+
+int i_ascii(const char *p_data, size_t i_length); /* Return true if some text has no UTF-8 characters */
+int i_decode(const char *p_data, const char *p_end, unsigned long *ul_code); /* Decode a UTF-8 character */
+int i_wide(unsigned long ul_code); /* Return the number of columns used to display a character */
+unsigned long ul_width(const char *p_data, const char *p_end); /* Return the number of columns used by some UTF-8 text */
+size_t i_partial(const char *p_data, size_t i_length); /* Return the number of bytes in an incomplete UTF-8 character at the end of a block */
+
+#if defined(THREADS)
+int i_pool(int argc, char **argv, const t_tabs *p_tabs); /* Process files and directories using a pool of threads */
+#endif
+
+#endif
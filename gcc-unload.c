@@ -4,7 +4,8 @@
  * Copyright(C) 2023 - MT
  *
  * Lists the contents of one or more files in eight bit Intel Hex (the same
- * as the output produced by the  CP/M-80  'unload' command).
+ * as the output produced by the  CP/M-80  'unload' command), using the
+ * Motorola 'S' record format, or as an array in C source code.
  *
  * Deliberatly avoids using 'getopt' or 'argparse' to maximize portability.
  *
@@ -33,32 +34,113 @@
  * 10 Aug 23         - Fixed very silly error with true/false values! - MT
  *                   - Do not use stdbool.h as this isn;t available on some
  *                     platforms - MT
- *                     
- * ToDo:             - Add the support for the motorola 'S' format.
+ * 18 Oct 26         - Reads  the input in large blocks and builds complete
+ *                     records  in an output buffer using a lookup table of
+ *                     hexadecimal digits instead of calling printf() for
+ *                     every byte - MT
+ *                   - Added an option to set the number of data bytes  in
+ *                     each record (1-255) - MT
+ *                   - Writes  extended linear address records  (type  04)
+ *                     or optionally extended segment address records (type
+ *                     02)  when  the  data crosses a 64K  boundary,  and  a
+ *                     start address record if one is needed - MT
  *                   - Allow  the load address and the transfer address  to
- *                     specified on the command line?
+ *                     specified on the command line - MT
+ *                   - Added an option to leave out records that only hold
+ *                     a fill byte, and skip holes in sparse files when the
+ *                     fill byte is zero - MT
+ *                   - Formats the input in chunks that always start on  a
+ *                     record boundary, and can use several threads to do
+ *                     this for large files - MT
+ *                   - Added support for the motorola 'S' format - MT
+ *                   - Added  an option to write the output for each  file
+ *                     to  a  '.hex' file, reusing the records for  chunks
+ *                     that have not changed since the last time - MT
+ *                   - Added  an option to write the contents of the  file
+ *                     as an array in C source code - MT
+ *                   - Uses the shared input and output module, formatting
+ *                     chunks straight from the mapped file and reporting
+ *                     errors writing the output - MT
+ *                   - Moved the record formatting into a library that other
+ *                     programs can use without running this one - MT
+ *                   - Added '--stats' to print what was done - MT
+ *                   - Don't copy from a null pointer when an empty chunk is reused - MT
+ *                   - Opens and reads the files ahead in a batch - MT
+ *                   - Formats a file in this thread the usual way if no
+ *                     threads could be started, instead of hanging - MT
+ *                   - Don't pass a null pointer to strcmp() when the first
+ *                     line of the '.sum' file is empty - MT
+ *                   - '--s' is ambiguous, as '/S' is, and an address that
+ *                     is out of range gives a non-zero exit status - MT
+ *                   - Checks the record size and number of jobs before
+ *                     they are narrowed to an int - MT
+ *                   - Rejects a negative fill byte - MT
+ *                   - Removes the old '.sum' file before the new records
+ *                     replace the '.hex' file, and only keeps the new one
+ *                     if they did - MT
+ *                   - Uses the option helpers in the shared module - MT
+ *                     
  */
 
 #define  NAME        "gcc-unload"
 #define  VERSION     "0.1"
-#define  BUILD       "0004"
+#define  BUILD       "0024"
 #define  AUTHOR      "MT"
 #define  COPYRIGHT   (__DATE__ + 7) /* Extract copyright year from date */
+
+#define  _GNU_SOURCE /* SEEK_DATA and SEEK_HOLE */
  
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
-#include <ctype.h>   /* isprint */
 #include <errno.h>
 #include <sys/stat.h>
+#include <unistd.h>  /* lseek */
 
-#define  BUFFER_SIZE 16
+#if defined(VMS) || defined(MSDOS) || defined (WIN32)
+#undef   THREADS
+#else
+#define  THREADS
+#include <pthread.h>
+#endif
+#include "gcc-io.h"
+#include "gcc-hex.h"
+
+#define  SOURCE_SIZE 12                       /* Default number of bytes on each line of a C array */
+#define  CHUNK_SIZE  262144                   /* Number of bytes read from the file and formatted at once */
+#define  JOBS_MAX    64                       /* Largest number of threads */
 
 #define  false       0
 #define  true        !false
 
-unsigned char a_buffer[BUFFER_SIZE];
+t_chunk t_records; /* Records waiting to be written */
+typedef struct
+{
+   unsigned long ul_offset; /* Offset of the chunk in the file */
+   unsigned long ul_length; /* Number of bytes in the chunk */
+   unsigned long long ull_hash; /* Hash of the bytes in the chunk */
+   unsigned long ul_text; /* Offset of the records in the output file */
+   unsigned long ul_size; /* Number of characters in the records */
+   long l_first, l_last; /* Upper address bits of the first and last data records */
+   unsigned long ul_records; /* Number of data records */
+} t_entry;
+
+char s_program[] = NAME;
+t_output *p_output = &t_stdout; /* Output file */
+t_output t_file; /* Output file when writing each file to a '.hex' file */
+unsigned long ul_written; /* Number of characters written to the output file */
+unsigned long ul_text; /* Offset of the records for the last chunk written */
+
+t_input *p_previous; /* Previous output file, or NULL */
+t_input t_previous;
+FILE *h_sums; /* New list of chunk hashes */
+t_entry *a_entries; /* Chunk hashes from the last time the output file was written */
+int i_entries, i_entry; /* Number of entries and the next one to check */
+t_encoder t_hex; /* Output format and options */
+int i_jobs = 1; /* Number of threads used to format records */
+char b_delta = false; /* Write output files reusing unchanged records */
+int i_errors = 0; /* Number of files with an address that was out of range */
 
 void v_version() /* Display version information */
 {
@@ -74,7 +156,17 @@ void v_version() /* Display version information */
 void v_about() /* Display help text */
 {
    fprintf(stdout, "Usage: %s [OPTION]... [FILE]...\n", NAME);
-   fprintf(stdout, "Dump FILE(s) using intel hexadecimal.\n\n");
+   fprintf(stdout, "Dump FILE(s) using intel hexadecimal or motorola 'S' records, or as a C array.\n\n");
+   fprintf(stdout, "  /address=N               load the first byte at address N (default 0x0100)\n");
+   fprintf(stdout, "  /delta                   write each FILE to a '.hex' file reusing unchanged records\n");
+   fprintf(stdout, "  /fill=N                  leave out records that only contain byte N\n");
+   fprintf(stdout, "  /include                 write a C array and its length (12 bytes per line)\n");
+   fprintf(stdout, "  /jobs=N                  use N threads to format records\n");
+   fprintf(stdout, "  /motorola                write motorola 'S' records\n");
+   fprintf(stdout, "  /record_size=N           write N data bytes in each record (1-255)\n");
+   fprintf(stdout, "  /segment                 use extended segment address records\n");
+   fprintf(stdout, "  /start=N                 write a start address record for address N\n");
+   fprintf(stdout, "  /statistics              print what was done on exit\n");
    fprintf(stdout, "  /version                 output version information and exit\n");
    fprintf(stdout, "  /?, /help                display this help and exit\n");
    exit(0);
@@ -83,79 +175,451 @@ void v_about() /* Display help text */
 void v_about() /* Display help text */
 {
    fprintf(stdout, "Usage: %s [OPTION]... [FILE]...\n", NAME);
-   fprintf(stdout, "Dump FILE(s) using intel hexadecimal.\n\n");
+   fprintf(stdout, "Dump FILE(s) using intel hexadecimal or motorola 'S' records, or as a C array.\n\n");
+   fprintf(stdout, "  -a, --address N          load the first byte at address N (default 0x0100)\n");
+   fprintf(stdout, "  -d, --delta              write each FILE to a '.hex' file reusing unchanged records\n");
+   fprintf(stdout, "  -f, --fill N             leave out records that only contain byte N\n");
+   fprintf(stdout, "  -i, --include            write a C array and its length (12 bytes per line)\n");
+   fprintf(stdout, "  -j, --jobs N             use N threads to format records\n");
+   fprintf(stdout, "  -r, --record-size N      write N data bytes in each record (1-255)\n");
+   fprintf(stdout, "  -s, --motorola           write motorola 'S' records\n");
+   fprintf(stdout, "  -t, --start N            write a start address record for address N\n");
+   fprintf(stdout, "  -x, --segment            use extended segment address records\n");
+   fprintf(stdout, "      --stats              print what was done on exit\n");
+   fprintf(stdout, "      --stats-json         print what was done on exit in JSON\n");
    fprintf(stdout, "  -?, --help               display this help and exit\n");
    fprintf(stdout, "      --version            output version information and exit\n");
    exit(0);
 }
 #endif
  
-void v_error(const char *s_fmt, ...) /* Print formatted error message */
+int i_byte(char *s_arg, char *s_option) /* Convert a byte option value, checking it before it is narrowed */
+{
+   long l_value = l_number(s_arg, s_option);
+
+   if (l_value < 0 || l_value > 0xFF)
+   {
+      v_error("invalid fill byte %ld, must be between 0 and 255\n", l_value);
+      exit(-1);
+   }
+   return l_value;
+}
+
+unsigned long ul_boundary(unsigned long ul_offset) /* Return the offset of the end of the chunk that starts at an offset */
+{
+   unsigned long ul_chunk = ul_offset / CHUNK_SIZE + 1;
+   unsigned long ul_end;
+
+   do /* The next multiple of the chunk size moved back to the start of a record */
+      ul_end = ul_hex_align(&t_hex, t_hex.ul_load + CHUNK_SIZE * ul_chunk++) - t_hex.ul_load;
+   while (ul_end <= ul_offset);
+   return ul_end;
+}
+
+void v_output(void *p_context, const char *s_text, size_t i_length) /* Write to the output file */
+{
+   v_write(p_output, s_text, i_length);
+   ul_written += i_length;
+}
+
+int i_write(t_chunk *p_chunk) /* Write the records for a chunk, returns false if there was an error */
+{
+   char b_okay = i_hex_write(&t_hex, p_chunk);
+
+   ul_text = ul_written - p_chunk->i_output;
+   if (!b_okay)
+   {
+      v_error("Address %lX is out of range\n", p_chunk->ul_error);
+      i_errors++;
+      return false;
+   }
+   return true;
+}
+
+int i_address_size(t_input *p_input) /* Number of address bytes needed for the 'S' records for a file */
 {
-   va_list t_args;
-   va_start(t_args, s_fmt);
-   fprintf(stderr, "%s : ", NAME);
-   vfprintf(stderr, s_fmt, t_args);
-   va_end(t_args);
+   unsigned long ul_last = 0xFFFFFFFFUL; /* Highest address used, assume the worst if the size is unknown */
+
+   if (t_hex.i_format != HEX_MOTOROLA) return 0;
+   if (p_input->b_regular)
+      ul_last = t_hex.ul_load + (p_input->ul_size ? p_input->ul_size - 1 : 0);
+   return i_hex_width(ul_last);
 }
 
-int i_isfile(char *s_name) /* Return true if path is a file */
+void v_begin(t_input *p_input, char *s_name) /* Set the address size and write the header record */
 {
-   struct stat t_file_d;
-   stat(s_name, &t_file_d);
-   return (S_ISREG(t_file_d.st_mode));
+   ul_written = 0;
+   t_hex.i_width = i_address_size(p_input);
+   v_hex_begin(&t_hex, s_name);
 }
 
-int i_isdir(char *s_name) /* Return true if path is a directory */
+void v_end(unsigned long ul_length) /* Write the start address and end of file records */
 {
-   struct stat t_file_d;
-   stat(s_name, &t_file_d);
-   return (S_ISDIR(t_file_d.st_mode));
+   t_hex.ul_address = t_hex.ul_load + ul_length;
+   i_hex_end(&t_hex);
+   stats_stage(STATS_OTHER);
+   stats_count(ull_records, t_hex.ul_records);
 }
 
-void v_dump_hex(FILE *h_file, int i_address) /* Display a file using intel hex starting at the specified address */
+#if defined(THREADS)
+typedef struct
+{
+   t_chunk t_chunk;
+   unsigned long ul_index; /* Number of the chunk using or waiting to use this slot */
+   char b_busy; /* Slot is in use */
+   char b_ready; /* Records have been formatted */
+} t_slot;
+
+t_slot a_slots[2 * JOBS_MAX]; /* Chunks being formatted or waiting to be written */
+int i_slots = 0;
+pthread_mutex_t t_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t t_changed = PTHREAD_COND_INITIALIZER;
+unsigned char *p_image; /* Memory mapped file */
+unsigned long ul_image; /* Size of file */
+unsigned long ul_chunk; /* Number of the next chunk to format */
+unsigned long ul_offset; /* Offset of the next chunk to format */
+
+void *p_worker(void *p_arg) /* Format chunks until there are none left */
 {
-   int i_count;
-   int i_bytes = 0; /* Number of bytes read from file into buffer */ 
-   int i_type = 0;
-   unsigned int i_checksum = 0;
+   unsigned long ul_index, ul_begin, ul_end;
+   t_slot *p_slot;
 
-   while ((i_bytes = fread(a_buffer, 1, BUFFER_SIZE, h_file)) > 0)
+   pthread_mutex_lock(&t_lock);
+   while (ul_offset < ul_image)
    {
-      printf(":%02X%04X%02X", i_bytes, i_address, i_type); /* Print record length, address and record type */
-      i_checksum = i_bytes + i_type + (i_address / 256) + (i_address % 256);
-      for (i_count = 0; i_count < i_bytes; i_count++)
+      ul_index = ul_chunk++;
+      ul_begin = ul_offset;
+      if ((ul_end = ul_boundary(ul_begin)) > ul_image) ul_end = ul_image;
+      ul_offset = ul_end;
+      p_slot = &a_slots[ul_index % i_slots];
+      while (p_slot->b_busy || p_slot->ul_index != ul_index) /* Wait for the writer to finish with the slot */
+         pthread_cond_wait(&t_changed, &t_lock);
+      p_slot->b_busy = true;
+      p_slot->b_ready = false;
+      pthread_mutex_unlock(&t_lock);
+
+      stats_stage(STATS_FORMAT);
+      v_hex_format(&t_hex, &p_slot->t_chunk, p_image + ul_begin, t_hex.ul_load + ul_begin, ul_end - ul_begin);
+      stats_stage(STATS_OTHER);
+
+      pthread_mutex_lock(&t_lock);
+      p_slot->b_ready = true;
+      pthread_cond_broadcast(&t_changed);
+   }
+   pthread_mutex_unlock(&t_lock);
+   return NULL;
+}
+
+int i_dump_parallel(t_input *p_input) /* Format a file using several threads, returns false if this isn't possible */
+{
+   pthread_t a_threads[JOBS_MAX];
+   unsigned long ul_chunks, ul_index;
+   int i_count, i_threads;
+   char b_okay = true;
+   t_slot *p_slot;
+
+   if (p_input->i_method != IO_MMAP || p_input->ul_size <= CHUNK_SIZE)
+      return false; /* Only worth doing for large files */
+   ul_image = p_input->ul_size;
+   p_image = (unsigned char *) p_input->s_image;
+   for (; i_slots < 2 * i_jobs; i_slots++) /* Allocate a buffer for each slot the first time */
+      if ((a_slots[i_slots].t_chunk.s_output = malloc(i_hex_capacity(&t_hex, CHUNK_SIZE + HEX_RECORD_MAX))) == NULL)
       {
-         printf("%02X", a_buffer[i_count] & 0xFF);  /* Print each byte */
-         i_checksum += a_buffer[i_count];
+         v_error("Cannot allocate memory: %s\n", s_reason(errno));
+         exit(-1);
       }
-      /* The checksum is the least significant byte of the the two's complement of the sum of all bytes values in the record */      
-      printf("%02X\n", (~(i_checksum & 0xFF) + 1) & 0xFF); /* Print the checksum byte */
-      i_address += i_bytes;
+   for (i_count = 0; i_count < i_slots; i_count++) /* Chunks use the slots in turn */
+   {
+      a_slots[i_count].ul_index = i_count;
+      a_slots[i_count].b_busy = false;
+   }
+   for (ul_chunks = 0, ul_offset = 0; ul_offset < ul_image; ul_chunks++)
+      ul_offset = ul_boundary(ul_offset);
+   ul_chunk = 0;
+   ul_offset = 0;
+   stats_stage(STATS_OTHER); /* Only the threads are formatting */
+   for (i_threads = 0; i_threads < i_jobs; i_threads++)
+      if (pthread_create(&a_threads[i_threads], NULL, p_worker, NULL)) break;
+   if (!i_threads) /* The writer can't also format, it would wait for itself to free a slot */
+   {
+      stats_stage(STATS_FORMAT);
+      return false;
+   }
+   stats_count(ull_in, ul_image); /* The threads use the mapped file directly */
+
+   for (ul_index = 0; ul_index < ul_chunks; ul_index++) /* Write the chunks in order */
+   {
+      p_slot = &a_slots[ul_index % i_slots];
+      pthread_mutex_lock(&t_lock);
+      while (!(p_slot->b_busy && p_slot->b_ready && p_slot->ul_index == ul_index))
+         pthread_cond_wait(&t_changed, &t_lock);
+      pthread_mutex_unlock(&t_lock);
+      if (b_okay) b_okay = i_write(&p_slot->t_chunk);
+      pthread_mutex_lock(&t_lock);
+      p_slot->b_busy = false;
+      p_slot->ul_index += i_slots; /* Next chunk to use the slot */
+      pthread_cond_broadcast(&t_changed);
+      pthread_mutex_unlock(&t_lock);
    }
-   /* Print the end of file record - this could be shortened (a lot) but I've left it like this to show how the checksum is calculated */
-   i_type = 1; /* EOF record type */
-   i_checksum = i_type; /* Address and record length are both zero */
-   printf(":%02X%04X%02X", 0, 0, i_type); /* Print record length, address and record type */
-   printf("%02X\n", (~(i_checksum & 0xFF) + 1) & 0xFF); 
+   for (i_count = 0; i_count < i_threads; i_count++)
+      pthread_join(a_threads[i_count], NULL);
+   return true;
 }
+#endif
 
+unsigned long long ull_hash(unsigned char *p_data, unsigned long ul_length) /* 64 bit FNV-1a hash */
+{
+   unsigned long long ull_value = 0xCBF29CE484222325ULL;
 
-int main(int argc, char **argv)
+   while (ul_length--)
+   {
+      ull_value ^= *p_data++;
+      ull_value *= 0x100000001B3ULL;
+   }
+   return ull_value;
+}
+
+char *s_settings(char *s_buffer) /* Describe the build and options that change the records written for a chunk */
 {
+   sprintf(s_buffer, "%s %s %d %d %lX %d %d %d %d", NAME, BUILD, t_hex.i_format, t_hex.i_size, t_hex.ul_load, t_hex.i_filler, t_hex.b_segment, t_hex.i_width, CHUNK_SIZE);
+   return s_buffer;
+}
+
+void v_read_sums(char *s_name) /* Read the list of chunk hashes written with the previous output file */
+{
+   char s_line[HEX_LINE], s_current[HEX_LINE];
    FILE *h_file;
+   t_entry t_entry;
+   int i_size = 0;
+
+   i_entries = i_entry = 0;
+   if ((h_file = fopen(s_name, "r")) == NULL) return;
+   if (fgets(s_line, sizeof(s_line), h_file) == NULL) *s_line = 0;
+   s_line[strcspn(s_line, "\n")] = 0; /* An empty first line is just an empty string */
+   if (!strcmp(s_line, s_settings(s_current))) /* Only use if the options have not changed */
+   {
+      while (fscanf(h_file, "%lu %lu %llX %lu %lu %ld %ld %lu", &t_entry.ul_offset, &t_entry.ul_length, &t_entry.ull_hash,
+         &t_entry.ul_text, &t_entry.ul_size, &t_entry.l_first, &t_entry.l_last, &t_entry.ul_records) == 8)
+      {
+         if (i_entries >= i_size && (a_entries = realloc(a_entries, (i_size = 2 * i_size + 64) * sizeof(t_entry))) == NULL)
+         {
+            v_error("Cannot allocate memory: %s\n", s_reason(errno));
+            exit(-1);
+         }
+         a_entries[i_entries++] = t_entry;
+      }
+   }
+   fclose(h_file);
+}
+
+int i_reuse(t_chunk *p_chunk, unsigned long ul_offset, unsigned long ul_length, unsigned long long ull_value) /* Copy the records for an unchanged chunk from the previous output file */
+{
+   t_entry *p_entry;
+   const char *p_text;
+
+   if (p_previous == NULL) return false;
+   while (i_entry < i_entries && a_entries[i_entry].ul_offset < ul_offset) i_entry++; /* Chunks are in order */
+   if (i_entry >= i_entries) return false;
+   p_entry = &a_entries[i_entry];
+   if (p_entry->ul_offset != ul_offset || p_entry->ul_length != ul_length || p_entry->ull_hash != ull_value ||
+      p_entry->ul_size > i_hex_capacity(&t_hex, CHUNK_SIZE + HEX_RECORD_MAX))
+      return false;
+   if (i_fetch(p_previous, p_entry->ul_text, p_entry->ul_size, &p_text) != p_entry->ul_size)
+      return false;
+   if (p_entry->ul_size > 0) memcpy(p_chunk->s_output, p_text, p_entry->ul_size); /* Nothing is fetched for an empty chunk */
+   p_chunk->i_output = p_entry->ul_size;
+   p_chunk->l_first = p_entry->l_first;
+   p_chunk->l_last = p_entry->l_last;
+   p_chunk->ul_records = p_entry->ul_records;
+   p_chunk->ul_error = 0;
+   return true;
+}
+
+void v_dump_hex(t_input *p_input, char *s_name) /* Display a file using intel hex or 'S' records starting at the load address */
+{
+   unsigned long ul_offset = 0; /* Offset of the current chunk */
+   unsigned long ul_end; /* Offset of the end of the current chunk */
+   size_t i_block; /* Number of bytes read */
+   const char *p_data; /* Bytes in the chunk */
+   unsigned long long ull_value = 0; /* Hash of the bytes in the chunk */
+#if defined(SEEK_DATA)
+   char b_sparse = (t_hex.i_filler == 0); /* Look for holes in sparse files */
+   off_t t_data, t_hole;
+#endif
+
+   v_begin(p_input, s_name);
+   stats_stage(STATS_FORMAT);
+#if defined(THREADS)
+   if (i_jobs > 1 && h_sums == NULL && i_dump_parallel(p_input))
+   {
+      v_end(ul_image);
+      return;
+   }
+#endif
+   if (t_records.s_output == NULL) /* Allocate the buffer the first time */
+   {
+      if ((t_records.s_output = malloc(i_hex_capacity(&t_hex, CHUNK_SIZE + HEX_RECORD_MAX))) == NULL)
+      {
+         v_error("Cannot allocate memory: %s\n", s_reason(errno));
+         exit(-1);
+      }
+   }
+   for (;;)
+   {
+      ul_end = ul_boundary(ul_offset);
+#if defined(SEEK_DATA)
+      if (b_sparse) /* Skip over any hole, which reads as zeros, and stop reading at the next one */
+      {
+         if ((t_data = lseek(p_input->h_file, ul_offset, SEEK_DATA)) < 0)
+         {
+            if (errno == ENXIO) break; /* Only a hole left */
+            b_sparse = false; /* Not supported */
+         }
+         else
+         {
+            if ((unsigned long) t_data > ul_offset + t_hex.i_size)
+            {
+               ul_offset = ul_hex_align(&t_hex, t_hex.ul_load + t_data) - t_hex.ul_load;
+               ul_end = ul_boundary(ul_offset);
+            }
+            if ((t_hole = lseek(p_input->h_file, t_data, SEEK_HOLE)) > 0)
+            {
+               t_hole = ul_hex_align(&t_hex, t_hex.ul_load + t_hole) - t_hex.ul_load;
+               if ((unsigned long) t_hole > ul_offset && (unsigned long) t_hole < ul_end) ul_end = t_hole;
+            }
+         }
+      }
+#endif
+      if ((i_block = i_fetch(p_input, ul_offset, ul_end - ul_offset, &p_data)) == 0) break; /* Mapped files are not copied */
+      if (h_sums == NULL) /* Format the records */
+         v_hex_format(&t_hex, &t_records, (const unsigned char *) p_data, t_hex.ul_load + ul_offset, i_block);
+      else /* Only format the records if the chunk has changed */
+      {
+         ull_value = ull_hash((unsigned char *) p_data, i_block);
+         if (!i_reuse(&t_records, ul_offset, i_block, ull_value))
+            v_hex_format(&t_hex, &t_records, (const unsigned char *) p_data, t_hex.ul_load + ul_offset, i_block);
+      }
+      if (!i_write(&t_records))
+      {
+         if (h_sums != NULL) fclose(h_sums);
+         h_sums = NULL; /* Don't keep the hashes for a failed file */
+         break;
+      }
+      if (h_sums != NULL)
+         fprintf(h_sums, "%lu %lu %016llX %lu %lu %ld %ld %lu\n", ul_offset, (unsigned long) i_block, ull_value,
+            ul_text, (unsigned long) t_records.i_output, t_records.l_first, t_records.l_last, t_records.ul_records);
+      ul_offset += i_block;
+      if (ul_offset < ul_end) break; /* End of file */
+   }
+   v_end(ul_offset);
+}
+
+
+void v_delta(t_input *p_input, char *s_name) /* Write a file to a '.hex' file reusing the records for unchanged chunks */
+{
+   char *s_output, *s_sums, *s_temp, *s_new, *s_type;
+   size_t i_length = strlen(s_name) + 16;
+   char s_line[HEX_LINE];
+   int b_sums;
+
+   s_output = malloc(i_length);
+   s_sums = malloc(i_length);
+   s_temp = malloc(i_length);
+   s_new = malloc(i_length);
+   if (s_output == NULL || s_sums == NULL || s_temp == NULL || s_new == NULL)
+   {
+      v_error("Cannot allocate memory: %s\n", s_reason(errno));
+      exit(-1);
+   }
+   strcpy(s_output, s_name);
+   if ((s_type = strrchr(s_output, '.')) == NULL || strchr(s_type, '/') != NULL) s_type = s_output + strlen(s_output);
+   strcpy(s_type, (t_hex.i_format == HEX_SOURCE) ? ".c" : (t_hex.i_format == HEX_MOTOROLA) ? ".srec" : ".hex"); /* Substitute the new file type */
+   sprintf(s_sums, "%s.sum", s_output);
+   sprintf(s_temp, "%s.tmp", s_output);
+   sprintf(s_new, "%s.tmp", s_sums); /* Write the new hashes to a temporary file too */
+   if (!strcmp(s_output, s_name))
+      v_error("Cannot write %s: Would overwrite the input file\n", s_output);
+   else if (!i_create(&t_file, s_temp, true))
+      v_error("Cannot open %s: %s\n", s_temp, s_reason(errno));
+   else
+   {
+      p_output = &t_file;
+      t_hex.i_width = i_address_size(p_input);
+      if (i_open(&t_previous, s_output, true))
+      {
+         p_previous = &t_previous;
+         v_read_sums(s_sums);
+      }
+      if ((h_sums = fopen(s_new, "w")) != NULL) fprintf(h_sums, "%s\n", s_settings(s_line));
+      v_dump_hex(p_input, s_name);
+      if (p_previous != NULL) v_close(p_previous);
+      p_previous = NULL;
+      b_sums = (h_sums != NULL && !fclose(h_sums)); /* Not set if the hashes could not be written */
+      h_sums = NULL;
+      if (!i_finish(&t_file) || (remove(s_sums) && errno != ENOENT) || rename(s_temp, s_output)) /* Old hashes never describe new records */
+      {
+         v_error("Cannot write %s: %s\n", s_output, s_reason(errno));
+         remove(s_temp);
+         b_sums = false;
+      }
+      p_output = &t_stdout;
+      if (!b_sums || rename(s_new, s_sums)) remove(s_new); /* Only keep hashes for the records that were written */
+   }
+   free(s_output);
+   free(s_sums);
+   free(s_temp);
+   free(s_new);
+}
+
+int main(int argc, char **argv)
+{
+   t_input t_input;
+   t_batch t_batch;
+   long l_size = 0, l_jobs = 1; /* Checked before they are narrowed */
    int i_count, i_index;
 
+   v_hex_encoder(&t_hex, NULL, 0, v_output, NULL); /* Chunks are formatted here, so no buffer is needed */
+
 #if defined(VMS) || defined(MSDOS) || defined (WIN32) /* Parse DEC/Microsoft style command line options */
    for (i_count = 1; i_count < argc; i_count++) 
    {
       if (argv[i_count][0] == '/')
       {
-         for (i_index = 0; argv[i_count][i_index]; i_index++) /* Convert option to uppercase */
+         for (i_index = 0; argv[i_count][i_index] && argv[i_count][i_index] != '='; i_index++) /* Convert option to uppercase */
             if (argv[i_count][i_index] >= 'a' && argv[i_count][i_index] <= 'z')
                argv[i_count][i_index] = argv[i_count][i_index] - 32;
          if (!strncmp(argv[i_count], "/VERSION", i_index))
             v_version(); /* Display version information */
+         else if (!strncmp(argv[i_count], "/ADDRESS", i_index))
+            t_hex.ul_load = l_number(argv[i_count][i_index] ? argv[i_count] + i_index + 1 : NULL, "/ADDRESS");
+         else if (!strncmp(argv[i_count], "/DELTA", i_index))
+            b_delta = true;
+         else if (!strncmp(argv[i_count], "/FILL", i_index))
+            t_hex.i_filler = i_byte(argv[i_count][i_index] ? argv[i_count] + i_index + 1 : NULL, "/FILL");
+         else if (!strncmp(argv[i_count], "/INCLUDE", i_index))
+            t_hex.i_format = HEX_SOURCE;
+         else if (!strncmp(argv[i_count], "/JOBS", i_index))
+            l_jobs = l_number(argv[i_count][i_index] ? argv[i_count] + i_index + 1 : NULL, "/JOBS");
+         else if (!strncmp(argv[i_count], "/MOTOROLA", i_index))
+            t_hex.i_format = HEX_MOTOROLA;
+         else if (!strncmp(argv[i_count], "/RECORD_SIZE", i_index))
+            l_size = l_number(argv[i_count][i_index] ? argv[i_count] + i_index + 1 : NULL, "/RECORD_SIZE");
+         else if (!strncmp(argv[i_count], "/SEGMENT", i_index))
+         {
+            if (strlen(argv[i_count]) < 3) /* Check option is not ambigious */
+            {
+               v_error("option '%s' is ambiguous; please specify '/SEGMENT' or '/START'.\n", argv[i_count]);
+               exit(-1);
+            }
+            t_hex.b_segment = true;
+         }
+         else if (!strncmp(argv[i_count], "/START", i_index))
+         {
+            t_hex.ul_start = l_number(argv[i_count][i_index] ? argv[i_count] + i_index + 1 : NULL, "/START");
+            t_hex.b_start = true;
+         }
+         else if (!strncmp(argv[i_count], "/STATISTICS", i_index))
+            v_stats(false, "records");
          else if (!strncmp(argv[i_count], "/HELP", i_index))
             v_about();
          else if (!strncmp(argv[i_count], "/?", i_index))
@@ -182,6 +646,24 @@ int main(int argc, char **argv)
          {
             switch (argv[i_count][i_index])
             {
+            case 'a': /* Load address */
+               t_hex.ul_load = l_number(s_value(&argc, argv, i_count), "-a"); break;
+            case 'd': /* Write output files reusing unchanged records */
+               b_delta = true; break;
+            case 'f': /* Fill byte */
+               t_hex.i_filler = i_byte(s_value(&argc, argv, i_count), "-f"); break;
+            case 'i': /* Write a C array */
+               t_hex.i_format = HEX_SOURCE; break;
+            case 'j': /* Number of threads */
+               l_jobs = l_number(s_value(&argc, argv, i_count), "-j"); break;
+            case 'r': /* Record size */
+               l_size = l_number(s_value(&argc, argv, i_count), "-r"); break;
+            case 's': /* Write Motorola 'S' records */
+               t_hex.i_format = HEX_MOTOROLA; break;
+            case 't': /* Start address */
+               t_hex.ul_start = l_number(s_value(&argc, argv, i_count), "-t"); t_hex.b_start = true; break;
+            case 'x': /* Use extended segment addresses */
+               t_hex.b_segment = true; break;
             case '?': /* Display help */
                v_about();
             case '-': /* '--' terminates command line processing */
@@ -191,6 +673,38 @@ int main(int argc, char **argv)
                else
                   if (!strncmp(argv[i_count], "--version", i_index))
                      v_version(); /* Display version information */
+                  else if (!strncmp(argv[i_count], "--address", i_index))
+                     t_hex.ul_load = l_number(s_value(&argc, argv, i_count), "--address");
+                  else if (!strncmp(argv[i_count], "--delta", i_index))
+                     b_delta = true;
+                  else if (!strncmp(argv[i_count], "--fill", i_index))
+                     t_hex.i_filler = i_byte(s_value(&argc, argv, i_count), "--fill");
+                  else if (!strncmp(argv[i_count], "--include", i_index))
+                     t_hex.i_format = HEX_SOURCE;
+                  else if (!strncmp(argv[i_count], "--jobs", i_index))
+                     l_jobs = l_number(s_value(&argc, argv, i_count), "--jobs");
+                  else if (!strncmp(argv[i_count], "--motorola", i_index))
+                     t_hex.i_format = HEX_MOTOROLA;
+                  else if (!strncmp(argv[i_count], "--record-size", i_index))
+                     l_size = l_number(s_value(&argc, argv, i_count), "--record-size");
+                  else if (!strncmp(argv[i_count], "--segment", i_index))
+                  {
+                     if (i_index < 4) /* Check option is not ambigious */
+                     {
+                        v_error("option '%s' is ambiguous; please specify '--segment' or '--start'.\n", argv[i_count]);
+                        exit(-1);
+                     }
+                     t_hex.b_segment = true;
+                  }
+                  else if (!strncmp(argv[i_count], "--start", i_index))
+                  {
+                     t_hex.ul_start = l_number(s_value(&argc, argv, i_count), "--start");
+                     t_hex.b_start = true;
+                  }
+                  else if (!strncmp(argv[i_count], "--stats", i_index))
+                     v_stats(false, "records");
+                  else if (!strncmp(argv[i_count], "--stats-json", i_index))
+                     v_stats(true, "records");
                   else if (!strncmp(argv[i_count], "--help", i_index))
                      v_about();
                   else
@@ -214,26 +728,53 @@ int main(int argc, char **argv)
    }
 #endif
 
+   if (l_size == 0) l_size = (t_hex.i_format == HEX_SOURCE) ? SOURCE_SIZE : HEX_SIZE;
+   if (t_hex.i_format == HEX_SOURCE) t_hex.i_filler = -1; /* Every byte must be in the array */
+   if (l_size < 1 || l_size > HEX_RECORD_MAX)
+   {
+      v_error("invalid record size %ld, must be between 1 and %d\n", l_size, HEX_RECORD_MAX);
+      exit(-1);
+   }
+   if (t_hex.i_format == HEX_MOTOROLA && l_size > HEX_MOTOROLA_MAX)
+   {
+      v_error("invalid record size %ld, must be between 1 and %d for 'S' records\n", l_size, HEX_MOTOROLA_MAX);
+      exit(-1);
+   }
+   t_hex.i_size = l_size;
+   if (l_jobs < 1 || l_jobs > JOBS_MAX)
+   {
+      v_error("invalid number of jobs %ld, must be between 1 and %d\n", l_jobs, JOBS_MAX);
+      exit(-1);
+   }
+   i_jobs = l_jobs;
+   if (t_hex.b_start && t_hex.ul_start > (t_hex.b_segment ? 0xFFFFFUL : 0xFFFFFFFFUL)) /* Must fit in CS:IP or 32 bits */
+   {
+      v_error("invalid start address %lX, must be between 0 and %lX\n", t_hex.ul_start, t_hex.b_segment ? 0xFFFFFUL : 0xFFFFFFFFUL);
+      exit(-1);
+   }
+
+   v_batch(&t_batch, argv + 1, argc - 1, true); /* Open and read the files ahead */
    for (i_count = 1; i_count < argc; i_count++) /* Dump files */
    {
-      if (!i_isdir(argv[i_count])) /* Check that input files isn't a directory! */
+      if (i_batch_open(&t_batch, &t_input))
       {
-         if ((h_file = fopen(argv[i_count], "rb")) != NULL) 
-         {
-            v_dump_hex(h_file, 0x0100);
-            fclose(h_file);
-         }
+         if (b_delta)
+            v_delta(&t_input, argv[i_count]);
          else
-         {
-#if defined(VMS) /* Use VAX-C extension (avoids potential ACCVIO) */
-            v_error("Cannot open %s: %s\n", argv[i_count], strerror(errno, vaxc$errno)); 
-#else
-            v_error("Cannot open %s: %s\n", argv[i_count], strerror(errno));
-#endif
-         }
+            v_dump_hex(&t_input, argv[i_count]);
+         if (t_input.i_error) v_error("Cannot read %s: %s\n", argv[i_count], s_reason(t_input.i_error));
+         v_close(&t_input);
       }
+      else if (errno == EISDIR) /* Check that input files isn't a directory! */
+         v_error("Cannot open %s: Can't read from a directory\n", argv[i_count]);
       else
-         v_error("Cannot open %s: Can't read from a directory\n", argv[i_count], argv[i_count]);
+         v_error("Cannot open %s: %s\n", argv[i_count], s_reason(errno));
+   }
+   v_batch_close(&t_batch);
+   if (!i_flush(&t_stdout))
+   {
+      v_error("Cannot write standard output: %s\n", s_reason(errno));
+      exit(-1);
    }
-   exit (0);
+   exit (i_errors ? 1 : 0);
 }